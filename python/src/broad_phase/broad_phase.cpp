@@ -157,6 +157,49 @@ void define_broad_phase(py::module_& m)
             R"ipc_Qu8mg5v7(
             Build the broad phase for continuous collision detection.
 
+            Parameters:
+                vertices_t0: Starting vertices of the vertices.
+                vertices_t1: Ending vertices of the vertices.
+                edges: Collision mesh edges
+                faces: Collision mesh faces
+                inflation_radius: Radius of inflation around all elements.
+            )ipc_Qu8mg5v7",
+            "vertices_t0"_a, "vertices_t1"_a, "edges"_a, "faces"_a,
+            "inflation_radius"_a = 0)
+        .def(
+            "update",
+            py::overload_cast<
+                Eigen::ConstRef<Eigen::MatrixXd>,
+                Eigen::ConstRef<Eigen::MatrixXi>,
+                Eigen::ConstRef<Eigen::MatrixXi>, const double>(
+                &BroadPhase::update),
+            R"ipc_Qu8mg5v7(
+            Update the broad phase for static collision detection.
+
+            Note:
+                The default implementation rebuilds from scratch. Methods with acceleration structures may reuse them if the connectivity is unchanged.
+
+            Parameters:
+                vertices: Vertex positions
+                edges: Collision mesh edges
+                faces: Collision mesh faces
+                inflation_radius: Radius of inflation around all elements.
+            )ipc_Qu8mg5v7",
+            "vertices"_a, "edges"_a, "faces"_a, "inflation_radius"_a = 0)
+        .def(
+            "update",
+            py::overload_cast<
+                Eigen::ConstRef<Eigen::MatrixXd>,
+                Eigen::ConstRef<Eigen::MatrixXd>,
+                Eigen::ConstRef<Eigen::MatrixXi>,
+                Eigen::ConstRef<Eigen::MatrixXi>, const double>(
+                &BroadPhase::update),
+            R"ipc_Qu8mg5v7(
+            Update the broad phase for continuous collision detection.
+
+            Note:
+                The default implementation rebuilds from scratch. Methods with acceleration structures may reuse them if the connectivity is unchanged.
+
             Parameters:
                 vertices_t0: Starting vertices of the vertices.
                 vertices_t1: Ending vertices of the vertices.
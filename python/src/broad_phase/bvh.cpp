@@ -6,5 +6,9 @@ using namespace ipc;
 
 void define_bvh(py::module_& m)
 {
-    py::class_<BVH, BroadPhase, std::shared_ptr<BVH>>(m, "BVH").def(py::init());
+    py::class_<BVH, BroadPhase, std::shared_ptr<BVH>>(m, "BVH")
+        .def(py::init())
+        .def_readwrite(
+            "max_refit_cost_growth", &BVH::max_refit_cost_growth,
+            "Maximum relative growth of a tree's surface area heuristic (SAH) cost before update() rebuilds it instead of refitting it.");
 }
@@ -77,15 +77,18 @@ void define_spatial_hash(py::module_& m)
         .def_readwrite("edge_start_ind", &SpatialHash::edge_start_ind)
         .def_readwrite("tri_start_ind", &SpatialHash::tri_start_ind)
         .def_readwrite(
-            "voxel_to_primitives", &SpatialHash::voxel_to_primitives,
-            "Map from voxel index to the primitive indices it contains.")
+            "occupied_voxels", &SpatialHash::occupied_voxels,
+            "Sorted indices of the voxels occupied by at least one primitive.")
         .def_readwrite(
-            "point_to_voxels", &SpatialHash::point_to_voxels,
-            "Map from point index to the voxel indices it occupies.")
+            "voxel_primitives_offsets", &SpatialHash::voxel_primitives_offsets,
+            "Start of each occupied voxel's primitives in voxel_primitives.")
         .def_readwrite(
-            "edge_to_voxels", &SpatialHash::edge_to_voxels,
-            "Map from edge index to the voxel indices it occupies.")
+            "voxel_primitives", &SpatialHash::voxel_primitives,
+            "Primitive indices contained in each occupied voxel (sorted per voxel).")
         .def_readwrite(
-            "face_to_voxels", &SpatialHash::face_to_voxels,
-            "Map from face index to the voxel indices it occupies.");
+            "primitive_voxels_offsets", &SpatialHash::primitive_voxels_offsets,
+            "Start of each primitive's voxels in primitive_voxels.")
+        .def_readwrite(
+            "primitive_voxels", &SpatialHash::primitive_voxels,
+            "Occupied voxels (as indices into occupied_voxels) of each primitive.");
 }
@@ -129,6 +129,12 @@ void define_candidates(py::module_& m)
         .def(
             "save_obj", &Candidates::save_obj, "filename"_a, "vertices"_a,
             "edges"_a, "faces"_a)
+        .def_property(
+            "safety_margin", &Candidates::safety_margin,
+            &Candidates::set_safety_margin,
+            "Safety margin added to the inflation radius when building. If "
+            "positive, the candidates are reused while no vertex moved more "
+            "than the remaining margin.")
         .def_readwrite("vv_candidates", &Candidates::vv_candidates)
         .def_readwrite("ev_candidates", &Candidates::ev_candidates)
         .def_readwrite("ee_candidates", &Candidates::ee_candidates)
@@ -172,5 +172,31 @@ void define_narrow_phase_ccd(py::module_& m)
             },
             "ea0_t0"_a, "ea1_t0"_a, "eb0_t0"_a, "eb1_t0"_a, "ea0_t1"_a,
             "ea1_t1"_a, "eb0_t1"_a, "eb1_t1"_a, "min_distance"_a = 0.0,
+            "tmax"_a = 1.0)
+        .def(
+            "batch_edge_edge_ccd",
+            [](const NarrowPhaseCCD& self,
+               Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+               Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+               const double min_distance = 0.0, const double tmax = 1.0) {
+                double toi;
+                bool r = self.batch_edge_edge_ccd(
+                    vertices_t0, vertices_t1, toi, min_distance, tmax);
+                return std::make_tuple(r, toi);
+            },
+            "vertices_t0"_a, "vertices_t1"_a, "min_distance"_a = 0.0,
+            "tmax"_a = 1.0)
+        .def(
+            "batch_point_triangle_ccd",
+            [](const NarrowPhaseCCD& self,
+               Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+               Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+               const double min_distance = 0.0, const double tmax = 1.0) {
+                double toi;
+                bool r = self.batch_point_triangle_ccd(
+                    vertices_t0, vertices_t1, toi, min_distance, tmax);
+                return std::make_tuple(r, toi);
+            },
+            "vertices_t0"_a, "vertices_t1"_a, "min_distance"_a = 0.0,
             "tmax"_a = 1.0);
 }
@@ -158,7 +158,25 @@ void define_tight_inclusion_ccd(py::module_& m)
         "min_corner"_a, "max_corner"_a, "is_vertex_face"_a,
         "using_minimum_separation"_a);
 
-    py::class_<TightInclusionCCD, NarrowPhaseCCD>(m, "TightInclusionCCD")
+    py::class_<TightInclusionCCD, NarrowPhaseCCD> m_ccd(
+        m, "TightInclusionCCD");
+
+    py::class_<TightInclusionCCD::PrefilterStatistics>(
+        m_ccd, "PrefilterStatistics")
+        .def(py::init<>())
+        .def_readwrite(
+            "num_queries", &TightInclusionCCD::PrefilterStatistics::num_queries,
+            "Number of queries checked by the prefilter.")
+        .def_readwrite(
+            "num_rejected",
+            &TightInclusionCCD::PrefilterStatistics::num_rejected,
+            "Number of queries rejected without running the root finder.")
+        .def(
+            "rejection_rate",
+            &TightInclusionCCD::PrefilterStatistics::rejection_rate,
+            "Fraction of the checked queries that were rejected.");
+
+    m_ccd
         .def(
             py::init<const double, const long, const double>(),
             R"ipc_Qu8mg5v7(
@@ -199,5 +217,15 @@ a minimum separation.
         .def_readwrite(
             "conservative_rescaling",
             &TightInclusionCCD::conservative_rescaling,
-            "Conservative rescaling of the time of impact.");
+            "Conservative rescaling of the time of impact.")
+        .def_readwrite(
+            "use_prefilter", &TightInclusionCCD::use_prefilter,
+            "Reject queries whose distance cannot close within tmax before running the root finder.")
+        .def(
+            "prefilter_statistics", &TightInclusionCCD::prefilter_statistics,
+            "Get the counters of the linear-bound prefilter.")
+        .def(
+            "reset_prefilter_statistics",
+            &TightInclusionCCD::reset_prefilter_statistics,
+            "Reset the counters of the linear-bound prefilter.");
 }
@@ -4,6 +4,7 @@
 
 void define_normal_collision(py::module_& m);
 void define_normal_collisions(py::module_& m);
+void define_packed_normal_collisions(py::module_& m);
 void define_edge_edge_normal_collision(py::module_& m);
 void define_edge_vertex_normal_collision(py::module_& m);
 void define_face_vertex_normal_collision(py::module_& m);
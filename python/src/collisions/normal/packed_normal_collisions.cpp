@@ -0,0 +1,52 @@
+#include <common.hpp>
+
+#include <ipc/collisions/normal/packed_normal_collisions.hpp>
+
+using namespace ipc;
+
+void define_packed_normal_collisions(py::module_& m)
+{
+    py::class_<PackedNormalCollisions>(m, "PackedNormalCollisions")
+        .def(py::init())
+        .def(
+            py::init<const NormalCollisions&, const CollisionMesh&>(),
+            R"ipc_Qu8mg5v7(
+            Construct a packed copy of a set of collisions.
+
+            Parameters:
+                collisions: The collisions to pack.
+                mesh: The collision mesh.
+            )ipc_Qu8mg5v7",
+            "collisions"_a, "mesh"_a)
+        .def(
+            "build", &PackedNormalCollisions::build,
+            R"ipc_Qu8mg5v7(
+            Pack a set of collisions.
+
+            Parameters:
+                collisions: The collisions to pack.
+                mesh: The collision mesh.
+            )ipc_Qu8mg5v7",
+            "collisions"_a, "mesh"_a)
+        .def(
+            "__len__", &PackedNormalCollisions::size,
+            "Get the number of collisions.")
+        .def(
+            "empty", &PackedNormalCollisions::empty,
+            "Get if the set of collisions is empty.")
+        .def(
+            "clear", &PackedNormalCollisions::clear,
+            "Clear the set of collisions.")
+        .def(
+            "vertex_ids", &PackedNormalCollisions::vertex_ids,
+            R"ipc_Qu8mg5v7(
+            Get the vertex ids of the i-th collision.
+
+            Note:
+                The ids past the collision's number of vertices are -1.
+            )ipc_Qu8mg5v7",
+            "i"_a)
+        .def(
+            "num_vertices", &PackedNormalCollisions::num_vertices,
+            "Get the number of vertices of the i-th collision.", "i"_a);
+}
@@ -15,5 +15,7 @@ void define_edge_vertex_tangential_collision(py::module_& m)
                 const EdgeVertexNormalCollision&, Eigen::ConstRef<VectorMax12d>,
                 const NormalPotential&, const double>(),
             "collision"_a, "positions"_a, "normal_potential"_a,
-            "normal_stiffness"_a);
+            "normal_stiffness"_a)
+        .def_readwrite(
+            "dtype", &EdgeVertexTangentialCollision::dtype, "Cached distance type.");
 }
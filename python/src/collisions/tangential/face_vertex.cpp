@@ -15,5 +15,7 @@ void define_face_vertex_tangential_collision(py::module_& m)
                 const FaceVertexNormalCollision&, Eigen::ConstRef<VectorMax12d>,
                 const NormalPotential&, const double>(),
             "collision"_a, "positions"_a, "normal_potential"_a,
-            "normal_stiffness"_a);
+            "normal_stiffness"_a)
+        .def_readwrite(
+            "dtype", &FaceVertexTangentialCollision::dtype, "Cached distance type.");
 }
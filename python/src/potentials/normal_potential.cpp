@@ -12,6 +12,62 @@ void define_normal_potential(py::module_& m)
     define_potential_methods<NormalCollisions>(normal_potential);
 
     normal_potential
+        .def(
+            "__call__",
+            py::overload_cast<
+                const PackedNormalCollisions&, const CollisionMesh&,
+                Eigen::ConstRef<Eigen::MatrixXd>>(
+                &NormalPotential::operator(), py::const_),
+            R"ipc_Qu8mg5v7(
+            Compute the potential for a packed set of collisions.
+
+            Parameters:
+                collisions: The packed set of collisions.
+                mesh: The collision mesh.
+                X: Degrees of freedom of the collision mesh (e.g., vertices or velocities).
+
+            Returns:
+                The potential for a set of collisions.
+            )ipc_Qu8mg5v7",
+            "collisions"_a, "mesh"_a, "X"_a)
+        .def(
+            "gradient",
+            py::overload_cast<
+                const PackedNormalCollisions&, const CollisionMesh&,
+                Eigen::ConstRef<Eigen::MatrixXd>>(
+                &NormalPotential::gradient, py::const_),
+            R"ipc_Qu8mg5v7(
+            Compute the gradient of the potential for a packed set of collisions.
+
+            Parameters:
+                collisions: The packed set of collisions.
+                mesh: The collision mesh.
+                X: Degrees of freedom of the collision mesh (e.g., vertices or velocities).
+
+            Returns:
+                The gradient of the potential w.r.t. X. This will have a size of |X|.
+            )ipc_Qu8mg5v7",
+            "collisions"_a, "mesh"_a, "X"_a)
+        .def(
+            "hessian",
+            py::overload_cast<
+                const PackedNormalCollisions&, const CollisionMesh&,
+                Eigen::ConstRef<Eigen::MatrixXd>, const PSDProjectionMethod>(
+                &NormalPotential::hessian, py::const_),
+            R"ipc_Qu8mg5v7(
+            Compute the hessian of the potential for a packed set of collisions.
+
+            Parameters:
+                collisions: The packed set of collisions.
+                mesh: The collision mesh.
+                X: Degrees of freedom of the collision mesh (e.g., vertices or velocities).
+                project_hessian_to_psd: Make sure the hessian is positive semi-definite.
+
+            Returns:
+                The Hessian of the potential w.r.t. X. This will have a size of |X|×|X|.
+            )ipc_Qu8mg5v7",
+            "collisions"_a, "mesh"_a, "X"_a,
+            "project_hessian_to_psd"_a = PSDProjectionMethod::NONE)
         .def(
             "shape_derivative",
             py::overload_cast<
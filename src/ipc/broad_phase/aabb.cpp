@@ -3,6 +3,7 @@
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
 
+#include <algorithm>
 #include <cfenv>
 
 namespace ipc {
@@ -136,4 +137,260 @@ void build_face_boxes(
         });
 }
 
-} // namespace ipc
\ No newline at end of file
+// ============================================================================
+
+void AABBs::resize(const size_t n, const int dim)
+{
+    assert(n == 0 || dim == 2 || dim == 3);
+    m_dim = dim;
+    for (int d = 0; d < 3; d++) {
+        min[d].resize(d < dim ? n : 0);
+        max[d].resize(d < dim ? n : 0);
+    }
+    vertex_ids.resize(n);
+}
+
+void AABBs::clear()
+{
+    for (int d = 0; d < 3; d++) {
+        min[d].clear();
+        max[d].clear();
+    }
+    vertex_ids.clear();
+}
+
+void AABBs::set(
+    const size_t i,
+    Eigen::ConstRef<ArrayMax3d> _min,
+    Eigen::ConstRef<ArrayMax3d> _max)
+{
+    assert(_min.size() == dim() && _max.size() == dim());
+    assert((_min <= _max).all());
+    for (int d = 0; d < dim(); d++) {
+        min[d][i] = _min[d];
+        max[d][i] = _max[d];
+    }
+}
+
+ArrayMax3d AABBs::min_corner(const size_t i) const
+{
+    ArrayMax3d corner(dim());
+    for (int d = 0; d < dim(); d++) {
+        corner[d] = min[d][i];
+    }
+    return corner;
+}
+
+ArrayMax3d AABBs::max_corner(const size_t i) const
+{
+    ArrayMax3d corner(dim());
+    for (int d = 0; d < dim(); d++) {
+        corner[d] = max[d][i];
+    }
+    return corner;
+}
+
+AABB AABBs::operator[](const size_t i) const
+{
+    AABB box(min_corner(i), max_corner(i));
+    box.vertex_ids = vertex_ids[i];
+    return box;
+}
+
+void AABBs::intersect_range(
+    const AABBs& other,
+    const size_t i,
+    const size_t begin,
+    const size_t end,
+    std::vector<size_t>& hits) const
+{
+    assert(dim() == other.dim());
+    assert(begin <= end && end <= size());
+    if (dim() == 2) {
+        intersect_range<2>(other, i, begin, end, hits);
+    } else {
+        intersect_range<3>(other, i, begin, end, hits);
+    }
+}
+
+template <int dim>
+void AABBs::intersect_range(
+    const AABBs& other,
+    const size_t i,
+    const size_t begin,
+    const size_t end,
+    std::vector<size_t>& hits) const
+{
+    // Test a block of boxes without branching so the loop vectorizes, then
+    // compact the hits.
+    constexpr size_t BLOCK_SIZE = 64;
+    std::array<uint8_t, BLOCK_SIZE> mask;
+
+    std::array<double, dim> query_min, query_max;
+    for (int d = 0; d < dim; d++) {
+        query_min[d] = other.min[d][i];
+        query_max[d] = other.max[d][i];
+    }
+
+    for (size_t b = begin; b < end; b += BLOCK_SIZE) {
+        const size_t n = std::min(BLOCK_SIZE, end - b);
+
+        std::fill_n(mask.begin(), n, uint8_t(1));
+        for (int d = 0; d < dim; d++) {
+            const double* const box_min = min[d].data() + b;
+            const double* const box_max = max[d].data() + b;
+            const double q_min = query_min[d], q_max = query_max[d];
+            for (size_t k = 0; k < n; k++) {
+                mask[k] &= uint8_t(box_min[k] <= q_max)
+                    & uint8_t(q_min <= box_max[k]);
+            }
+        }
+
+        for (size_t k = 0; k < n; k++) {
+            if (mask[k]) {
+                hits.push_back(b + k);
+            }
+        }
+    }
+}
+
+namespace {
+    /// @brief Conservatively inflate packed box coordinates.
+    /// @note The rounding mode is changed once for the whole range instead of once per box.
+    void conservative_inflation(
+        double* min, double* max, const size_t n, const double inflation_radius)
+    {
+#pragma STDC FENV_ACCESS ON
+        const int current_round = std::fegetround();
+
+        std::fesetround(FE_DOWNWARD);
+        for (size_t i = 0; i < n; i++) {
+            min[i] -= inflation_radius;
+        }
+
+        std::fesetround(FE_UPWARD);
+        for (size_t i = 0; i < n; i++) {
+            max[i] += inflation_radius;
+        }
+
+        std::fesetround(current_round);
+    }
+} // namespace
+
+void build_vertex_boxes(
+    Eigen::ConstRef<Eigen::MatrixXd> vertices,
+    AABBs& vertex_boxes,
+    const double inflation_radius)
+{
+    const int dim = vertices.cols();
+    vertex_boxes.resize(vertices.rows(), dim);
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, vertices.rows()),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (int d = 0; d < dim; d++) {
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    vertex_boxes.min[d][i] = vertices(i, d);
+                    vertex_boxes.max[d][i] = vertices(i, d);
+                }
+                conservative_inflation(
+                    vertex_boxes.min[d].data() + r.begin(),
+                    vertex_boxes.max[d].data() + r.begin(), r.size(),
+                    inflation_radius);
+            }
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                vertex_boxes.vertex_ids[i] = { { index_t(i), -1, -1 } };
+            }
+        });
+}
+
+void build_vertex_boxes(
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+    AABBs& vertex_boxes,
+    const double inflation_radius)
+{
+    assert(vertices_t0.rows() == vertices_t1.rows());
+    assert(vertices_t0.cols() == vertices_t1.cols());
+    const int dim = vertices_t0.cols();
+    vertex_boxes.resize(vertices_t0.rows(), dim);
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, vertices_t0.rows()),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (int d = 0; d < dim; d++) {
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    vertex_boxes.min[d][i] =
+                        std::min(vertices_t0(i, d), vertices_t1(i, d));
+                    vertex_boxes.max[d][i] =
+                        std::max(vertices_t0(i, d), vertices_t1(i, d));
+                }
+                conservative_inflation(
+                    vertex_boxes.min[d].data() + r.begin(),
+                    vertex_boxes.max[d].data() + r.begin(), r.size(),
+                    inflation_radius);
+            }
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                vertex_boxes.vertex_ids[i] = { { index_t(i), -1, -1 } };
+            }
+        });
+}
+
+void build_edge_boxes(
+    const AABBs& vertex_boxes,
+    Eigen::ConstRef<Eigen::MatrixXi> edges,
+    AABBs& edge_boxes)
+{
+    const int dim = vertex_boxes.dim();
+    edge_boxes.resize(edges.rows(), dim);
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, edges.rows()),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (int d = 0; d < dim; d++) {
+                const std::vector<double>& v_min = vertex_boxes.min[d];
+                const std::vector<double>& v_max = vertex_boxes.max[d];
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    edge_boxes.min[d][i] =
+                        std::min(v_min[edges(i, 0)], v_min[edges(i, 1)]);
+                    edge_boxes.max[d][i] =
+                        std::max(v_max[edges(i, 0)], v_max[edges(i, 1)]);
+                }
+            }
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                edge_boxes.vertex_ids[i] = { { edges(i, 0), edges(i, 1), -1 } };
+            }
+        });
+}
+
+void build_face_boxes(
+    const AABBs& vertex_boxes,
+    Eigen::ConstRef<Eigen::MatrixXi> faces,
+    AABBs& face_boxes)
+{
+    const int dim = vertex_boxes.dim();
+    face_boxes.resize(faces.rows(), dim);
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, faces.rows()),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (int d = 0; d < dim; d++) {
+                const std::vector<double>& v_min = vertex_boxes.min[d];
+                const std::vector<double>& v_max = vertex_boxes.max[d];
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    face_boxes.min[d][i] = std::min(
+                        { v_min[faces(i, 0)], v_min[faces(i, 1)],
+                          v_min[faces(i, 2)] });
+                    face_boxes.max[d][i] = std::max(
+                        { v_max[faces(i, 0)], v_max[faces(i, 1)],
+                          v_max[faces(i, 2)] });
+                }
+            }
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                face_boxes.vertex_ids[i] = { { faces(i, 0), faces(i, 1),
+                                               faces(i, 2) } };
+            }
+        });
+}
+
+} // namespace ipc
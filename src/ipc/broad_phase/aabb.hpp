@@ -4,6 +4,7 @@
 #include <ipc/utils/eigen_ext.hpp>
 
 #include <array>
+#include <vector>
 
 namespace ipc {
 
@@ -68,6 +69,100 @@ public:
     std::array<index_t, 3> vertex_ids;
 };
 
+/// @brief Packed structure-of-arrays storage for a set of axis-aligned bounding boxes.
+///
+/// The minimum and maximum coordinates of each axis are stored in their own
+/// contiguous arrays so overlap tests against runs of boxes stream through
+/// memory and vectorize.
+class AABBs {
+public:
+    AABBs() = default;
+
+    /// @brief Get the number of boxes.
+    size_t size() const { return vertex_ids.size(); }
+
+    /// @brief Check if there are no boxes.
+    bool empty() const { return vertex_ids.empty(); }
+
+    /// @brief Get the dimension of the boxes (2 or 3).
+    int dim() const { return m_dim; }
+
+    /// @brief Resize the storage.
+    /// @param n Number of boxes.
+    /// @param dim Dimension of the boxes (2 or 3).
+    void resize(const size_t n, const int dim);
+
+    /// @brief Remove all boxes.
+    void clear();
+
+    /// @brief Set the extents of the i-th box.
+    /// @param i Index of the box.
+    /// @param min Minimum corner of the box.
+    /// @param max Maximum corner of the box.
+    void set(
+        const size_t i,
+        Eigen::ConstRef<ArrayMax3d> min,
+        Eigen::ConstRef<ArrayMax3d> max);
+
+    /// @brief Get the minimum corner of the i-th box.
+    ArrayMax3d min_corner(const size_t i) const;
+
+    /// @brief Get the maximum corner of the i-th box.
+    ArrayMax3d max_corner(const size_t i) const;
+
+    /// @brief Get an unpacked copy of the i-th box.
+    AABB operator[](const size_t i) const;
+
+    /// @brief Check if the i-th box intersects the j-th box of another set.
+    /// @param i Index of the box in this set.
+    /// @param other The other set of boxes.
+    /// @param j Index of the box in the other set.
+    /// @return If the two boxes intersect.
+    bool intersects(const size_t i, const AABBs& other, const size_t j) const
+    {
+        assert(dim() == other.dim());
+        for (int d = 0; d < dim(); d++) {
+            if (min[d][i] > other.max[d][j] || other.min[d][j] > max[d][i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief Find the boxes in a range that intersect a box of another set.
+    /// @param[in] other The set containing the query box.
+    /// @param[in] i Index of the query box in the other set.
+    /// @param[in] begin First box of this set to test.
+    /// @param[in] end One past the last box of this set to test.
+    /// @param[out] hits Indices (in this set) of the intersecting boxes are appended to this.
+    void intersect_range(
+        const AABBs& other,
+        const size_t i,
+        const size_t begin,
+        const size_t end,
+        std::vector<size_t>& hits) const;
+
+public:
+    /// @brief Minimum coordinates of the boxes (min[axis][box]).
+    std::array<std::vector<double>, 3> min;
+    /// @brief Maximum coordinates of the boxes (max[axis][box]).
+    std::array<std::vector<double>, 3> max;
+    /// @brief Vertex IDs attached to each box.
+    std::vector<std::array<index_t, 3>> vertex_ids;
+
+protected:
+    template <int dim>
+    void intersect_range(
+        const AABBs& other,
+        const size_t i,
+        const size_t begin,
+        const size_t end,
+        std::vector<size_t>& hits) const;
+
+    /// @brief Dimension of the boxes.
+    int m_dim = 3;
+};
+
 /// @brief Build one AABB per vertex position (row of V).
 /// @param[in] vertices Vertex positions (rowwise).
 /// @param[out] vertex_boxes Vertex AABBs.
@@ -106,4 +201,42 @@ void build_face_boxes(
     Eigen::ConstRef<Eigen::MatrixXi> faces,
     std::vector<AABB>& face_boxes);
 
+/// @brief Build one packed AABB per vertex position (row of V).
+/// @param[in] vertices Vertex positions (rowwise).
+/// @param[out] vertex_boxes Vertex AABBs.
+/// @param[in] inflation_radius Radius of a sphere around the points which the AABBs enclose.
+void build_vertex_boxes(
+    Eigen::ConstRef<Eigen::MatrixXd> vertices,
+    AABBs& vertex_boxes,
+    const double inflation_radius = 0);
+
+/// @brief Build one packed AABB per vertex position moving linearly from t=0 to t=1.
+/// @param vertices_t0 Vertex positions at t=0 (rowwise).
+/// @param vertices_t1 Vertex positions at t=1 (rowwise).
+/// @param vertex_boxes Vertex AABBs.
+/// @param inflation_radius Radius of a capsule around the temporal edges which the AABBs enclose.
+void build_vertex_boxes(
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+    AABBs& vertex_boxes,
+    const double inflation_radius = 0);
+
+/// @brief Build one packed AABB per edge.
+/// @param vertex_boxes Vertex AABBs.
+/// @param edges Edges (rowwise).
+/// @param edge_boxes Edge AABBs.
+void build_edge_boxes(
+    const AABBs& vertex_boxes,
+    Eigen::ConstRef<Eigen::MatrixXi> edges,
+    AABBs& edge_boxes);
+
+/// @brief Build one packed AABB per face.
+/// @param vertex_boxes Vertex AABBs.
+/// @param faces Faces (rowwise).
+/// @param face_boxes Face AABBs.
+void build_face_boxes(
+    const AABBs& vertex_boxes,
+    Eigen::ConstRef<Eigen::MatrixXi> faces,
+    AABBs& face_boxes);
+
 } // namespace ipc
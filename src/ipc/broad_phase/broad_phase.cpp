@@ -9,8 +9,28 @@
 #include <ipc/broad_phase/sweep_and_tiniest_queue.hpp>
 #include <ipc/candidates/candidates.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 namespace ipc {
 
+namespace {
+    template <typename Candidate>
+    void buffer_candidates(
+        const std::vector<Candidate>& candidates,
+        CandidateBuffers<Candidate>& buffers)
+    {
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(size_t(0), candidates.size()),
+            [&](const tbb::blocked_range<size_t>& r) {
+                auto& local_candidates = buffers.local();
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    local_candidates.emplace_back(candidates[i]);
+                }
+            });
+    }
+} // namespace
+
 std::shared_ptr<ipc::BroadPhase>
 build_broad_phase(const BroadPhaseMethod& broad_phase_method)
 {
@@ -84,11 +104,81 @@ void BroadPhase::detect_collision_candidates(
     }
 }
 
+void BroadPhase::stream_vertex_vertex_candidates(
+    const CandidateTileCallback<VertexVertexCandidate>& callback,
+    const size_t tile_size) const
+{
+    CandidateBuffers<VertexVertexCandidate> buffers(callback, tile_size);
+    detect_vertex_vertex_candidates(buffers);
+    buffers.flush();
+}
+
+void BroadPhase::stream_edge_vertex_candidates(
+    const CandidateTileCallback<EdgeVertexCandidate>& callback,
+    const size_t tile_size) const
+{
+    CandidateBuffers<EdgeVertexCandidate> buffers(callback, tile_size);
+    detect_edge_vertex_candidates(buffers);
+    buffers.flush();
+}
+
+void BroadPhase::stream_edge_edge_candidates(
+    const CandidateTileCallback<EdgeEdgeCandidate>& callback,
+    const size_t tile_size) const
+{
+    CandidateBuffers<EdgeEdgeCandidate> buffers(callback, tile_size);
+    detect_edge_edge_candidates(buffers);
+    buffers.flush();
+}
+
+void BroadPhase::stream_face_vertex_candidates(
+    const CandidateTileCallback<FaceVertexCandidate>& callback,
+    const size_t tile_size) const
+{
+    CandidateBuffers<FaceVertexCandidate> buffers(callback, tile_size);
+    detect_face_vertex_candidates(buffers);
+    buffers.flush();
+}
+
+// ============================================================================
+
+void BroadPhase::detect_vertex_vertex_candidates(
+    CandidateBuffers<VertexVertexCandidate>& buffers) const
+{
+    std::vector<VertexVertexCandidate> candidates;
+    detect_vertex_vertex_candidates(candidates);
+    buffer_candidates(candidates, buffers);
+}
+
+void BroadPhase::detect_edge_vertex_candidates(
+    CandidateBuffers<EdgeVertexCandidate>& buffers) const
+{
+    std::vector<EdgeVertexCandidate> candidates;
+    detect_edge_vertex_candidates(candidates);
+    buffer_candidates(candidates, buffers);
+}
+
+void BroadPhase::detect_edge_edge_candidates(
+    CandidateBuffers<EdgeEdgeCandidate>& buffers) const
+{
+    std::vector<EdgeEdgeCandidate> candidates;
+    detect_edge_edge_candidates(candidates);
+    buffer_candidates(candidates, buffers);
+}
+
+void BroadPhase::detect_face_vertex_candidates(
+    CandidateBuffers<FaceVertexCandidate>& buffers) const
+{
+    std::vector<FaceVertexCandidate> candidates;
+    detect_face_vertex_candidates(candidates);
+    buffer_candidates(candidates, buffers);
+}
+
 // ============================================================================
 
 bool BroadPhase::can_edge_vertex_collide(size_t ei, size_t vi) const
 {
-    const auto& [e0i, e1i, _] = edge_boxes[ei].vertex_ids;
+    const auto& [e0i, e1i, _] = edge_boxes.vertex_ids[ei];
 
     return vi != e0i && vi != e1i
         && (can_vertices_collide(vi, e0i) || can_vertices_collide(vi, e1i));
@@ -96,8 +186,8 @@ bool BroadPhase::can_edge_vertex_collide(size_t ei, size_t vi) const
 
 bool BroadPhase::can_edges_collide(size_t eai, size_t ebi) const
 {
-    const auto& [ea0i, ea1i, _] = edge_boxes[eai].vertex_ids;
-    const auto& [eb0i, eb1i, __] = edge_boxes[ebi].vertex_ids;
+    const auto& [ea0i, ea1i, _] = edge_boxes.vertex_ids[eai];
+    const auto& [eb0i, eb1i, __] = edge_boxes.vertex_ids[ebi];
 
     const bool share_endpoint =
         ea0i == eb0i || ea0i == eb1i || ea1i == eb0i || ea1i == eb1i;
@@ -110,7 +200,7 @@ bool BroadPhase::can_edges_collide(size_t eai, size_t ebi) const
 
 bool BroadPhase::can_face_vertex_collide(size_t fi, size_t vi) const
 {
-    const auto& [f0i, f1i, f2i] = face_boxes[fi].vertex_ids;
+    const auto& [f0i, f1i, f2i] = face_boxes.vertex_ids[fi];
 
     return vi != f0i && vi != f1i && vi != f2i
         && (can_vertices_collide(vi, f0i) || can_vertices_collide(vi, f1i)
@@ -119,8 +209,8 @@ bool BroadPhase::can_face_vertex_collide(size_t fi, size_t vi) const
 
 bool BroadPhase::can_edge_face_collide(size_t ei, size_t fi) const
 {
-    const auto& [e0i, e1i, _] = edge_boxes[ei].vertex_ids;
-    const auto& [f0i, f1i, f2i] = face_boxes[fi].vertex_ids;
+    const auto& [e0i, e1i, _] = edge_boxes.vertex_ids[ei];
+    const auto& [f0i, f1i, f2i] = face_boxes.vertex_ids[fi];
 
     const bool share_endpoint = e0i == f0i || e0i == f1i || e0i == f2i
         || e1i == f0i || e1i == f1i || e1i == f2i;
@@ -134,8 +224,8 @@ bool BroadPhase::can_edge_face_collide(size_t ei, size_t fi) const
 
 bool BroadPhase::can_faces_collide(size_t fai, size_t fbi) const
 {
-    const auto& [fa0i, fa1i, fa2i] = face_boxes[fai].vertex_ids;
-    const auto& [fb0i, fb1i, fb2i] = face_boxes[fbi].vertex_ids;
+    const auto& [fa0i, fa1i, fa2i] = face_boxes.vertex_ids[fai];
+    const auto& [fb0i, fb1i, fb2i] = face_boxes.vertex_ids[fbi];
 
     const bool share_endpoint = fa0i == fb0i || fa0i == fb1i || fa0i == fb2i
         || fa1i == fb0i || fa1i == fb1i || fa1i == fb2i || fa2i == fb0i
@@ -2,6 +2,7 @@
 
 #include <ipc/collision_mesh.hpp>
 #include <ipc/broad_phase/aabb.hpp>
+#include <ipc/broad_phase/candidate_buffers.hpp>
 #include <ipc/candidates/edge_edge.hpp>
 #include <ipc/candidates/edge_face.hpp>
 #include <ipc/candidates/edge_vertex.hpp>
@@ -56,6 +57,38 @@ public:
         Eigen::ConstRef<Eigen::MatrixXi> faces,
         const double inflation_radius = 0);
 
+    /// @brief Update the broad phase for static collision detection.
+    /// @note The default implementation rebuilds from scratch. Methods with acceleration structures may reuse them if the connectivity is unchanged.
+    /// @param vertices Vertex positions
+    /// @param edges Collision mesh edges
+    /// @param faces Collision mesh faces
+    /// @param inflation_radius Radius of inflation around all elements.
+    virtual void update(
+        Eigen::ConstRef<Eigen::MatrixXd> vertices,
+        Eigen::ConstRef<Eigen::MatrixXi> edges,
+        Eigen::ConstRef<Eigen::MatrixXi> faces,
+        const double inflation_radius = 0)
+    {
+        build(vertices, edges, faces, inflation_radius);
+    }
+
+    /// @brief Update the broad phase for continuous collision detection.
+    /// @note The default implementation rebuilds from scratch. Methods with acceleration structures may reuse them if the connectivity is unchanged.
+    /// @param vertices_t0 Starting vertices of the vertices.
+    /// @param vertices_t1 Ending vertices of the vertices.
+    /// @param edges Collision mesh edges
+    /// @param faces Collision mesh faces
+    /// @param inflation_radius Radius of inflation around all elements.
+    virtual void update(
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+        Eigen::ConstRef<Eigen::MatrixXi> edges,
+        Eigen::ConstRef<Eigen::MatrixXi> faces,
+        const double inflation_radius = 0)
+    {
+        build(vertices_t0, vertices_t1, edges, faces, inflation_radius);
+    }
+
     /// @brief Clear any built data.
     virtual void clear();
 
@@ -94,11 +127,67 @@ public:
     virtual void detect_face_face_candidates(
         std::vector<FaceFaceCandidate>& candidates) const = 0;
 
+    /// @brief Stream the candidate vertex-vertex collisions in tiles.
+    /// @note The candidates are never stored all at once; the callback is called concurrently while the broad phase runs.
+    /// @param callback Function consuming each tile of candidates.
+    /// @param tile_size Maximum number of candidates in a tile.
+    void stream_vertex_vertex_candidates(
+        const CandidateTileCallback<VertexVertexCandidate>& callback,
+        const size_t tile_size) const;
+
+    /// @brief Stream the candidate edge-vertex collisions in tiles.
+    /// @note The candidates are never stored all at once; the callback is called concurrently while the broad phase runs.
+    /// @param callback Function consuming each tile of candidates.
+    /// @param tile_size Maximum number of candidates in a tile.
+    void stream_edge_vertex_candidates(
+        const CandidateTileCallback<EdgeVertexCandidate>& callback,
+        const size_t tile_size) const;
+
+    /// @brief Stream the candidate edge-edge collisions in tiles.
+    /// @note The candidates are never stored all at once; the callback is called concurrently while the broad phase runs.
+    /// @param callback Function consuming each tile of candidates.
+    /// @param tile_size Maximum number of candidates in a tile.
+    void stream_edge_edge_candidates(
+        const CandidateTileCallback<EdgeEdgeCandidate>& callback,
+        const size_t tile_size) const;
+
+    /// @brief Stream the candidate face-vertex collisions in tiles.
+    /// @note The candidates are never stored all at once; the callback is called concurrently while the broad phase runs.
+    /// @param callback Function consuming each tile of candidates.
+    /// @param tile_size Maximum number of candidates in a tile.
+    void stream_face_vertex_candidates(
+        const CandidateTileCallback<FaceVertexCandidate>& callback,
+        const size_t tile_size) const;
+
     /// @brief Function for determining if two vertices can collide.
     std::function<bool(size_t, size_t)> can_vertices_collide =
         default_can_vertices_collide;
 
 protected:
+    /// @brief Find the candidate vertex-vertex collisions.
+    /// @note The default implementation detects all candidates before buffering them. Override it to fill the buffers directly.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    virtual void detect_vertex_vertex_candidates(
+        CandidateBuffers<VertexVertexCandidate>& buffers) const;
+
+    /// @brief Find the candidate edge-vertex collisions.
+    /// @note The default implementation detects all candidates before buffering them. Override it to fill the buffers directly.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    virtual void detect_edge_vertex_candidates(
+        CandidateBuffers<EdgeVertexCandidate>& buffers) const;
+
+    /// @brief Find the candidate edge-edge collisions.
+    /// @note The default implementation detects all candidates before buffering them. Override it to fill the buffers directly.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    virtual void detect_edge_edge_candidates(
+        CandidateBuffers<EdgeEdgeCandidate>& buffers) const;
+
+    /// @brief Find the candidate face-vertex collisions.
+    /// @note The default implementation detects all candidates before buffering them. Override it to fill the buffers directly.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    virtual void detect_face_vertex_candidates(
+        CandidateBuffers<FaceVertexCandidate>& buffers) const;
+
     virtual bool can_edge_vertex_collide(size_t ei, size_t vi) const;
     virtual bool can_edges_collide(size_t eai, size_t ebi) const;
     virtual bool can_face_vertex_collide(size_t fi, size_t vi) const;
@@ -107,9 +196,9 @@ protected:
 
     static bool default_can_vertices_collide(size_t, size_t) { return true; }
 
-    std::vector<AABB> vertex_boxes;
-    std::vector<AABB> edge_boxes;
-    std::vector<AABB> face_boxes;
+    AABBs vertex_boxes;
+    AABBs edge_boxes;
+    AABBs face_boxes;
 };
 
 std::shared_ptr<BroadPhase>
@@ -1,9 +1,6 @@
 #include "brute_force.hpp"
 
-#include <ipc/utils/merge_thread_local.hpp>
-
 #include <tbb/blocked_range2d.h>
-#include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 
 #include <algorithm> // std::min/max
@@ -14,17 +11,15 @@ namespace ipc {
 
 template <typename Candidate, bool triangular>
 void BruteForce::detect_candidates(
-    const std::vector<AABB>& boxes0,
-    const std::vector<AABB>& boxes1,
+    const AABBs& boxes0,
+    const AABBs& boxes1,
     const std::function<bool(size_t, size_t)>& can_collide,
-    std::vector<Candidate>& candidates) const
+    CandidateBuffers<Candidate>& buffers) const
 {
-    tbb::enumerable_thread_specific<std::vector<Candidate>> storage;
-
     tbb::parallel_for(
         tbb::blocked_range2d<size_t>(0ul, boxes0.size(), 0ul, boxes1.size()),
         [&](const tbb::blocked_range2d<size_t>& r) {
-            auto& local_candidates = storage.local();
+            auto& local_candidates = buffers.local();
 
             size_t i_end;
             if constexpr (triangular) {
@@ -33,9 +28,8 @@ void BruteForce::detect_candidates(
                 i_end = r.rows().end();
             }
 
+            std::vector<size_t> hits;
             for (size_t i = r.rows().begin(); i < i_end; i++) {
-                const AABB& box0 = boxes0[i];
-
                 size_t j_begin;
                 if constexpr (triangular) {
                     // i < r.cols().end() → i + 1 <= r.cols().end()
@@ -44,70 +38,102 @@ void BruteForce::detect_candidates(
                     j_begin = r.cols().begin();
                 }
 
-                for (size_t j = j_begin; j < r.cols().end(); j++) {
-                    if (!can_collide(i, j)) {
-                        continue;
-                    }
+                // Test the whole row of boxes at once before the more
+                // expensive can_collide check.
+                hits.clear();
+                boxes1.intersect_range(
+                    boxes0, i, j_begin, r.cols().end(), hits);
 
-                    const AABB& box1 = boxes1[j];
-                    if (box0.intersects(box1)) {
+                for (const size_t j : hits) {
+                    if (can_collide(i, j)) {
                         local_candidates.emplace_back(i, j);
                     }
                 }
             }
         });
-
-    merge_thread_local_vectors(storage, candidates);
 }
 
 void BruteForce::detect_vertex_vertex_candidates(
     std::vector<VertexVertexCandidate>& candidates) const
 {
-    detect_candidates<VertexVertexCandidate, true>(
-        vertex_boxes, vertex_boxes, can_vertices_collide, candidates);
+    CandidateBuffers<VertexVertexCandidate> buffers;
+    detect_vertex_vertex_candidates(buffers);
+    buffers.merge(candidates);
 }
 
 void BruteForce::detect_edge_vertex_candidates(
     std::vector<EdgeVertexCandidate>& candidates) const
 {
-    detect_candidates(
-        edge_boxes, vertex_boxes,
-        std::bind(&BruteForce::can_edge_vertex_collide, this, _1, _2),
-        candidates);
+    CandidateBuffers<EdgeVertexCandidate> buffers;
+    detect_edge_vertex_candidates(buffers);
+    buffers.merge(candidates);
 }
 
 void BruteForce::detect_edge_edge_candidates(
     std::vector<EdgeEdgeCandidate>& candidates) const
 {
-    detect_candidates<EdgeEdgeCandidate, true>(
-        edge_boxes, edge_boxes,
-        std::bind(&BruteForce::can_edges_collide, this, _1, _2), candidates);
+    CandidateBuffers<EdgeEdgeCandidate> buffers;
+    detect_edge_edge_candidates(buffers);
+    buffers.merge(candidates);
 }
 
 void BruteForce::detect_face_vertex_candidates(
     std::vector<FaceVertexCandidate>& candidates) const
 {
-    detect_candidates(
-        face_boxes, vertex_boxes,
-        std::bind(&BruteForce::can_face_vertex_collide, this, _1, _2),
-        candidates);
+    CandidateBuffers<FaceVertexCandidate> buffers;
+    detect_face_vertex_candidates(buffers);
+    buffers.merge(candidates);
 }
 
 void BruteForce::detect_edge_face_candidates(
     std::vector<EdgeFaceCandidate>& candidates) const
 {
+    CandidateBuffers<EdgeFaceCandidate> buffers;
     detect_candidates(
         edge_boxes, face_boxes,
-        std::bind(&BruteForce::can_edge_face_collide, this, _1, _2),
-        candidates);
+        std::bind(&BruteForce::can_edge_face_collide, this, _1, _2), buffers);
+    buffers.merge(candidates);
 }
 
 void BruteForce::detect_face_face_candidates(
     std::vector<FaceFaceCandidate>& candidates) const
 {
+    CandidateBuffers<FaceFaceCandidate> buffers;
     detect_candidates<FaceFaceCandidate, true>(
         face_boxes, face_boxes,
-        std::bind(&BruteForce::can_faces_collide, this, _1, _2), candidates);
+        std::bind(&BruteForce::can_faces_collide, this, _1, _2), buffers);
+    buffers.merge(candidates);
+}
+
+void BruteForce::detect_vertex_vertex_candidates(
+    CandidateBuffers<VertexVertexCandidate>& buffers) const
+{
+    detect_candidates<VertexVertexCandidate, true>(
+        vertex_boxes, vertex_boxes, can_vertices_collide, buffers);
+}
+
+void BruteForce::detect_edge_vertex_candidates(
+    CandidateBuffers<EdgeVertexCandidate>& buffers) const
+{
+    detect_candidates(
+        edge_boxes, vertex_boxes,
+        std::bind(&BruteForce::can_edge_vertex_collide, this, _1, _2), buffers);
+}
+
+void BruteForce::detect_edge_edge_candidates(
+    CandidateBuffers<EdgeEdgeCandidate>& buffers) const
+{
+    detect_candidates<EdgeEdgeCandidate, true>(
+        edge_boxes, edge_boxes,
+        std::bind(&BruteForce::can_edges_collide, this, _1, _2), buffers);
+}
+
+void BruteForce::detect_face_vertex_candidates(
+    CandidateBuffers<FaceVertexCandidate>& buffers) const
+{
+    detect_candidates(
+        face_boxes, vertex_boxes,
+        std::bind(&BruteForce::can_face_vertex_collide, this, _1, _2), buffers);
 }
 
 } // namespace ipc
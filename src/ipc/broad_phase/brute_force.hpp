@@ -42,6 +42,27 @@ public:
     void detect_face_face_candidates(
         std::vector<FaceFaceCandidate>& candidates) const override;
 
+protected:
+    /// @brief Find the candidate vertex-vertex collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_vertex_vertex_candidates(
+        CandidateBuffers<VertexVertexCandidate>& buffers) const override;
+
+    /// @brief Find the candidate edge-vertex collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_edge_vertex_candidates(
+        CandidateBuffers<EdgeVertexCandidate>& buffers) const override;
+
+    /// @brief Find the candidate edge-edge collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_edge_edge_candidates(
+        CandidateBuffers<EdgeEdgeCandidate>& buffers) const override;
+
+    /// @brief Find the candidate face-vertex collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_face_vertex_candidates(
+        CandidateBuffers<FaceVertexCandidate>& buffers) const override;
+
 private:
     /// @brief Detect candidates for collisions between two sets of boxes.
     /// @tparam Candidate Type of the candidate.
@@ -49,13 +70,13 @@ private:
     /// @param[in] boxes0 First set of boxes.
     /// @param[in] boxes1 Second set of boxes.
     /// @param[in] can_collide Function to determine if two primitives can collide given their ids.
-    /// @param[out] candidates The candidate collisions.
+    /// @param[out] buffers Thread-local buffers of the candidate collisions.
     template <typename Candidate, bool triangular = false>
     void detect_candidates(
-        const std::vector<AABB>& boxes0,
-        const std::vector<AABB>& boxes1,
+        const AABBs& boxes0,
+        const AABBs& boxes1,
         const std::function<bool(size_t, size_t)>& can_collide,
-        std::vector<Candidate>& candidates) const;
+        CandidateBuffers<Candidate>& buffers) const;
 };
 
 } // namespace ipc
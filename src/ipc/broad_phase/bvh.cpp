@@ -1,10 +1,11 @@
 #include "bvh.hpp"
 
-#include <ipc/utils/merge_thread_local.hpp>
+#include <ipc/utils/logger.hpp>
 
 #include <tbb/blocked_range.h>
-#include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
+#include <tbb/parallel_invoke.h>
+#include <tbb/parallel_sort.h>
 
 using namespace std::placeholders;
 
@@ -35,48 +36,301 @@ void BVH::build(
     init_bvh(face_boxes, face_bvh);
 }
 
-void BVH::init_bvh(const std::vector<AABB>& boxes, SimpleBVH::BVH& bvh)
+void BVH::update(
+    Eigen::ConstRef<Eigen::MatrixXd> vertices,
+    Eigen::ConstRef<Eigen::MatrixXi> edges,
+    Eigen::ConstRef<Eigen::MatrixXi> faces,
+    const double inflation_radius)
+{
+    if (!can_refit(vertices.rows(), edges.rows(), faces.rows())) {
+        build(vertices, edges, faces, inflation_radius);
+        return;
+    }
+
+    build_vertex_boxes(vertices, vertex_boxes, inflation_radius);
+    build_edge_boxes(vertex_boxes, edges, edge_boxes);
+    build_face_boxes(vertex_boxes, faces, face_boxes);
+    refit_bvh(vertex_boxes, vertex_bvh);
+    refit_bvh(edge_boxes, edge_bvh);
+    refit_bvh(face_boxes, face_bvh);
+}
+
+void BVH::update(
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+    Eigen::ConstRef<Eigen::MatrixXi> edges,
+    Eigen::ConstRef<Eigen::MatrixXi> faces,
+    const double inflation_radius)
+{
+    if (!can_refit(vertices_t0.rows(), edges.rows(), faces.rows())) {
+        build(vertices_t0, vertices_t1, edges, faces, inflation_radius);
+        return;
+    }
+
+    build_vertex_boxes(
+        vertices_t0, vertices_t1, vertex_boxes, inflation_radius);
+    build_edge_boxes(vertex_boxes, edges, edge_boxes);
+    build_face_boxes(vertex_boxes, faces, face_boxes);
+    refit_bvh(vertex_boxes, vertex_bvh);
+    refit_bvh(edge_boxes, edge_bvh);
+    refit_bvh(face_boxes, face_bvh);
+}
+
+bool BVH::can_refit(
+    const size_t num_vertices,
+    const size_t num_edges,
+    const size_t num_faces) const
+{
+    // The trees are only valid if they were built from the current boxes.
+    return num_vertices > 0 && vertex_boxes.size() == num_vertices
+        && vertex_bvh.size() == num_vertices
+        && edge_boxes.size() == num_edges && edge_bvh.size() == num_edges
+        && face_boxes.size() == num_faces && face_bvh.size() == num_faces;
+}
+
+void BVH::init_bvh(const AABBs& boxes, Tree& bvh)
 {
     if (boxes.size() == 0) {
         return;
     }
 
-    std::vector<std::array<Eigen::Vector3d, 2>> vector_boxes(boxes.size());
-    for (int i = 0; i < boxes.size(); i++) {
-        vector_boxes[i] = { { to_3D(boxes[i].min), to_3D(boxes[i].max) } };
+    bvh.init(boxes);
+}
+
+void BVH::refit_bvh(const AABBs& boxes, Tree& bvh) const
+{
+    if (boxes.size() == 0) {
+        return;
     }
 
-    bvh.init(vector_boxes);
+    const double cost = bvh.refit(boxes);
+    if (cost > max_refit_cost_growth * bvh.build_cost()) {
+        logger().trace(
+            "rebuilding BVH (SAH cost grew from {:g} to {:g})",
+            bvh.build_cost(), cost);
+        bvh.init(boxes);
+    }
 }
 
 void BVH::clear()
 {
+    BroadPhase::clear();
     vertex_bvh.clear();
     edge_bvh.clear();
     face_bvh.clear();
 }
 
+// ============================================================================
+
+namespace {
+    /// @brief Spread the lower 10 bits of x so there are two zeros between each bit.
+    uint32_t expand_bits(uint32_t x)
+    {
+        x = (x * 0x00010001u) & 0xFF0000FFu;
+        x = (x * 0x00000101u) & 0x0F00F00Fu;
+        x = (x * 0x00000011u) & 0xC30C30C3u;
+        x = (x * 0x00000005u) & 0x49249249u;
+        return x;
+    }
+
+    /// @brief Compute the 30-bit Morton code of a point in the unit cube.
+    uint32_t morton_code(const Eigen::Array3d& p)
+    {
+        const Eigen::Array3d q = (p * 1024.0).min(1023.0).max(0.0);
+        return expand_bits(uint32_t(q.x())) << 2
+            | expand_bits(uint32_t(q.y())) << 1 | expand_bits(uint32_t(q.z()));
+    }
+
+    /// @brief Get the minimum corner of a packed box padded to 3D.
+    Eigen::Array3d min_3D(const AABBs& boxes, const size_t i)
+    {
+        Eigen::Array3d p = Eigen::Array3d::Zero();
+        for (int d = 0; d < boxes.dim(); d++) {
+            p[d] = boxes.min[d][i];
+        }
+        return p;
+    }
+
+    /// @brief Get the maximum corner of a packed box padded to 3D.
+    Eigen::Array3d max_3D(const AABBs& boxes, const size_t i)
+    {
+        Eigen::Array3d p = Eigen::Array3d::Zero();
+        for (int d = 0; d < boxes.dim(); d++) {
+            p[d] = boxes.max[d][i];
+        }
+        return p;
+    }
+
+    double surface_area(const Eigen::Array3d& min, const Eigen::Array3d& max)
+    {
+        const Eigen::Array3d d = max - min;
+        return 2 * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+    }
+
+    /// @brief Subtrees smaller than this are fit serially.
+    constexpr size_t PARALLEL_FIT_THRESHOLD = 4096;
+} // namespace
+
+void BVH::Tree::init(const AABBs& boxes)
+{
+    clear();
+
+    const size_t n = boxes.size();
+    assert(n > 0);
+
+    // Sort the primitives along a Morton curve of their box centers.
+    std::vector<Eigen::Array3d> centers(n);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), n),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                centers[i] = 0.5 * (min_3D(boxes, i) + max_3D(boxes, i));
+            }
+        });
+
+    Eigen::Array3d center_min = centers[0], center_max = centers[0];
+    for (const Eigen::Array3d& c : centers) {
+        center_min = center_min.min(c);
+        center_max = center_max.max(c);
+    }
+    const Eigen::Array3d extent =
+        (center_max - center_min).max(std::numeric_limits<double>::min());
+
+    std::vector<std::pair<uint32_t, unsigned int>> codes(n);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), n),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                codes[i] = std::make_pair(
+                    morton_code((centers[i] - center_min) / extent),
+                    static_cast<unsigned int>(i));
+            }
+        });
+    tbb::parallel_sort(codes.begin(), codes.end());
+
+    new2old.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        new2old[i] = codes[i].second;
+    }
+
+    // The implicit tree of n leaves fits in 4n nodes.
+    node_min.resize(4 * n);
+    node_max.resize(4 * n);
+
+    m_build_cost = sah_cost(fit(boxes, 1, 0, n));
+}
+
+double BVH::Tree::refit(const AABBs& boxes)
+{
+    assert(boxes.size() == size());
+    return sah_cost(fit(boxes, 1, 0, size()));
+}
+
+void BVH::Tree::clear()
+{
+    node_min.clear();
+    node_max.clear();
+    new2old.clear();
+    m_build_cost = 0;
+}
+
+double BVH::Tree::fit(
+    const AABBs& boxes,
+    const size_t n,
+    const size_t b,
+    const size_t e)
+{
+    assert(b < e);
+
+    if (b + 1 == e) {
+        node_min[n] = min_3D(boxes, new2old[b]);
+        node_max[n] = max_3D(boxes, new2old[b]);
+        return 0;
+    }
+
+    const size_t m = b + (e - b) / 2;
+    const size_t left = 2 * n, right = 2 * n + 1;
+
+    double left_area, right_area;
+    if (e - b > PARALLEL_FIT_THRESHOLD) {
+        tbb::parallel_invoke(
+            [&] { left_area = fit(boxes, left, b, m); },
+            [&] { right_area = fit(boxes, right, m, e); });
+    } else {
+        left_area = fit(boxes, left, b, m);
+        right_area = fit(boxes, right, m, e);
+    }
+
+    node_min[n] = node_min[left].min(node_min[right]);
+    node_max[n] = node_max[left].max(node_max[right]);
+
+    return left_area + right_area + surface_area(node_min[n], node_max[n]);
+}
+
+double BVH::Tree::sah_cost(const double area_sum) const
+{
+    const double root_area = surface_area(node_min[1], node_max[1]);
+    return root_area > 0 ? (area_sum / root_area) : 0;
+}
+
+void BVH::Tree::intersect_box(
+    const AABBs& boxes,
+    const size_t i,
+    std::vector<unsigned int>& list) const
+{
+    if (new2old.empty()) {
+        return;
+    }
+
+    const Eigen::Array3d min = min_3D(boxes, i), max = max_3D(boxes, i);
+
+    struct Entry {
+        size_t n, b, e;
+    };
+    // The depth of the tree is at most ⌈log₂(size)⌉ + 1.
+    std::array<Entry, 64> stack;
+    size_t top = 0;
+    stack[top++] = { 1, 0, new2old.size() };
+
+    while (top > 0) {
+        const auto [n, b, e] = stack[--top];
+
+        if ((node_min[n] > max).any() || (min > node_max[n]).any()) {
+            continue;
+        }
+
+        if (b + 1 == e) {
+            list.push_back(new2old[b]);
+            continue;
+        }
+
+        const size_t m = b + (e - b) / 2;
+        stack[top++] = { 2 * n + 1, m, e };
+        stack[top++] = { 2 * n, b, m };
+    }
+}
+
+// ============================================================================
+
 template <typename Candidate, bool swap_order, bool triangular>
 void BVH::detect_candidates(
-    const std::vector<AABB>& boxes,
-    const SimpleBVH::BVH& bvh,
+    const AABBs& boxes,
+    const Tree& bvh,
     const std::function<bool(size_t, size_t)>& can_collide,
-    std::vector<Candidate>& candidates)
+    CandidateBuffers<Candidate>& buffers)
 {
     // O(n^2) or O(n^3) to build
     // O(klog(n)) to do a single look up
     // O(knlog(n)) to do all look ups
 
-    tbb::enumerable_thread_specific<std::vector<Candidate>> storage;
-
     tbb::parallel_for(
         tbb::blocked_range<size_t>(size_t(0), boxes.size()),
         [&](const tbb::blocked_range<size_t>& r) {
-            auto& local_candidates = storage.local();
+            auto& local_candidates = buffers.local();
 
             for (size_t i = r.begin(); i < r.end(); i++) {
                 std::vector<unsigned int> js;
-                bvh.intersect_box(boxes[i].min, boxes[i].max, js);
+                bvh.intersect_box(boxes, i, js);
 
                 for (const unsigned int j : js) {
                     int ai = i, bi = j;
@@ -98,12 +352,72 @@ void BVH::detect_candidates(
                 }
             }
         });
-
-    merge_thread_local_vectors(storage, candidates);
 }
 
 void BVH::detect_vertex_vertex_candidates(
     std::vector<VertexVertexCandidate>& candidates) const
+{
+    CandidateBuffers<VertexVertexCandidate> buffers;
+    detect_vertex_vertex_candidates(buffers);
+    buffers.merge(candidates);
+}
+
+void BVH::detect_edge_vertex_candidates(
+    std::vector<EdgeVertexCandidate>& candidates) const
+{
+    CandidateBuffers<EdgeVertexCandidate> buffers;
+    detect_edge_vertex_candidates(buffers);
+    buffers.merge(candidates);
+}
+
+void BVH::detect_edge_edge_candidates(
+    std::vector<EdgeEdgeCandidate>& candidates) const
+{
+    CandidateBuffers<EdgeEdgeCandidate> buffers;
+    detect_edge_edge_candidates(buffers);
+    buffers.merge(candidates);
+}
+
+void BVH::detect_face_vertex_candidates(
+    std::vector<FaceVertexCandidate>& candidates) const
+{
+    CandidateBuffers<FaceVertexCandidate> buffers;
+    detect_face_vertex_candidates(buffers);
+    buffers.merge(candidates);
+}
+
+void BVH::detect_edge_face_candidates(
+    std::vector<EdgeFaceCandidate>& candidates) const
+{
+    if (edge_boxes.size() == 0 || face_boxes.size() == 0) {
+        return;
+    }
+
+    // The ratio edges:faces is 3:2, so we want to iterate over the faces.
+    CandidateBuffers<EdgeFaceCandidate> buffers;
+    detect_candidates<EdgeFaceCandidate, /*swap_order=*/true>(
+        face_boxes, edge_bvh,
+        std::bind(&BVH::can_edge_face_collide, this, _1, _2), buffers);
+    buffers.merge(candidates);
+}
+
+void BVH::detect_face_face_candidates(
+    std::vector<FaceFaceCandidate>& candidates) const
+{
+    if (face_boxes.size() == 0) {
+        return;
+    }
+
+    CandidateBuffers<FaceFaceCandidate> buffers;
+    detect_candidates<
+        FaceFaceCandidate, /*swap_order=*/false, /*triangular=*/true>(
+        face_boxes, face_bvh, std::bind(&BVH::can_faces_collide, this, _1, _2),
+        buffers);
+    buffers.merge(candidates);
+}
+
+void BVH::detect_vertex_vertex_candidates(
+    CandidateBuffers<VertexVertexCandidate>& buffers) const
 {
     if (vertex_boxes.size() == 0) {
         return;
@@ -111,11 +425,11 @@ void BVH::detect_vertex_vertex_candidates(
 
     detect_candidates<
         VertexVertexCandidate, /*swap_order=*/false, /*triangular=*/true>(
-        vertex_boxes, vertex_bvh, can_vertices_collide, candidates);
+        vertex_boxes, vertex_bvh, can_vertices_collide, buffers);
 }
 
 void BVH::detect_edge_vertex_candidates(
-    std::vector<EdgeVertexCandidate>& candidates) const
+    CandidateBuffers<EdgeVertexCandidate>& buffers) const
 {
     if (edge_boxes.size() == 0 || vertex_boxes.size() == 0) {
         return;
@@ -125,11 +439,11 @@ void BVH::detect_edge_vertex_candidates(
     // vertices than edges, so we want to iterate over the edges.
     detect_candidates(
         edge_boxes, vertex_bvh,
-        std::bind(&BVH::can_edge_vertex_collide, this, _1, _2), candidates);
+        std::bind(&BVH::can_edge_vertex_collide, this, _1, _2), buffers);
 }
 
 void BVH::detect_edge_edge_candidates(
-    std::vector<EdgeEdgeCandidate>& candidates) const
+    CandidateBuffers<EdgeEdgeCandidate>& buffers) const
 {
     if (edge_boxes.size() == 0) {
         return;
@@ -138,11 +452,11 @@ void BVH::detect_edge_edge_candidates(
     detect_candidates<
         EdgeEdgeCandidate, /*swap_order=*/false, /*triangular=*/true>(
         edge_boxes, edge_bvh, std::bind(&BVH::can_edges_collide, this, _1, _2),
-        candidates);
+        buffers);
 }
 
 void BVH::detect_face_vertex_candidates(
-    std::vector<FaceVertexCandidate>& candidates) const
+    CandidateBuffers<FaceVertexCandidate>& buffers) const
 {
     if (face_boxes.size() == 0 || vertex_boxes.size() == 0) {
         return;
@@ -151,33 +465,7 @@ void BVH::detect_face_vertex_candidates(
     // The ratio vertices:faces is 1:2, so we want to iterate over the vertices.
     detect_candidates<FaceVertexCandidate, /*swap_order=*/true>(
         vertex_boxes, face_bvh,
-        std::bind(&BVH::can_face_vertex_collide, this, _1, _2), candidates);
-}
-
-void BVH::detect_edge_face_candidates(
-    std::vector<EdgeFaceCandidate>& candidates) const
-{
-    if (edge_boxes.size() == 0 || face_boxes.size() == 0) {
-        return;
-    }
-
-    // The ratio edges:faces is 3:2, so we want to iterate over the faces.
-    detect_candidates<EdgeFaceCandidate, /*swap_order=*/true>(
-        face_boxes, edge_bvh,
-        std::bind(&BVH::can_edge_face_collide, this, _1, _2), candidates);
-}
-
-void BVH::detect_face_face_candidates(
-    std::vector<FaceFaceCandidate>& candidates) const
-{
-    if (face_boxes.size() == 0) {
-        return;
-    }
-
-    detect_candidates<
-        FaceFaceCandidate, /*swap_order=*/false, /*triangular=*/true>(
-        face_boxes, face_bvh, std::bind(&BVH::can_faces_collide, this, _1, _2),
-        candidates);
+        std::bind(&BVH::can_face_vertex_collide, this, _1, _2), buffers);
 }
 
 } // namespace ipc
\ No newline at end of file
@@ -2,8 +2,6 @@
 
 #include <ipc/broad_phase/broad_phase.hpp>
 
-#include <SimpleBVH/BVH.hpp>
-
 namespace ipc {
 
 class BVH : public BroadPhase {
@@ -38,6 +36,32 @@ public:
         Eigen::ConstRef<Eigen::MatrixXi> faces,
         const double inflation_radius = 0) override;
 
+    /// @brief Update the broad phase for static collision detection.
+    /// @note If the number of vertices, edges, and faces is unchanged since the last build, the trees are refit instead of rebuilt.
+    /// @param vertices Vertex positions
+    /// @param edges Collision mesh edges
+    /// @param faces Collision mesh faces
+    /// @param inflation_radius Radius of inflation around all elements.
+    void update(
+        Eigen::ConstRef<Eigen::MatrixXd> vertices,
+        Eigen::ConstRef<Eigen::MatrixXi> edges,
+        Eigen::ConstRef<Eigen::MatrixXi> faces,
+        const double inflation_radius = 0) override;
+
+    /// @brief Update the broad phase for continuous collision detection.
+    /// @note If the number of vertices, edges, and faces is unchanged since the last build, the trees are refit instead of rebuilt.
+    /// @param vertices_t0 Starting vertices of the vertices.
+    /// @param vertices_t1 Ending vertices of the vertices.
+    /// @param edges Collision mesh edges
+    /// @param faces Collision mesh faces
+    /// @param inflation_radius Radius of inflation around all elements.
+    void update(
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+        Eigen::ConstRef<Eigen::MatrixXi> edges,
+        Eigen::ConstRef<Eigen::MatrixXi> faces,
+        const double inflation_radius = 0) override;
+
     /// @brief Clear any built data.
     void clear() override;
 
@@ -71,11 +95,103 @@ public:
     void detect_face_face_candidates(
         std::vector<FaceFaceCandidate>& candidates) const override;
 
+    /// @brief Maximum relative growth of a tree's surface area heuristic (SAH)
+    /// cost before update() rebuilds it instead of refitting it.
+    double max_refit_cost_growth = 1.5;
+
 protected:
+    /// @brief Find the candidate vertex-vertex collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_vertex_vertex_candidates(
+        CandidateBuffers<VertexVertexCandidate>& buffers) const override;
+
+    /// @brief Find the candidate edge-vertex collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_edge_vertex_candidates(
+        CandidateBuffers<EdgeVertexCandidate>& buffers) const override;
+
+    /// @brief Find the candidate edge-edge collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_edge_edge_candidates(
+        CandidateBuffers<EdgeEdgeCandidate>& buffers) const override;
+
+    /// @brief Find the candidate face-vertex collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_face_vertex_candidates(
+        CandidateBuffers<FaceVertexCandidate>& buffers) const override;
+
+    /// @brief Flat bounding volume hierarchy with a fixed topology.
+    ///
+    /// The primitives are sorted along a Morton curve and the tree is stored
+    /// implicitly: node 1 is the root and node n has children 2n and 2n+1.
+    /// Because the topology only depends on the primitive order, the node
+    /// bounds can be refit to moved boxes without rebuilding.
+    class Tree {
+    public:
+        /// @brief Build the tree topology and node bounds.
+        /// @param boxes Set of boxes to initialize the tree with.
+        void init(const AABBs& boxes);
+
+        /// @brief Recompute the node bounds bottom-up keeping the topology.
+        /// @param boxes Moved boxes (must be the same number as in init()).
+        /// @return The SAH cost of the refit tree.
+        double refit(const AABBs& boxes);
+
+        /// @brief Clear the tree.
+        void clear();
+
+        /// @brief Find all primitives whose boxes intersect a query box.
+        /// @param[in] boxes Set of boxes containing the query box.
+        /// @param[in] i Index of the query box.
+        /// @param[out] list The ids of the intersecting primitives.
+        void intersect_box(
+            const AABBs& boxes,
+            const size_t i,
+            std::vector<unsigned int>& list) const;
+
+        /// @brief Number of primitives in the tree.
+        size_t size() const { return new2old.size(); }
+
+        /// @brief SAH cost of the tree when it was last built.
+        double build_cost() const { return m_build_cost; }
+
+    protected:
+        /// @brief Recursively fit the bounds of node n spanning primitives [b, e).
+        /// @return Sum of surface areas of the internal nodes in the subtree.
+        double fit(
+            const AABBs& boxes,
+            const size_t n,
+            const size_t b,
+            const size_t e);
+
+        /// @brief Normalize the sum of internal node areas by the root area.
+        double sah_cost(const double area_sum) const;
+
+        /// @brief Minimum corner of each node.
+        std::vector<Eigen::Array3d> node_min;
+        /// @brief Maximum corner of each node.
+        std::vector<Eigen::Array3d> node_max;
+        /// @brief Map from sorted leaf position to primitive id.
+        std::vector<unsigned int> new2old;
+        /// @brief SAH cost of the tree when it was last built.
+        double m_build_cost = 0;
+    };
+
     /// @brief Initialize a BVH from a set of boxes.
     /// @param[in] boxes Set of boxes to initialize the BVH with.
     /// @param[out] bvh The BVH to initialize.
-    static void init_bvh(const std::vector<AABB>& boxes, SimpleBVH::BVH& bvh);
+    static void init_bvh(const AABBs& boxes, Tree& bvh);
+
+    /// @brief Refit a BVH to moved boxes, rebuilding it if its quality degraded.
+    /// @param[in] boxes Moved boxes.
+    /// @param[in,out] bvh The BVH to refit.
+    void refit_bvh(const AABBs& boxes, Tree& bvh) const;
+
+    /// @brief Check if the trees can be refit to a mesh of the given size.
+    bool can_refit(
+        const size_t num_vertices,
+        const size_t num_edges,
+        const size_t num_faces) const;
 
     /// @brief Detect candidate collisions between a BVH and a sets of boxes.
     /// @tparam Candidate Type of candidate collision.
@@ -84,23 +200,23 @@ protected:
     /// @param[in] boxes The boxes to detect collisions with.
     /// @param[in] bvh The BVH to detect collisions with.
     /// @param[in] can_collide Function to determine if two primitives can collide given their ids.
-    /// @param[out] candidates The candidate collisions.
+    /// @param[out] buffers Thread-local buffers of the candidate collisions.
     template <
         typename Candidate,
         bool swap_order = false,
         bool triangular = false>
     static void detect_candidates(
-        const std::vector<AABB>& boxes,
-        const SimpleBVH::BVH& bvh,
+        const AABBs& boxes,
+        const Tree& bvh,
         const std::function<bool(size_t, size_t)>& can_collide,
-        std::vector<Candidate>& candidates);
+        CandidateBuffers<Candidate>& buffers);
 
     /// @brief BVH containing the vertices.
-    SimpleBVH::BVH vertex_bvh;
+    Tree vertex_bvh;
     /// @brief BVH containing the edges.
-    SimpleBVH::BVH edge_bvh;
+    Tree edge_bvh;
     /// @brief BVH containing the faces.
-    SimpleBVH::BVH face_bvh;
+    Tree face_bvh;
 };
 
 } // namespace ipc
\ No newline at end of file
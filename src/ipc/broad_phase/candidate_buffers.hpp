@@ -0,0 +1,118 @@
+#pragma once
+
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace ipc {
+
+/// @brief Function consuming a tile of candidates found by a broad phase.
+/// @note The function is called concurrently from the broad phase's threads.
+template <typename Candidate>
+using CandidateTileCallback =
+    std::function<void(const std::vector<Candidate>&)>;
+
+/// @brief Thread-local buffers of candidates filled by a broad phase.
+///
+/// Without a callback, the buffers grow until they are merged into a single
+/// vector. With a callback, a thread's buffer is passed to the callback and
+/// cleared as soon as it holds a full tile, so at most one tile per thread is
+/// stored at any time.
+template <typename Candidate> class CandidateBuffers {
+public:
+    /// @brief A single thread's buffer.
+    class Local {
+    public:
+        explicit Local(const CandidateBuffers* parent) : m_parent(parent) { }
+
+        /// @brief Add a candidate to the buffer.
+        template <typename... Args> void emplace_back(Args&&... args)
+        {
+            m_candidates.emplace_back(std::forward<Args>(args)...);
+            if (m_parent->m_callback
+                && m_candidates.size() >= m_parent->m_tile_size) {
+                m_parent->m_callback(m_candidates);
+                m_candidates.clear();
+            }
+        }
+
+    private:
+        friend class CandidateBuffers;
+
+        std::vector<Candidate> m_candidates;
+        const CandidateBuffers* m_parent;
+    };
+
+    /// @brief Construct buffers to be merged into a vector.
+    CandidateBuffers() : m_storage(Local(this)) { }
+
+    /// @brief Construct buffers streaming tiles of candidates to a callback.
+    /// @param callback Function consuming each tile of candidates.
+    /// @param tile_size Number of candidates in a full tile.
+    CandidateBuffers(
+        const CandidateTileCallback<Candidate>& callback,
+        const size_t tile_size)
+        : m_callback(callback)
+        , m_tile_size(std::max(tile_size, size_t(1)))
+        , m_storage(Local(this))
+    {
+    }
+
+    // The local buffers point back to this object.
+    CandidateBuffers(const CandidateBuffers&) = delete;
+    CandidateBuffers& operator=(const CandidateBuffers&) = delete;
+
+    /// @brief Get the calling thread's buffer.
+    Local& local() { return m_storage.local(); }
+
+    /// @brief Pass the remaining candidates to the callback.
+    void flush()
+    {
+        if (!m_callback) {
+            return;
+        }
+        tbb::parallel_for(
+            m_storage.range(),
+            [&](const typename Storage::range_type& r) {
+                for (Local& local : r) {
+                    if (!local.m_candidates.empty()) {
+                        m_callback(local.m_candidates);
+                        local.m_candidates.clear();
+                    }
+                }
+            });
+    }
+
+    /// @brief Append the buffered candidates to a vector.
+    /// @param[out] candidates Vector of candidates to append to.
+    void merge(std::vector<Candidate>& candidates) const
+    {
+        // size up the items
+        size_t size = candidates.size();
+        for (const Local& local : m_storage) {
+            size += local.m_candidates.size();
+        }
+        // serial merge!
+        candidates.reserve(size);
+        for (const Local& local : m_storage) {
+            candidates.insert(
+                candidates.end(), local.m_candidates.begin(),
+                local.m_candidates.end());
+        }
+    }
+
+private:
+    using Storage = tbb::enumerable_thread_specific<Local>;
+
+    /// @brief Function consuming full tiles (empty when merging).
+    CandidateTileCallback<Candidate> m_callback;
+    /// @brief Number of candidates in a full tile.
+    size_t m_tile_size = 0;
+    /// @brief Thread-local buffers.
+    Storage m_storage;
+};
+
+} // namespace ipc
@@ -4,19 +4,66 @@
 #include <ipc/utils/logger.hpp>
 #include <ipc/utils/merge_thread_local.hpp>
 
-#include <tbb/blocked_range2d.h>
 #include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_sort.h>
 
 #include <algorithm> // std::min/max
-
-#define IPC_TOOLKIT_HASH_GRID_USE_SORT_UNIQUE // else use unordered_set
+#include <numeric>   // std::partial_sum
 
 using namespace std::placeholders;
 
 namespace ipc {
 
+namespace {
+    /// @brief A run of sorted items with the same key.
+    struct HashCell {
+        long key;
+        size_t begin, end;
+    };
+
+    /// @brief Find the runs of equal keys in a sorted list of items.
+    std::vector<HashCell> find_cells(const std::vector<HashItem>& items)
+    {
+        constexpr size_t CHUNK_SIZE = 4096;
+
+        const size_t n = items.size();
+        const size_t num_chunks = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+        const auto is_cell_start = [&](size_t i) {
+            return i == 0 || items[i].key != items[i - 1].key;
+        };
+
+        // Count the cells starting in each chunk.
+        std::vector<size_t> chunk_offsets(num_chunks + 1, 0);
+        tbb::parallel_for(size_t(0), num_chunks, [&](size_t c) {
+            const size_t end = std::min(n, (c + 1) * CHUNK_SIZE);
+            for (size_t i = c * CHUNK_SIZE; i < end; i++) {
+                chunk_offsets[c + 1] += is_cell_start(i);
+            }
+        });
+        std::partial_sum(
+            chunk_offsets.begin(), chunk_offsets.end(), chunk_offsets.begin());
+
+        // Write the cells of each chunk at its offset.
+        std::vector<HashCell> cells(chunk_offsets.back());
+        tbb::parallel_for(size_t(0), num_chunks, [&](size_t c) {
+            const size_t end = std::min(n, (c + 1) * CHUNK_SIZE);
+            size_t k = chunk_offsets[c];
+            for (size_t i = c * CHUNK_SIZE; i < end; i++) {
+                if (is_cell_start(i)) {
+                    cells[k++] = { items[i].key, i, n };
+                }
+            }
+        });
+        tbb::parallel_for(size_t(1), cells.size(), [&](size_t k) {
+            cells[k - 1].end = cells[k].begin;
+        });
+
+        return cells;
+    }
+} // namespace
+
 void HashGrid::build(
     Eigen::ConstRef<Eigen::MatrixXd> vertices,
     Eigen::ConstRef<Eigen::MatrixXi> edges,
@@ -90,7 +137,7 @@ void HashGrid::insert_boxes()
 }
 
 void HashGrid::insert_boxes(
-    const std::vector<AABB>& boxes, std::vector<HashItem>& items) const
+    const AABBs& boxes, std::vector<HashItem>& items) const
 {
     tbb::enumerable_thread_specific<std::vector<HashItem>> storage;
 
@@ -99,7 +146,8 @@ void HashGrid::insert_boxes(
         [&](const tbb::blocked_range<long>& range) {
             auto& local_items = storage.local();
             for (long i = range.begin(); i != range.end(); i++) {
-                insert_box(boxes[i], i, local_items);
+                insert_box(
+                    boxes.min_corner(i), boxes.max_corner(i), i, local_items);
             }
         });
 
@@ -111,18 +159,13 @@ void HashGrid::insert_boxes(
 }
 
 void HashGrid::insert_box(
-    const AABB& aabb, const long id, std::vector<HashItem>& items) const
+    Eigen::ConstRef<ArrayMax3d> min,
+    Eigen::ConstRef<ArrayMax3d> max,
+    const long id,
+    std::vector<HashItem>& items) const
 {
-    ArrayMax3i int_min = ((aabb.min - domain_min()) / cell_size()).cast<int>();
-    // We can round down to -1, but not less
-    assert((int_min >= -1).all());
-    assert((int_min <= grid_size()).all());
-    int_min = int_min.max(0).min(grid_size() - 1);
-
-    ArrayMax3i int_max = ((aabb.max - domain_min()) / cell_size()).cast<int>();
-    assert((int_max >= -1).all());
-    assert((int_max <= grid_size()).all());
-    int_max = int_max.max(0).min(grid_size() - 1);
+    const ArrayMax3i int_min = cell_index(min);
+    const ArrayMax3i int_max = cell_index(max);
     assert((int_min <= int_max).all());
 
     int min_z = int_min.size() == 3 ? int_min.z() : 0;
@@ -136,233 +179,230 @@ void HashGrid::insert_box(
     }
 }
 
+ArrayMax3i HashGrid::cell_index(Eigen::ConstRef<ArrayMax3d> p) const
+{
+    const ArrayMax3i cell = ((p - domain_min()) / cell_size()).cast<int>();
+    // We can round down to -1, but not less
+    assert((cell >= -1).all());
+    assert((cell <= grid_size()).all());
+    return cell.max(0).min(grid_size() - 1);
+}
+
+void HashGrid::split_cell(
+    const long key,
+    const size_t row_begin,
+    const size_t row_end,
+    const size_t col_begin,
+    const size_t col_end,
+    std::vector<CellBlock>& blocks)
+{
+    // Dense cells are split into blocks of rows so they are load balanced.
+    constexpr size_t MAX_PAIRS_PER_BLOCK = 4096;
+    const size_t rows_per_block =
+        std::max(size_t(1), MAX_PAIRS_PER_BLOCK / (col_end - col_begin));
+    for (size_t r = row_begin; r < row_end; r += rows_per_block) {
+        blocks.push_back(
+            { key, r, std::min(r + rows_per_block, row_end), col_begin,
+              col_end });
+    }
+}
+
 template <typename Candidate>
 void HashGrid::detect_candidates(
     const std::vector<HashItem>& items0,
     const std::vector<HashItem>& items1,
-    const std::vector<AABB>& boxes0,
-    const std::vector<AABB>& boxes1,
+    const AABBs& boxes0,
+    const AABBs& boxes1,
     const std::function<bool(size_t, size_t)>& can_collide,
-    std::vector<Candidate>& candidates) const
+    CandidateBuffers<Candidate>& buffers) const
 {
     // Entries with the same key means they share a cell (that cell index
     // hashes to the same key) and should be flagged for low-level intersection
-    // testing. We loop over the entire sorted set of (key,value) pairs
-    // creating Candidate entries for pairs with the same key
-
-    // 1. Soft merge of items (assuming items are sorted)
-    size_t num_items = items0.size() + items1.size();
-    std::vector<long> merged_item_indices;
-    merged_item_indices.reserve(num_items);
-    {
-        long i = 0, j = 0;
-        while (i < items0.size() && j < items1.size()) {
-            if (items0[i] < items1[j]) {
-                merged_item_indices.push_back(-(i++) - 1);
-            } else {
-                merged_item_indices.push_back(j++);
-            }
-        }
-        while (i < items0.size()) {
-            merged_item_indices.push_back(-(i++) - 1);
-        }
-        while (j < items1.size()) {
-            merged_item_indices.push_back(j++);
+    // testing. Only the pairs of items in the cells occupied by both sets are
+    // enumerated.
+    const std::vector<HashCell> cells0 = find_cells(items0);
+    const std::vector<HashCell> cells1 = find_cells(items1);
+
+    std::vector<CellBlock> blocks;
+    for (size_t i = 0, j = 0; i < cells0.size() && j < cells1.size();) {
+        if (cells0[i].key < cells1[j].key) {
+            i++;
+        } else if (cells1[j].key < cells0[i].key) {
+            j++;
+        } else {
+            split_cell(
+                cells0[i].key, cells0[i].begin, cells0[i].end, cells1[j].begin,
+                cells1[j].end, blocks);
+            i++;
+            j++;
         }
     }
-    assert(merged_item_indices.size() == num_items);
-
-    const auto get_item = [&](long i) -> const HashItem& {
-        return i < 0 ? items0[-(i + 1)] : items1[i];
-    };
-
-    // 2. Enumerate hash collisions
-#ifdef IPC_TOOLKIT_HASH_GRID_USE_SORT_UNIQUE
-    tbb::enumerable_thread_specific<std::vector<Candidate>> storage;
-#else
-    tbb::enumerable_thread_specific<unordered_set<Candidate>> storage;
-#endif
 
-    tbb::parallel_for(
-        tbb::blocked_range2d<long>(0l, num_items - 1, 0l, num_items),
-        [&](const tbb::blocked_range2d<long>& r) {
-            auto& local_candidates = storage.local();
-
-            // i < j
-            long i_end = std::min(r.rows().end(), r.cols().end());
-            for (long i = r.rows().begin(); i < i_end; i++) {
-                const long idx0 = merged_item_indices[i];
-                const HashItem& item0 = get_item(idx0);
-
-                // i < r.cols().end() → i + 1 <= r.cols().end()
-                long j_begin = std::max(i + 1, r.cols().begin());
-                for (long j = j_begin; j < r.cols().end(); j++) {
-                    const long idx1 = merged_item_indices[j];
-                    const HashItem& item1 = get_item(idx1);
-
-                    if (item0.key != item1.key) {
-                        break; // This avoids a brute force comparison
-                    }
-
-                    long id0 = item0.id, id1 = item1.id;
-                    if (idx0 >= 0 && idx1 < 0) {
-                        std::swap(id0, id1);
-                    } else if (idx0 >= 0 || idx1 < 0) {
-                        continue;
-                    }
-                    assert(id0 < boxes0.size() && id1 < boxes1.size());
-
-                    if (!can_collide(id0, id1)) {
-                        continue;
-                    }
-
-                    if (boxes0[id0].intersects(boxes1[id1])) {
-#ifdef IPC_TOOLKIT_HASH_GRID_USE_SORT_UNIQUE
-                        local_candidates.emplace_back(id0, id1);
-#else
-                        local_candidates.emplace(id0, id1);
-#endif
-                    }
-                }
-            }
-        });
-
-#ifdef IPC_TOOLKIT_HASH_GRID_USE_SORT_UNIQUE
-    merge_thread_local_vectors(storage, candidates);
-
-    // Remove the duplicate candidates
-    tbb::parallel_sort(candidates.begin(), candidates.end());
-    auto new_end = std::unique(candidates.begin(), candidates.end());
-    candidates.erase(new_end, candidates.end());
-#else
-    unordered_set<Candidate> candidates_set;
-    merge_thread_local_unordered_sets(storage, candidates_set);
-
-    candidates.reserve(candidates_set.size());
-    candidates.insert(
-        candidates.end(), candidates_set.begin(), candidates_set.end());
-#endif
+    detect_candidates<Candidate, /*triangular=*/false>(
+        blocks, items0, items1, boxes0, boxes1, can_collide, buffers);
 }
 
 template <typename Candidate>
 void HashGrid::detect_candidates(
     const std::vector<HashItem>& items,
-    const std::vector<AABB>& boxes,
+    const AABBs& boxes,
     const std::function<bool(size_t, size_t)>& can_collide,
-    std::vector<Candidate>& candidates) const
+    CandidateBuffers<Candidate>& buffers) const
 {
     // Entries with the same key means they share a cell (that cell index
     // hashes to the same key) and should be flagged for low-level
-    // intersection testing. So we loop over the entire sorted set of
-    // (key,value) pairs creating Candidate entries for pairs with the same key
+    // intersection testing. Only the pairs of items within each cell are
+    // enumerated.
+    const std::vector<HashCell> cells = find_cells(items);
+
+    std::vector<CellBlock> blocks;
+    for (const HashCell& cell : cells) {
+        if (cell.end - cell.begin > 1) {
+            split_cell(
+                cell.key, cell.begin, cell.end - 1, cell.begin, cell.end,
+                blocks);
+        }
+    }
 
-#ifdef IPC_TOOLKIT_HASH_GRID_USE_SORT_UNIQUE
-    tbb::enumerable_thread_specific<std::vector<Candidate>> storage;
-#else
-    tbb::enumerable_thread_specific<unordered_set<Candidate>> storage;
-#endif
+    detect_candidates<Candidate, /*triangular=*/true>(
+        blocks, items, items, boxes, boxes, can_collide, buffers);
+}
 
+template <typename Candidate, bool triangular>
+void HashGrid::detect_candidates(
+    const std::vector<CellBlock>& blocks,
+    const std::vector<HashItem>& items0,
+    const std::vector<HashItem>& items1,
+    const AABBs& boxes0,
+    const AABBs& boxes1,
+    const std::function<bool(size_t, size_t)>& can_collide,
+    CandidateBuffers<Candidate>& buffers) const
+{
     tbb::parallel_for(
-        tbb::blocked_range2d<long>(0l, items.size() - 1, 0l, items.size()),
-        [&](const tbb::blocked_range2d<long>& r) {
-            auto& local_candidates = storage.local();
-
-            // i < j
-            long i_end = std::min(r.rows().end(), r.cols().end());
-            for (long i = r.rows().begin(); i < i_end; i++) {
-                const HashItem& item0 = items[i];
-                const AABB& box0 = boxes[item0.id];
-
-                // i < r.cols().end() → i + 1 <= r.cols().end()
-                long j_begin = std::max(i + 1, r.cols().begin());
-                assert(j_begin > i);
-                for (long j = j_begin; j < r.cols().end(); j++) {
-                    const HashItem& item1 = items[j];
-
-                    if (item0.key != item1.key) {
-                        break; // This avoids a brute force comparison
-                    }
+        tbb::blocked_range<size_t>(size_t(0), blocks.size()),
+        [&](const tbb::blocked_range<size_t>& r) {
+            auto& local_candidates = buffers.local();
+
+            for (size_t b = r.begin(); b < r.end(); b++) {
+                const CellBlock& block = blocks[b];
 
-                    if (!can_collide(item0.id, item1.id)) {
-                        continue;
+                for (size_t i = block.row_begin; i < block.row_end; i++) {
+                    const long id0 = items0[i].id;
+                    const ArrayMax3i min_cell0 =
+                        cell_index(boxes0.min_corner(id0));
+
+                    size_t j_begin = block.col_begin;
+                    if constexpr (triangular) {
+                        j_begin = std::max(j_begin, i + 1);
                     }
 
-                    const AABB& box1 = boxes[item1.id];
-                    if (box0.intersects(box1)) {
-#ifdef IPC_TOOLKIT_HASH_GRID_USE_SORT_UNIQUE
-                        local_candidates.emplace_back(item0.id, item1.id);
-#else
-                        local_candidates.emplace(item0.id, item1.id);
-#endif
+                    for (size_t j = j_begin; j < block.col_end; j++) {
+                        const long id1 = items1[j].id;
+                        assert(id0 < boxes0.size() && id1 < boxes1.size());
+
+                        // A pair shares every cell in the intersection of
+                        // the boxes' cell ranges. Only report it from the
+                        // first of these cells to avoid duplicates.
+                        if (hash(min_cell0.max(
+                                cell_index(boxes1.min_corner(id1))))
+                            != block.key) {
+                            continue;
+                        }
+
+                        if (!can_collide(id0, id1)) {
+                            continue;
+                        }
+
+                        if (boxes0.intersects(id0, boxes1, id1)) {
+                            local_candidates.emplace_back(id0, id1);
+                        }
                     }
                 }
             }
         });
-
-#ifdef IPC_TOOLKIT_HASH_GRID_USE_SORT_UNIQUE
-    merge_thread_local_vectors(storage, candidates);
-
-    // Remove the duplicate candidates
-    tbb::parallel_sort(candidates.begin(), candidates.end());
-    auto new_end = std::unique(candidates.begin(), candidates.end());
-    candidates.erase(new_end, candidates.end());
-#else
-    unordered_set<Candidate> candidates_set;
-    merge_thread_local_unordered_sets(storage, candidates_set);
-
-    candidates.reserve(candidates_set.size());
-    candidates.insert(
-        candidates.end(), candidates_set.begin(), candidates_set.end());
-#endif
 }
 
 void HashGrid::detect_vertex_vertex_candidates(
     std::vector<VertexVertexCandidate>& candidates) const
 {
-    detect_candidates(
-        vertex_items, vertex_boxes, can_vertices_collide, candidates);
+    CandidateBuffers<VertexVertexCandidate> buffers;
+    detect_vertex_vertex_candidates(buffers);
+    buffers.merge(candidates);
 }
 
 void HashGrid::detect_edge_vertex_candidates(
     std::vector<EdgeVertexCandidate>& candidates) const
 {
-    detect_candidates(
-        edge_items, vertex_items, edge_boxes, vertex_boxes,
-        std::bind(&HashGrid::can_edge_vertex_collide, this, _1, _2),
-        candidates);
+    CandidateBuffers<EdgeVertexCandidate> buffers;
+    detect_edge_vertex_candidates(buffers);
+    buffers.merge(candidates);
 }
 
 void HashGrid::detect_edge_edge_candidates(
     std::vector<EdgeEdgeCandidate>& candidates) const
 {
-    detect_candidates(
-        edge_items, edge_boxes,
-        std::bind(&HashGrid::can_edges_collide, this, _1, _2), candidates);
+    CandidateBuffers<EdgeEdgeCandidate> buffers;
+    detect_edge_edge_candidates(buffers);
+    buffers.merge(candidates);
 }
 
 void HashGrid::detect_face_vertex_candidates(
     std::vector<FaceVertexCandidate>& candidates) const
 {
-    detect_candidates(
-        face_items, vertex_items, face_boxes, vertex_boxes,
-        std::bind(&HashGrid::can_face_vertex_collide, this, _1, _2),
-        candidates);
+    CandidateBuffers<FaceVertexCandidate> buffers;
+    detect_face_vertex_candidates(buffers);
+    buffers.merge(candidates);
 }
 
 void HashGrid::detect_edge_face_candidates(
     std::vector<EdgeFaceCandidate>& candidates) const
 {
+    CandidateBuffers<EdgeFaceCandidate> buffers;
     detect_candidates(
         edge_items, face_items, edge_boxes, face_boxes,
-        std::bind(&HashGrid::can_edge_face_collide, this, _1, _2), candidates);
+        std::bind(&HashGrid::can_edge_face_collide, this, _1, _2), buffers);
+    buffers.merge(candidates);
 }
 
 void HashGrid::detect_face_face_candidates(
     std::vector<FaceFaceCandidate>& candidates) const
 {
+    CandidateBuffers<FaceFaceCandidate> buffers;
     detect_candidates(
         face_items, face_boxes,
-        std::bind(&HashGrid::can_faces_collide, this, _1, _2), candidates);
+        std::bind(&HashGrid::can_faces_collide, this, _1, _2), buffers);
+    buffers.merge(candidates);
+}
+
+void HashGrid::detect_vertex_vertex_candidates(
+    CandidateBuffers<VertexVertexCandidate>& buffers) const
+{
+    detect_candidates(
+        vertex_items, vertex_boxes, can_vertices_collide, buffers);
+}
+
+void HashGrid::detect_edge_vertex_candidates(
+    CandidateBuffers<EdgeVertexCandidate>& buffers) const
+{
+    detect_candidates(
+        edge_items, vertex_items, edge_boxes, vertex_boxes,
+        std::bind(&HashGrid::can_edge_vertex_collide, this, _1, _2), buffers);
+}
+
+void HashGrid::detect_edge_edge_candidates(
+    CandidateBuffers<EdgeEdgeCandidate>& buffers) const
+{
+    detect_candidates(
+        edge_items, edge_boxes,
+        std::bind(&HashGrid::can_edges_collide, this, _1, _2), buffers);
+}
+
+void HashGrid::detect_face_vertex_candidates(
+    CandidateBuffers<FaceVertexCandidate>& buffers) const
+{
+    detect_candidates(
+        face_items, vertex_items, face_boxes, vertex_boxes,
+        std::bind(&HashGrid::can_face_vertex_collide, this, _1, _2), buffers);
 }
 
 } // namespace ipc
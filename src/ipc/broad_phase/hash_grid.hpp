@@ -100,6 +100,26 @@ public:
     const ArrayMax3d& domain_max() const { return m_domain_max; }
 
 protected:
+    /// @brief Find the candidate vertex-vertex collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_vertex_vertex_candidates(
+        CandidateBuffers<VertexVertexCandidate>& buffers) const override;
+
+    /// @brief Find the candidate edge-vertex collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_edge_vertex_candidates(
+        CandidateBuffers<EdgeVertexCandidate>& buffers) const override;
+
+    /// @brief Find the candidate edge-edge collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_edge_edge_candidates(
+        CandidateBuffers<EdgeEdgeCandidate>& buffers) const override;
+
+    /// @brief Find the candidate face-vertex collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_face_vertex_candidates(
+        CandidateBuffers<FaceVertexCandidate>& buffers) const override;
+
     void resize(
         Eigen::ConstRef<ArrayMax3d> domain_min,
         Eigen::ConstRef<ArrayMax3d> domain_max,
@@ -107,12 +127,23 @@ protected:
 
     void insert_boxes();
 
-    void insert_boxes(
-        const std::vector<AABB>& boxes, std::vector<HashItem>& items) const;
+    void insert_boxes(const AABBs& boxes, std::vector<HashItem>& items) const;
 
     /// @brief Add an AABB of the extents to the hash grid.
     void insert_box(
-        const AABB& aabb, const long id, std::vector<HashItem>& items) const;
+        Eigen::ConstRef<ArrayMax3d> min,
+        Eigen::ConstRef<ArrayMax3d> max,
+        const long id,
+        std::vector<HashItem>& items) const;
+
+    /// @brief Get the cell containing a point (clamped to the grid).
+    ArrayMax3i cell_index(Eigen::ConstRef<ArrayMax3d> p) const;
+
+    /// @brief Create the hash of a cell location.
+    inline long hash(Eigen::ConstRef<ArrayMax3i> cell) const
+    {
+        return hash(cell[0], cell[1], cell.size() == 3 ? cell[2] : 0);
+    }
 
     /// @brief Create the hash of a cell location.
     inline long hash(int x, int y, int z) const
@@ -125,6 +156,17 @@ protected:
     }
 
 private:
+    /// @brief A block of item pairs sharing a cell.
+    ///
+    /// The pairs are the items [row_begin, row_end) of the first set times the
+    /// items [col_begin, col_end) of the second set.
+    struct CellBlock {
+        /// @brief The key of the shared cell.
+        long key;
+        size_t row_begin, row_end;
+        size_t col_begin, col_end;
+    };
+
     /// @brief Find the candidate collisions between two sets of items.
     /// @tparam Candidate The type of collision candidate.
     /// @param[in] items0 First set of items.
@@ -132,28 +174,57 @@ private:
     /// @param[in] boxes0 First set's boxes.
     /// @param[in] boxes1 Second set's boxes.
     /// @param[in] can_collide Function to determine if two items can collide.
-    /// @param[out] candidates The candidate collisions.
+    /// @param[out] buffers Thread-local buffers of the candidate collisions.
     template <typename Candidate>
     void detect_candidates(
         const std::vector<HashItem>& items0,
         const std::vector<HashItem>& items1,
-        const std::vector<AABB>& boxes0,
-        const std::vector<AABB>& boxes1,
+        const AABBs& boxes0,
+        const AABBs& boxes1,
         const std::function<bool(size_t, size_t)>& can_collide,
-        std::vector<Candidate>& candidates) const;
+        CandidateBuffers<Candidate>& buffers) const;
 
     /// @brief Find the candidate collisions among a set of items.
     /// @tparam Candidate The type of collision candidate.
     /// @param[in] items The set of items.
     /// @param[in] boxes The items' boxes.
     /// @param[in] can_collide Function to determine if two items can collide.
-    /// @param[out] candidates The candidate collisions.
+    /// @param[out] buffers Thread-local buffers of the candidate collisions.
     template <typename Candidate>
     void detect_candidates(
         const std::vector<HashItem>& items,
-        const std::vector<AABB>& boxes,
+        const AABBs& boxes,
+        const std::function<bool(size_t, size_t)>& can_collide,
+        CandidateBuffers<Candidate>& buffers) const;
+
+    /// @brief Find the candidate collisions among the pairs of cell blocks.
+    /// @tparam Candidate The type of collision candidate.
+    /// @tparam triangular Whether the two sets are the same (only pairs with row < col are considered).
+    /// @param[in] blocks The blocks of pairs sharing a cell.
+    /// @param[in] items0 First set of items.
+    /// @param[in] items1 Second set of items.
+    /// @param[in] boxes0 First set's boxes.
+    /// @param[in] boxes1 Second set's boxes.
+    /// @param[in] can_collide Function to determine if two items can collide.
+    /// @param[out] buffers Thread-local buffers of the candidate collisions.
+    template <typename Candidate, bool triangular>
+    void detect_candidates(
+        const std::vector<CellBlock>& blocks,
+        const std::vector<HashItem>& items0,
+        const std::vector<HashItem>& items1,
+        const AABBs& boxes0,
+        const AABBs& boxes1,
         const std::function<bool(size_t, size_t)>& can_collide,
-        std::vector<Candidate>& candidates) const;
+        CandidateBuffers<Candidate>& buffers) const;
+
+    /// @brief Split the pairs of a cell into blocks of bounded size.
+    static void split_cell(
+        const long key,
+        const size_t row_begin,
+        const size_t row_end,
+        const size_t col_begin,
+        const size_t col_end,
+        std::vector<CellBlock>& blocks);
 
 protected:
     double m_cell_size;
@@ -5,7 +5,6 @@
 #include <ipc/config.hpp>
 #include <ipc/broad_phase/voxel_size_heuristic.hpp>
 #include <ipc/ccd/aabb.hpp>
-#include <ipc/utils/merge_thread_local.hpp>
 
 #include <tbb/enumerable_thread_specific.h>
 #include <tbb/parallel_for.h>
@@ -16,56 +15,13 @@ using namespace std::placeholders;
 namespace ipc {
 
 namespace {
-    inline void tbb_parallel_block_range_for(
-        const size_t start_i,
-        const size_t end_i,
-        const std::function<void(size_t)>& body)
-    {
-        tbb::parallel_for(
-            tbb::blocked_range(start_i, end_i),
-            [&](const tbb::blocked_range<size_t>& range) {
-                for (size_t i = range.begin(); i != range.end(); i++) {
-                    body(i);
-                }
-            });
-    }
-
-    void fill_primitive_to_voxels(
+    /// @brief Number of voxels in the box [min_voxel, max_voxel].
+    inline size_t voxel_box_size(
         Eigen::ConstRef<Eigen::Array3i> min_voxel,
-        Eigen::ConstRef<Eigen::Array3i> max_voxel,
-        Eigen::ConstRef<ArrayMax3i> voxel_count,
-        const int voxel_count_0x1,
-        std::vector<int>& primitive_to_voxels)
+        Eigen::ConstRef<Eigen::Array3i> max_voxel)
     {
         assert((min_voxel <= max_voxel).all());
-        assert(voxel_count_0x1 == voxel_count[0] * voxel_count[1]);
-
-        primitive_to_voxels.reserve((max_voxel - min_voxel + 1).prod());
-
-        for (int iz = min_voxel[2]; iz <= max_voxel[2]; iz++) {
-            int z_offset = iz * voxel_count_0x1;
-
-            for (int iy = min_voxel[1]; iy <= max_voxel[1]; iy++) {
-                int yz_offset = iy * voxel_count[0] + z_offset;
-
-                for (int ix = min_voxel[0]; ix <= max_voxel[0]; ix++) {
-                    primitive_to_voxels.emplace_back(ix + yz_offset);
-                }
-            }
-        }
-    }
-
-    void fill_voxel_to_primitives(
-        const size_t num_primitives,
-        const size_t primitive_offset,
-        const std::vector<std::vector<int>>& primitive_to_voxels,
-        unordered_map<int, std::vector<int>>& voxel_to_primitives)
-    {
-        for (int i = 0; i < num_primitives; i++) {
-            for (const auto& voxel : primitive_to_voxels[i]) {
-                voxel_to_primitives[voxel].emplace_back(i + primitive_offset);
-            }
-        }
+        return (max_voxel - min_voxel + 1).cast<size_t>().prod();
     }
 } // namespace
 
@@ -140,127 +96,186 @@ void SpatialHash::build(
     });
 
     // ------------------------------------------------------------------------
+    // voxel boxes of all primitives
 
-    point_to_voxels.resize(num_vertices);
-    tbb_parallel_block_range_for(0, num_vertices, [&](size_t vi) {
-        fill_primitive_to_voxels(
-            vertex_min_voxel_axis_index[vi], vertex_max_voxel_axis_index[vi],
-            voxel_count, voxel_count_0x1, point_to_voxels[vi]);
+    edge_start_ind = num_vertices;
+    tri_start_ind = edge_start_ind + edges.rows();
+    const size_t n_primitives = tri_start_ind + faces.rows();
+
+    std::vector<Eigen::Array3i> min_voxel_axis_index(
+        std::move(vertex_min_voxel_axis_index));
+    std::vector<Eigen::Array3i> max_voxel_axis_index(
+        std::move(vertex_max_voxel_axis_index));
+    min_voxel_axis_index.resize(n_primitives);
+    max_voxel_axis_index.resize(n_primitives);
+
+    tbb::parallel_for(size_t(0), size_t(edges.rows()), [&](size_t ei) {
+        min_voxel_axis_index[edge_start_ind + ei] =
+            min_voxel_axis_index[edges(ei, 0)].min(
+                min_voxel_axis_index[edges(ei, 1)]);
+        max_voxel_axis_index[edge_start_ind + ei] =
+            max_voxel_axis_index[edges(ei, 0)].max(
+                max_voxel_axis_index[edges(ei, 1)]);
     });
 
-    edge_to_voxels.resize(edges.rows());
-    tbb_parallel_block_range_for(0, edges.rows(), [&](size_t ei) {
-        fill_primitive_to_voxels(
-            vertex_min_voxel_axis_index[edges(ei, 0)].min(
-                vertex_min_voxel_axis_index[edges(ei, 1)]),
-            vertex_max_voxel_axis_index[edges(ei, 0)].max(
-                vertex_max_voxel_axis_index[edges(ei, 1)]),
-            voxel_count, voxel_count_0x1, edge_to_voxels[ei]);
+    tbb::parallel_for(size_t(0), size_t(faces.rows()), [&](size_t fi) {
+        min_voxel_axis_index[tri_start_ind + fi] =
+            min_voxel_axis_index[faces(fi, 0)]
+                .min(min_voxel_axis_index[faces(fi, 1)])
+                .min(min_voxel_axis_index[faces(fi, 2)]);
+        max_voxel_axis_index[tri_start_ind + fi] =
+            max_voxel_axis_index[faces(fi, 0)]
+                .max(max_voxel_axis_index[faces(fi, 1)])
+                .max(max_voxel_axis_index[faces(fi, 2)]);
     });
 
-    face_to_voxels.resize(faces.rows());
-    tbb_parallel_block_range_for(0, faces.rows(), [&](size_t fi) {
-        fill_primitive_to_voxels(
-            vertex_min_voxel_axis_index[faces(fi, 0)]
-                .min(vertex_min_voxel_axis_index[faces(fi, 1)])
-                .min(vertex_min_voxel_axis_index[faces(fi, 2)]),
-            vertex_max_voxel_axis_index[faces(fi, 0)]
-                .max(vertex_max_voxel_axis_index[faces(fi, 1)])
-                .max(vertex_max_voxel_axis_index[faces(fi, 2)]),
-            voxel_count, voxel_count_0x1, face_to_voxels[fi]);
+    // ------------------------------------------------------------------------
+    // primitive -> voxels (CSR offsets by prefix sum of the box sizes)
+
+    primitive_voxels_offsets.resize(n_primitives + 1);
+    primitive_voxels_offsets[0] = 0;
+    for (size_t i = 0; i < n_primitives; i++) {
+        primitive_voxels_offsets[i + 1] = primitive_voxels_offsets[i]
+            + voxel_box_size(min_voxel_axis_index[i], max_voxel_axis_index[i]);
+    }
+
+    // (voxel, primitive) pairs sorted by voxel then by primitive
+    std::vector<std::pair<int, int>> voxel_primitive_pairs(
+        primitive_voxels_offsets.back());
+    tbb::parallel_for(size_t(0), n_primitives, [&](size_t i) {
+        const Eigen::Array3i& min_voxel = min_voxel_axis_index[i];
+        const Eigen::Array3i& max_voxel = max_voxel_axis_index[i];
+        size_t k = primitive_voxels_offsets[i];
+        for (int iz = min_voxel[2]; iz <= max_voxel[2]; iz++) {
+            for (int iy = min_voxel[1]; iy <= max_voxel[1]; iy++) {
+                const int yz_offset =
+                    iy * voxel_count[0] + iz * voxel_count_0x1;
+                for (int ix = min_voxel[0]; ix <= max_voxel[0]; ix++) {
+                    voxel_primitive_pairs[k++] = { ix + yz_offset, int(i) };
+                }
+            }
+        }
     });
+    tbb::parallel_sort(voxel_primitive_pairs);
 
     // ------------------------------------------------------------------------
+    // voxel -> primitives (CSR over the occupied voxels)
 
-    edge_start_ind = num_vertices;
-    tri_start_ind = edge_start_ind + edges.rows();
+    voxel_primitives.resize(voxel_primitive_pairs.size());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), voxel_primitive_pairs.size()),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t k = r.begin(); k < r.end(); k++) {
+                voxel_primitives[k] = voxel_primitive_pairs[k].second;
+            }
+        });
 
-    fill_voxel_to_primitives(
-        num_vertices, 0, point_to_voxels, voxel_to_primitives);
-    fill_voxel_to_primitives(
-        edges.rows(), edge_start_ind, edge_to_voxels, voxel_to_primitives);
-    fill_voxel_to_primitives(
-        faces.rows(), tri_start_ind, face_to_voxels, voxel_to_primitives);
+    for (size_t k = 0; k < voxel_primitive_pairs.size(); k++) {
+        if (k == 0
+            || voxel_primitive_pairs[k].first
+                != voxel_primitive_pairs[k - 1].first) {
+            occupied_voxels.push_back(voxel_primitive_pairs[k].first);
+            voxel_primitives_offsets.push_back(k);
+        }
+    }
+    voxel_primitives_offsets.push_back(voxel_primitive_pairs.size());
+
+    // ------------------------------------------------------------------------
+    // primitive -> occupied voxel indices
+
+    // Every voxel of a primitive's box is occupied (by the primitive itself),
+    // so each row of the box maps to a contiguous range of occupied voxels.
+    primitive_voxels.resize(primitive_voxels_offsets.back());
+    tbb::parallel_for(size_t(0), n_primitives, [&](size_t i) {
+        const Eigen::Array3i& min_voxel = min_voxel_axis_index[i];
+        const Eigen::Array3i& max_voxel = max_voxel_axis_index[i];
+        size_t k = primitive_voxels_offsets[i];
+        for (int iz = min_voxel[2]; iz <= max_voxel[2]; iz++) {
+            for (int iy = min_voxel[1]; iy <= max_voxel[1]; iy++) {
+                const int row_start = min_voxel[0] + iy * voxel_count[0]
+                    + iz * voxel_count_0x1;
+                int voxel = std::lower_bound(
+                                occupied_voxels.begin(), occupied_voxels.end(),
+                                row_start)
+                    - occupied_voxels.begin();
+                assert(occupied_voxels[voxel] == row_start);
+                for (int ix = min_voxel[0]; ix <= max_voxel[0]; ix++) {
+                    primitive_voxels[k++] = voxel++;
+                }
+            }
+        }
+    });
 }
 
-void SpatialHash::query_point_for_points(
-    int vi, unordered_set<int>& vert_ids) const
+void SpatialHash::query_primitive_for_primitives(
+    int primitive,
+    int min_id,
+    int max_id,
+    int offset,
+    std::vector<int>& ids) const
 {
-    vert_ids.clear();
-    for (const int voxel : point_to_voxels[vi]) {
-        for (const int id : voxel_to_primitives.at(voxel)) {
-            if (is_vertex_index(id) && id > vi) {
-                vert_ids.insert(id);
-            }
+    ids.clear();
+    for (size_t k = primitive_voxels_offsets[primitive];
+         k < primitive_voxels_offsets[primitive + 1]; k++) {
+        const int voxel = primitive_voxels[k];
+        const auto end =
+            voxel_primitives.begin() + voxel_primitives_offsets[voxel + 1];
+        // Primitives are sorted within a voxel, so skip to min_id.
+        for (auto it = std::lower_bound(
+                 voxel_primitives.begin() + voxel_primitives_offsets[voxel],
+                 end, min_id);
+             it != end && *it < max_id; ++it) {
+            ids.push_back(*it - offset);
         }
     }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+void SpatialHash::query_point_for_points(
+    int vi, std::vector<int>& vert_ids) const
+{
+    query_primitive_for_primitives(vi, vi + 1, edge_start_ind, 0, vert_ids);
 }
 
 void SpatialHash::query_point_for_edges(
-    int vi, unordered_set<int>& edge_ids) const
+    int vi, std::vector<int>& edge_ids) const
 {
-    edge_ids.clear();
-    for (const int voxel : point_to_voxels[vi]) {
-        for (const int id : voxel_to_primitives.at(voxel)) {
-            if (is_edge_index(id)) {
-                edge_ids.insert(to_edge_index(id));
-            }
-        }
-    }
+    query_primitive_for_primitives(
+        vi, edge_start_ind, tri_start_ind, edge_start_ind, edge_ids);
 }
 
 void SpatialHash::query_point_for_triangles(
-    int vi, unordered_set<int>& tri_ids) const
+    int vi, std::vector<int>& tri_ids) const
 {
-    tri_ids.clear();
-    for (const int voxel : point_to_voxels[vi]) {
-        for (const int id : voxel_to_primitives.at(voxel)) {
-            if (is_triangle_index(id)) {
-                tri_ids.insert(to_triangle_index(id));
-            }
-        }
-    }
+    query_primitive_for_primitives(
+        vi, tri_start_ind, num_primitives(), tri_start_ind, tri_ids);
 }
 
 // will only put edges with larger than eai index into edge_ids
 void SpatialHash::query_edge_for_edges(
-    int eai, unordered_set<int>& edge_ids) const
+    int eai, std::vector<int>& edge_ids) const
 {
-    edge_ids.clear();
-    for (const int voxel : edge_to_voxels[eai]) {
-        for (const int id : voxel_to_primitives.at(voxel)) {
-            if (is_edge_index(id) && to_edge_index(id) > eai) {
-                edge_ids.insert(to_edge_index(id));
-            }
-        }
-    }
+    query_primitive_for_primitives(
+        edge_start_ind + eai, edge_start_ind + eai + 1, tri_start_ind,
+        edge_start_ind, edge_ids);
 }
 
 void SpatialHash::query_edge_for_triangles(
-    int ei, unordered_set<int>& tri_ids) const
+    int ei, std::vector<int>& tri_ids) const
 {
-    tri_ids.clear();
-    for (const int voxel : edge_to_voxels[ei]) {
-        for (const auto& id : voxel_to_primitives.at(voxel)) {
-            if (is_triangle_index(id)) {
-                tri_ids.insert(to_triangle_index(id));
-            }
-        }
-    }
+    query_primitive_for_primitives(
+        edge_start_ind + ei, tri_start_ind, num_primitives(), tri_start_ind,
+        tri_ids);
 }
 
 // will only put triangles with larger than fai index into tri_ids
 void SpatialHash::query_triangle_for_triangles(
-    int fai, unordered_set<int>& tri_ids) const
+    int fai, std::vector<int>& tri_ids) const
 {
-    tri_ids.clear();
-    for (const int voxel : face_to_voxels[fai]) {
-        for (const auto& id : voxel_to_primitives.at(voxel)) {
-            if (is_triangle_index(id) && to_triangle_index(id) > fai) {
-                tri_ids.insert(to_triangle_index(id));
-            }
-        }
-    }
+    query_primitive_for_primitives(
+        tri_start_ind + fai, tri_start_ind + fai + 1, num_primitives(),
+        tri_start_ind, tri_ids);
 }
 
 // ============================================================================
@@ -268,21 +283,22 @@ void SpatialHash::query_triangle_for_triangles(
 
 template <typename Candidate, bool swap_order, bool triangular>
 void SpatialHash::detect_candidates(
-    const std::vector<AABB>& boxesA,
-    const std::vector<AABB>& boxesB,
-    const std::function<void(int, unordered_set<int>&)>& query_A_for_Bs,
+    const AABBs& boxesA,
+    const AABBs& boxesB,
+    const std::function<void(int, std::vector<int>&)>& query_A_for_Bs,
     const std::function<bool(int, int)>& can_collide,
-    std::vector<Candidate>& candidates) const
+    CandidateBuffers<Candidate>& buffers) const
 {
-    tbb::enumerable_thread_specific<std::vector<Candidate>> storage;
+    // Query results are reused across primitives to avoid allocations.
+    tbb::enumerable_thread_specific<std::vector<int>> query_storage;
 
     tbb::parallel_for(
         tbb::blocked_range<size_t>(size_t(0), boxesA.size()),
         [&](const tbb::blocked_range<size_t>& range) {
-            auto& local_candidates = storage.local();
+            auto& local_candidates = buffers.local();
+            auto& js = query_storage.local();
 
             for (size_t i = range.begin(); i != range.end(); i++) {
-                unordered_set<int> js;
                 query_A_for_Bs(i, js);
 
                 for (const int j : js) {
@@ -301,29 +317,89 @@ void SpatialHash::detect_candidates(
                         continue;
                     }
 
-                    if (boxesA[i].intersects(boxesB[j])) {
+                    if (boxesA.intersects(i, boxesB, j)) {
                         local_candidates.emplace_back(ai, bi);
                     }
                 }
             }
         });
-
-    merge_thread_local_vectors(storage, candidates);
 }
 
 template <typename Candidate>
 void SpatialHash::detect_candidates(
-    const std::vector<AABB>& boxesA,
-    const std::function<void(int, unordered_set<int>&)>& query_A_for_As,
+    const AABBs& boxesA,
+    const std::function<void(int, std::vector<int>&)>& query_A_for_As,
     const std::function<bool(int, int)>& can_collide,
-    std::vector<Candidate>& candidates) const
+    CandidateBuffers<Candidate>& buffers) const
 {
     detect_candidates<Candidate, /*swap_order=*/false, /*triangular=*/true>(
-        boxesA, boxesA, query_A_for_As, can_collide, candidates);
+        boxesA, boxesA, query_A_for_As, can_collide, buffers);
 }
 
 void SpatialHash::detect_vertex_vertex_candidates(
     std::vector<VertexVertexCandidate>& candidates) const
+{
+    CandidateBuffers<VertexVertexCandidate> buffers;
+    detect_vertex_vertex_candidates(buffers);
+    buffers.merge(candidates);
+}
+
+void SpatialHash::detect_edge_vertex_candidates(
+    std::vector<EdgeVertexCandidate>& candidates) const
+{
+    CandidateBuffers<EdgeVertexCandidate> buffers;
+    detect_edge_vertex_candidates(buffers);
+    buffers.merge(candidates);
+}
+
+void SpatialHash::detect_edge_edge_candidates(
+    std::vector<EdgeEdgeCandidate>& candidates) const
+{
+    CandidateBuffers<EdgeEdgeCandidate> buffers;
+    detect_edge_edge_candidates(buffers);
+    buffers.merge(candidates);
+}
+
+void SpatialHash::detect_face_vertex_candidates(
+    std::vector<FaceVertexCandidate>& candidates) const
+{
+    CandidateBuffers<FaceVertexCandidate> buffers;
+    detect_face_vertex_candidates(buffers);
+    buffers.merge(candidates);
+}
+
+void SpatialHash::detect_edge_face_candidates(
+    std::vector<EdgeFaceCandidate>& candidates) const
+{
+    if (edge_boxes.size() == 0 || face_boxes.size() == 0) {
+        return;
+    }
+
+    CandidateBuffers<EdgeFaceCandidate> buffers;
+    detect_candidates<EdgeFaceCandidate, /*swap_order=*/false>(
+        edge_boxes, face_boxes,
+        std::bind(&SpatialHash::query_edge_for_triangles, this, _1, _2),
+        std::bind(&SpatialHash::can_edge_face_collide, this, _1, _2), buffers);
+    buffers.merge(candidates);
+}
+
+void SpatialHash::detect_face_face_candidates(
+    std::vector<FaceFaceCandidate>& candidates) const
+{
+    if (face_boxes.size() == 0) {
+        return;
+    }
+
+    CandidateBuffers<FaceFaceCandidate> buffers;
+    detect_candidates(
+        face_boxes,
+        std::bind(&SpatialHash::query_triangle_for_triangles, this, _1, _2),
+        std::bind(&SpatialHash::can_faces_collide, this, _1, _2), buffers);
+    buffers.merge(candidates);
+}
+
+void SpatialHash::detect_vertex_vertex_candidates(
+    CandidateBuffers<VertexVertexCandidate>& buffers) const
 {
     if (vertex_boxes.size() == 0) {
         return;
@@ -332,11 +408,11 @@ void SpatialHash::detect_vertex_vertex_candidates(
     detect_candidates(
         vertex_boxes,
         std::bind(&SpatialHash::query_point_for_points, this, _1, _2),
-        can_vertices_collide, candidates);
+        can_vertices_collide, buffers);
 }
 
 void SpatialHash::detect_edge_vertex_candidates(
-    std::vector<EdgeVertexCandidate>& candidates) const
+    CandidateBuffers<EdgeVertexCandidate>& buffers) const
 {
     if (edge_boxes.size() == 0 || vertex_boxes.size() == 0) {
         return;
@@ -346,11 +422,11 @@ void SpatialHash::detect_edge_vertex_candidates(
         vertex_boxes, edge_boxes,
         std::bind(&SpatialHash::query_point_for_edges, this, _1, _2),
         std::bind(&SpatialHash::can_edge_vertex_collide, this, _1, _2),
-        candidates);
+        buffers);
 }
 
 void SpatialHash::detect_edge_edge_candidates(
-    std::vector<EdgeEdgeCandidate>& candidates) const
+    CandidateBuffers<EdgeEdgeCandidate>& buffers) const
 {
     if (edge_boxes.size() == 0) {
         return;
@@ -358,11 +434,11 @@ void SpatialHash::detect_edge_edge_candidates(
 
     detect_candidates(
         edge_boxes, std::bind(&SpatialHash::query_edge_for_edges, this, _1, _2),
-        std::bind(&SpatialHash::can_edges_collide, this, _1, _2), candidates);
+        std::bind(&SpatialHash::can_edges_collide, this, _1, _2), buffers);
 }
 
 void SpatialHash::detect_face_vertex_candidates(
-    std::vector<FaceVertexCandidate>& candidates) const
+    CandidateBuffers<FaceVertexCandidate>& buffers) const
 {
     if (face_boxes.size() == 0 || vertex_boxes.size() == 0) {
         return;
@@ -373,34 +449,7 @@ void SpatialHash::detect_face_vertex_candidates(
         vertex_boxes, face_boxes,
         std::bind(&SpatialHash::query_point_for_triangles, this, _1, _2),
         std::bind(&SpatialHash::can_face_vertex_collide, this, _1, _2),
-        candidates);
-}
-
-void SpatialHash::detect_edge_face_candidates(
-    std::vector<EdgeFaceCandidate>& candidates) const
-{
-    if (edge_boxes.size() == 0 || face_boxes.size() == 0) {
-        return;
-    }
-
-    detect_candidates<EdgeFaceCandidate, /*swap_order=*/false>(
-        edge_boxes, face_boxes,
-        std::bind(&SpatialHash::query_edge_for_triangles, this, _1, _2),
-        std::bind(&SpatialHash::can_edge_face_collide, this, _1, _2),
-        candidates);
-}
-
-void SpatialHash::detect_face_face_candidates(
-    std::vector<FaceFaceCandidate>& candidates) const
-{
-    if (face_boxes.size() == 0) {
-        return;
-    }
-
-    detect_candidates(
-        face_boxes,
-        std::bind(&SpatialHash::query_triangle_for_triangles, this, _1, _2),
-        std::bind(&SpatialHash::can_faces_collide, this, _1, _2), candidates);
+        buffers);
 }
 
 // ============================================================================
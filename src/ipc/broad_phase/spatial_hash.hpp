@@ -4,7 +4,6 @@
 
 #include <ipc/broad_phase/broad_phase.hpp>
 #include <ipc/utils/eigen_ext.hpp>
-#include <ipc/utils/unordered_map_and_set.hpp>
 
 #include <vector>
 
@@ -32,17 +31,20 @@ public: // data
     // // The index of the first triangle in voxel_occupancies
     int tri_start_ind;
 
-    /// @brief Map from voxel index to the primitive indices it contains.
-    unordered_map<int, std::vector<int>> voxel_to_primitives;
+    /// @brief Sorted indices of the voxels occupied by at least one primitive.
+    std::vector<int> occupied_voxels;
 
-    /// @brief Map from point index to the voxel indices it occupies.
-    std::vector<std::vector<int>> point_to_voxels;
+    /// @brief Start of each occupied voxel's primitives in voxel_primitives.
+    std::vector<size_t> voxel_primitives_offsets;
 
-    /// @brief Map from edge index to the voxel indices it occupies.
-    std::vector<std::vector<int>> edge_to_voxels;
+    /// @brief Primitive indices contained in each occupied voxel (sorted per voxel).
+    std::vector<int> voxel_primitives;
 
-    /// @brief Map from face index to the voxel indices it occupies.
-    std::vector<std::vector<int>> face_to_voxels;
+    /// @brief Start of each primitive's voxels in primitive_voxels.
+    std::vector<size_t> primitive_voxels_offsets;
+
+    /// @brief Occupied voxels (as indices into occupied_voxels) of each primitive.
+    std::vector<int> primitive_voxels;
 
 protected:
     int dim;
@@ -118,10 +120,19 @@ public: // API
     void clear() override
     {
         BroadPhase::clear();
-        voxel_to_primitives.clear();
-        point_to_voxels.clear();
-        edge_to_voxels.clear();
-        face_to_voxels.clear();
+        occupied_voxels.clear();
+        voxel_primitives_offsets.clear();
+        voxel_primitives.clear();
+        primitive_voxels_offsets.clear();
+        primitive_voxels.clear();
+    }
+
+    /// @brief Get the number of primitives (vertices, edges, and triangles).
+    inline int num_primitives() const
+    {
+        return primitive_voxels_offsets.empty()
+            ? 0
+            : (primitive_voxels_offsets.size() - 1);
     }
 
     /// @brief Check if primitive index refers to a vertex.
@@ -181,21 +192,54 @@ public: // API
     void detect_face_face_candidates(
         std::vector<FaceFaceCandidate>& candidates) const override;
 
+protected: // API
+    /// @brief Find the candidate vertex-vertex collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_vertex_vertex_candidates(
+        CandidateBuffers<VertexVertexCandidate>& buffers) const override;
+
+    /// @brief Find the candidate edge-vertex collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_edge_vertex_candidates(
+        CandidateBuffers<EdgeVertexCandidate>& buffers) const override;
+
+    /// @brief Find the candidate edge-edge collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_edge_edge_candidates(
+        CandidateBuffers<EdgeEdgeCandidate>& buffers) const override;
+
+    /// @brief Find the candidate face-vertex collisions.
+    /// @param[out] buffers Thread-local buffers of the candidates.
+    void detect_face_vertex_candidates(
+        CandidateBuffers<FaceVertexCandidate>& buffers) const override;
+
 protected: // helper functions
-    void query_point_for_points(int vi, unordered_set<int>& vert_inds) const;
+    void query_point_for_points(int vi, std::vector<int>& vert_ids) const;
+
+    void query_point_for_edges(int vi, std::vector<int>& edge_ids) const;
 
-    void query_point_for_edges(int vi, unordered_set<int>& edge_inds) const;
+    void query_point_for_triangles(int vi, std::vector<int>& tri_ids) const;
 
-    void query_point_for_triangles(int vi, unordered_set<int>& tri_inds) const;
+    // will only put edges with larger than ei index into edge_ids
+    void query_edge_for_edges(int eai, std::vector<int>& edge_ids) const;
 
-    // will only put edges with larger than ei index into edge_inds
-    void query_edge_for_edges(int eai, unordered_set<int>& edge_inds) const;
+    void query_edge_for_triangles(int ei, std::vector<int>& tri_ids) const;
 
-    void query_edge_for_triangles(int ei, unordered_set<int>& tri_inds) const;
+    // will only put triangles with larger than ti index into tri_ids
+    void query_triangle_for_triangles(int ti, std::vector<int>& tri_ids) const;
 
-    // will only put triangles with larger than ti index into tri_inds
-    void
-    query_triangle_for_triangles(int ti, unordered_set<int>& tri_inds) const;
+    /// @brief Find the primitives in [min_id, max_id) that share a voxel with a primitive.
+    /// @param[in] primitive The primitive index to query.
+    /// @param[in] min_id The smallest primitive index to return.
+    /// @param[in] max_id One past the largest primitive index to return.
+    /// @param[in] offset Value subtracted from each returned primitive index.
+    /// @param[out] ids The sorted and unique primitive indices minus offset.
+    void query_primitive_for_primitives(
+        int primitive,
+        int min_id,
+        int max_id,
+        int offset,
+        std::vector<int>& ids) const;
 
     int locate_voxel_index(Eigen::ConstRef<VectorMax3d> p) const;
 
@@ -222,27 +266,27 @@ private:
     /// @param[in] boxesB The boxes of type B to detect collisions with.
     /// @param[in] query_A_for_Bs Function to query boxes of type B for boxes of type A.
     /// @param[in] can_collide Function to determine if two primitives can collide given their ids.
-    /// @param[out] candidates The candidate collisions.
+    /// @param[out] buffers Thread-local buffers of the candidate collisions.
     template <typename Candidate, bool swap_order, bool triangular = false>
     void detect_candidates(
-        const std::vector<AABB>& boxesA,
-        const std::vector<AABB>& boxesB,
-        const std::function<void(int, unordered_set<int>&)>& query_A_for_Bs,
+        const AABBs& boxesA,
+        const AABBs& boxesB,
+        const std::function<void(int, std::vector<int>&)>& query_A_for_Bs,
         const std::function<bool(int, int)>& can_collide,
-        std::vector<Candidate>& candidates) const;
+        CandidateBuffers<Candidate>& buffers) const;
 
     /// @brief Detect candidate collisions between type A and type A.
     /// @tparam Candidate Type of candidate collision.
     /// @param[in] boxesA The boxes of type A to detect collisions with.
     /// @param[in] query_A_for_As Function to query boxes of type A for boxes of type A.
     /// @param[in] can_collide Function to determine if two primitives can collide given their ids.
-    /// @param[out] candidates The candidate collisions.
+    /// @param[out] buffers Thread-local buffers of the candidate collisions.
     template <typename Candidate>
     void detect_candidates(
-        const std::vector<AABB>& boxesA,
-        const std::function<void(int, unordered_set<int>&)>& query_A_for_As,
+        const AABBs& boxesA,
+        const std::function<void(int, std::vector<int>&)>& query_A_for_As,
         const std::function<bool(int, int)>& can_collide,
-        std::vector<Candidate>& candidates) const;
+        CandidateBuffers<Candidate>& buffers) const;
 };
 
 } // namespace ipc
@@ -1,198 +1,201 @@
 #include "sweep_and_prune.hpp"
 
-#include <scalable_ccd/broad_phase/sort_and_sweep.hpp>
+#include <ipc/utils/merge_thread_local.hpp>
 
-namespace ipc {
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_sort.h>
 
-void SweepAndPrune::build(
-    Eigen::ConstRef<Eigen::MatrixXd> vertices,
-    Eigen::ConstRef<Eigen::MatrixXi> edges,
-    Eigen::ConstRef<Eigen::MatrixXi> faces,
-    const double inflation_radius)
-{
-    assert(edges.size() == 0 || edges.cols() == 2);
-    assert(faces.size() == 0 || faces.cols() == 3);
+using namespace std::placeholders;
 
-    clear();
+namespace ipc {
 
-    scalable_ccd::build_vertex_boxes(vertices, vertex_boxes, inflation_radius);
-    scalable_ccd::build_edge_boxes(vertex_boxes, edges, edge_boxes);
-    scalable_ccd::build_face_boxes(vertex_boxes, faces, face_boxes);
-}
+namespace {
+    /// @brief Extent of a box along the sort axis.
+    struct SweepItem {
+        double min;
+        double max;
+        /// @brief Id of the box. Boxes of the first of two distinct sets are
+        /// stored as -(id + 1).
+        long id;
+
+        bool operator<(const SweepItem& other) const
+        {
+            return min < other.min || (min == other.min && id < other.id);
+        }
+    };
+
+    /// @brief Sum and squared sum of the box centers.
+    using CenterMoments = std::pair<Eigen::Array3d, Eigen::Array3d>;
+
+    CenterMoments center_moments(const AABBs& boxes)
+    {
+        return tbb::parallel_reduce(
+            tbb::blocked_range<size_t>(size_t(0), boxes.size()),
+            CenterMoments(Eigen::Array3d::Zero(), Eigen::Array3d::Zero()),
+            [&](const tbb::blocked_range<size_t>& r, CenterMoments moments) {
+                for (int d = 0; d < boxes.dim(); d++) {
+                    for (size_t i = r.begin(); i < r.end(); i++) {
+                        const double c =
+                            0.5 * (boxes.min[d][i] + boxes.max[d][i]);
+                        moments.first[d] += c;
+                        moments.second[d] += c * c;
+                    }
+                }
+                return moments;
+            },
+            [](const CenterMoments& a, const CenterMoments& b) {
+                return CenterMoments(a.first + b.first, a.second + b.second);
+            });
+    }
+} // namespace
 
-void SweepAndPrune::build(
-    Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
-    Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
-    Eigen::ConstRef<Eigen::MatrixXi> edges,
-    Eigen::ConstRef<Eigen::MatrixXi> faces,
-    const double inflation_radius)
+int SweepAndPrune::select_sort_axis(const AABBs& boxes0, const AABBs& boxes1)
 {
-    assert(edges.size() == 0 || edges.cols() == 2);
-    assert(faces.size() == 0 || faces.cols() == 3);
+    assert(boxes0.dim() == boxes1.dim());
+
+    CenterMoments moments = center_moments(boxes0);
+    size_t n = boxes0.size();
+    if (&boxes0 != &boxes1) {
+        const CenterMoments moments1 = center_moments(boxes1);
+        moments.first += moments1.first;
+        moments.second += moments1.second;
+        n += boxes1.size();
+    }
+    assert(n > 0);
 
-    clear();
+    const Eigen::Array3d mean = moments.first / n;
+    const Eigen::Array3d variance = moments.second / n - mean.square();
 
-    scalable_ccd::build_vertex_boxes(
-        vertices_t0, vertices_t1, vertex_boxes, inflation_radius);
-    scalable_ccd::build_edge_boxes(vertex_boxes, edges, edge_boxes);
-    scalable_ccd::build_face_boxes(vertex_boxes, faces, face_boxes);
+    int axis;
+    variance.head(boxes0.dim()).maxCoeff(&axis);
+    return axis;
 }
 
-void SweepAndPrune::clear()
+template <typename Candidate, bool triangular>
+void SweepAndPrune::detect_candidates(
+    const AABBs& boxes0,
+    const AABBs& boxes1,
+    const std::function<bool(size_t, size_t)>& can_collide,
+    std::vector<Candidate>& candidates)
 {
-    BroadPhase::clear();
-    vertex_boxes.clear();
-    edge_boxes.clear();
-    face_boxes.clear();
+    assert(!triangular || &boxes0 == &boxes1);
+    if (boxes0.empty() || boxes1.empty()) {
+        return;
+    }
+
+    const int axis = select_sort_axis(boxes0, boxes1);
+
+    // 1. Sort the boxes of both sets by their minimum along the axis.
+    const size_t n0 = boxes0.size();
+    const size_t n = triangular ? n0 : (n0 + boxes1.size());
+    std::vector<SweepItem> items(n);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), n),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                if (i < n0) {
+                    items[i] = { boxes0.min[axis][i], boxes0.max[axis][i],
+                                 triangular ? long(i) : -long(i) - 1 };
+                } else {
+                    const size_t j = i - n0;
+                    items[i] = { boxes1.min[axis][j], boxes1.max[axis][j],
+                                 long(j) };
+                }
+            }
+        });
+    tbb::parallel_sort(items.begin(), items.end());
+
+    // 2. Sweep: every box is compared to the boxes that start before it ends.
+    // Each box's sweep is independent, so the sorted list is partitioned
+    // between threads.
+    tbb::enumerable_thread_specific<std::vector<Candidate>> storage;
+
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), n),
+        [&](const tbb::blocked_range<size_t>& r) {
+            auto& local_candidates = storage.local();
+
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                const SweepItem& a = items[i];
+                for (size_t j = i + 1; j < n && items[j].min <= a.max; j++) {
+                    const SweepItem& b = items[j];
+
+                    long id0, id1;
+                    if constexpr (triangular) {
+                        id0 = std::min(a.id, b.id);
+                        id1 = std::max(a.id, b.id);
+                    } else {
+                        if ((a.id < 0) == (b.id < 0)) {
+                            continue; // Both boxes are from the same set
+                        }
+                        id0 = a.id < 0 ? -(a.id + 1) : -(b.id + 1);
+                        id1 = a.id < 0 ? b.id : a.id;
+                    }
+
+                    if (boxes0.intersects(id0, boxes1, id1)
+                        && can_collide(id0, id1)) {
+                        local_candidates.emplace_back(id0, id1);
+                    }
+                }
+            }
+        });
+
+    merge_thread_local_vectors(storage, candidates);
 }
 
 void SweepAndPrune::detect_vertex_vertex_candidates(
     std::vector<VertexVertexCandidate>& candidates) const
 {
-    std::vector<std::pair<int, int>> overlaps;
-    scalable_ccd::sort_and_sweep(vertex_boxes, vv_sort_axis, overlaps);
-
-    for (const auto& [vai, vbi] : overlaps) {
-        if (can_vertices_collide(vai, vbi)) {
-            candidates.emplace_back(vai, vbi);
-        }
-    }
+    detect_candidates<VertexVertexCandidate, /*triangular=*/true>(
+        vertex_boxes, vertex_boxes, can_vertices_collide, candidates);
 }
 
 void SweepAndPrune::detect_edge_vertex_candidates(
     std::vector<EdgeVertexCandidate>& candidates) const
 {
-    std::vector<std::pair<int, int>> overlaps;
-    scalable_ccd::sort_and_sweep(
-        edge_boxes, vertex_boxes, ev_sort_axis, overlaps);
-
-    for (const auto& [ei, vi] : overlaps) {
-        if (can_edge_vertex_collide(ei, vi)) {
-            candidates.emplace_back(ei, vi);
-        }
-    }
+    detect_candidates(
+        edge_boxes, vertex_boxes,
+        std::bind(&SweepAndPrune::can_edge_vertex_collide, this, _1, _2),
+        candidates);
 }
 
 void SweepAndPrune::detect_edge_edge_candidates(
     std::vector<EdgeEdgeCandidate>& candidates) const
 {
-    std::vector<std::pair<int, int>> overlaps;
-    scalable_ccd::sort_and_sweep(edge_boxes, ee_sort_axis, overlaps);
-
-    for (const auto& [eai, ebi] : overlaps) {
-        if (can_edges_collide(eai, ebi)) {
-            candidates.emplace_back(eai, ebi);
-        }
-    }
+    detect_candidates<EdgeEdgeCandidate, /*triangular=*/true>(
+        edge_boxes, edge_boxes,
+        std::bind(&SweepAndPrune::can_edges_collide, this, _1, _2),
+        candidates);
 }
 
 void SweepAndPrune::detect_face_vertex_candidates(
     std::vector<FaceVertexCandidate>& candidates) const
 {
-    std::vector<std::pair<int, int>> overlaps;
-    scalable_ccd::sort_and_sweep(
-        face_boxes, vertex_boxes, fv_sort_axis, overlaps);
-
-    for (const auto& [fi, vi] : overlaps) {
-        if (can_face_vertex_collide(fi, vi)) {
-            candidates.emplace_back(fi, vi);
-        }
-    }
+    detect_candidates(
+        face_boxes, vertex_boxes,
+        std::bind(&SweepAndPrune::can_face_vertex_collide, this, _1, _2),
+        candidates);
 }
 
 void SweepAndPrune::detect_edge_face_candidates(
     std::vector<EdgeFaceCandidate>& candidates) const
 {
-    std::vector<std::pair<int, int>> overlaps;
-    scalable_ccd::sort_and_sweep(
-        edge_boxes, face_boxes, ef_sort_axis, overlaps);
-
-    for (const auto& [ei, fi] : overlaps) {
-        if (can_edge_face_collide(ei, fi)) {
-            candidates.emplace_back(ei, fi);
-        }
-    }
+    detect_candidates(
+        edge_boxes, face_boxes,
+        std::bind(&SweepAndPrune::can_edge_face_collide, this, _1, _2),
+        candidates);
 }
 
 void SweepAndPrune::detect_face_face_candidates(
     std::vector<FaceFaceCandidate>& candidates) const
 {
-    std::vector<std::pair<int, int>> overlaps;
-    scalable_ccd::sort_and_sweep(face_boxes, ff_sort_axis, overlaps);
-
-    for (const auto& [fai, fbi] : overlaps) {
-        if (can_faces_collide(fai, fbi)) {
-            candidates.emplace_back(fai, fbi);
-        }
-    }
-}
-
-// ----------------------------------------------------------------------------
-
-bool SweepAndPrune::can_edge_vertex_collide(size_t ei, size_t vi) const
-{
-    const auto& [e0i, e1i, _] = edge_boxes[ei].vertex_ids;
-
-    // Checked by scalable_ccd::sort_and_sweep
-    assert(vi != e0i && vi != e1i);
-
-    return can_vertices_collide(vi, e0i) || can_vertices_collide(vi, e1i);
-}
-
-bool SweepAndPrune::can_edges_collide(size_t eai, size_t ebi) const
-{
-    const auto& [ea0i, ea1i, _] = edge_boxes[eai].vertex_ids;
-    const auto& [eb0i, eb1i, __] = edge_boxes[ebi].vertex_ids;
-
-    // Checked by scalable_ccd::sort_and_sweep
-    assert(ea0i != eb0i && ea0i != eb1i && ea1i != eb0i && ea1i != eb1i);
-
-    return can_vertices_collide(ea0i, eb0i) || can_vertices_collide(ea0i, eb1i)
-        || can_vertices_collide(ea1i, eb0i) || can_vertices_collide(ea1i, eb1i);
-}
-
-bool SweepAndPrune::can_face_vertex_collide(size_t fi, size_t vi) const
-{
-    const auto& [f0i, f1i, f2i] = face_boxes[fi].vertex_ids;
-
-    // Checked by scalable_ccd::sort_and_sweep
-    assert(vi != f0i && vi != f1i && vi != f2i);
-
-    return can_vertices_collide(vi, f0i) || can_vertices_collide(vi, f1i)
-        || can_vertices_collide(vi, f2i);
-}
-
-bool SweepAndPrune::can_edge_face_collide(size_t ei, size_t fi) const
-{
-    const auto& [e0i, e1i, _] = edge_boxes[ei].vertex_ids;
-    const auto& [f0i, f1i, f2i] = face_boxes[fi].vertex_ids;
-
-    // Checked by scalable_ccd::sort_and_sweep
-    assert(
-        e0i != f0i && e0i != f1i && e0i != f2i && e1i != f0i && e1i != f1i
-        && e1i != f2i);
-
-    return can_vertices_collide(e0i, f0i) || can_vertices_collide(e0i, f1i)
-        || can_vertices_collide(e0i, f2i) || can_vertices_collide(e1i, f0i)
-        || can_vertices_collide(e1i, f1i) || can_vertices_collide(e1i, f2i);
-}
-
-bool SweepAndPrune::can_faces_collide(size_t fai, size_t fbi) const
-{
-    const auto& [fa0i, fa1i, fa2i] = face_boxes[fai].vertex_ids;
-    const auto& [fb0i, fb1i, fb2i] = face_boxes[fbi].vertex_ids;
-
-    // Checked by scalable_ccd::sort_and_sweep
-    assert(
-        fa0i != fb0i && fa0i != fb1i && fa0i != fb2i && fa1i != fb0i
-        && fa1i != fb1i && fa1i != fb2i && fa2i != fb0i && fa2i != fb1i
-        && fa2i != fb2i);
-
-    return can_vertices_collide(fa0i, fb0i) || can_vertices_collide(fa0i, fb1i)
-        || can_vertices_collide(fa0i, fb2i) || can_vertices_collide(fa1i, fb0i)
-        || can_vertices_collide(fa1i, fb1i) || can_vertices_collide(fa1i, fb2i)
-        || can_vertices_collide(fa2i, fb0i) || can_vertices_collide(fa2i, fb1i)
-        || can_vertices_collide(fa2i, fb2i);
+    detect_candidates<FaceFaceCandidate, /*triangular=*/true>(
+        face_boxes, face_boxes,
+        std::bind(&SweepAndPrune::can_faces_collide, this, _1, _2),
+        candidates);
 }
 
-} // namespace ipc
\ No newline at end of file
+} // namespace ipc
@@ -2,8 +2,6 @@
 
 #include <ipc/broad_phase/broad_phase.hpp>
 
-#include <scalable_ccd/broad_phase/aabb.hpp>
-
 namespace ipc {
 
 class SweepAndPrune : public BroadPhase {
@@ -14,33 +12,6 @@ public:
     /// @return The name of the broad phase method.
     std::string name() const override { return "SweepAndPrune"; }
 
-    /// @brief Build the broad phase for static collision detection.
-    /// @param vertices Vertex positions
-    /// @param edges Collision mesh edges
-    /// @param faces Collision mesh faces
-    /// @param inflation_radius Radius of inflation around all elements.
-    void build(
-        Eigen::ConstRef<Eigen::MatrixXd> vertices,
-        Eigen::ConstRef<Eigen::MatrixXi> edges,
-        Eigen::ConstRef<Eigen::MatrixXi> faces,
-        double inflation_radius = 0) override;
-
-    /// @brief Build the broad phase for continuous collision detection.
-    /// @param vertices_t0 Starting vertex positions
-    /// @param vertices_t1 Ending vertex positions
-    /// @param edges Collision mesh edges
-    /// @param faces Collision mesh faces
-    /// @param inflation_radius Radius of inflation around all elements.
-    void build(
-        Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
-        Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
-        Eigen::ConstRef<Eigen::MatrixXi> edges,
-        Eigen::ConstRef<Eigen::MatrixXi> faces,
-        double inflation_radius = 0) override;
-
-    /// @brief Clear any built data.
-    void clear() override;
-
     /// @brief Find the candidate vertex-vertex collisions.
     /// @param[out] candidates The candidate vertex-vertex collisions.
     void detect_vertex_vertex_candidates(
@@ -72,22 +43,25 @@ public:
         std::vector<FaceFaceCandidate>& candidates) const override;
 
 protected:
-    bool can_edge_vertex_collide(size_t ei, size_t vi) const override;
-    bool can_edges_collide(size_t eai, size_t ebi) const override;
-    bool can_face_vertex_collide(size_t fi, size_t vi) const override;
-    bool can_edge_face_collide(size_t ei, size_t fi) const override;
-    bool can_faces_collide(size_t fai, size_t fbi) const override;
-
-    std::vector<scalable_ccd::AABB> vertex_boxes;
-    std::vector<scalable_ccd::AABB> edge_boxes;
-    std::vector<scalable_ccd::AABB> face_boxes;
-
-    mutable int vv_sort_axis = 0;
-    mutable int ev_sort_axis = 0;
-    mutable int ee_sort_axis = 0;
-    mutable int fv_sort_axis = 0;
-    mutable int ef_sort_axis = 0;
-    mutable int ff_sort_axis = 0;
+    /// @brief Detect candidates for collisions between two sets of boxes.
+    /// @tparam Candidate Type of the candidate.
+    /// @tparam triangular Whether the two sets are the same (i.e., only consider (i, j) with i < j).
+    /// @param[in] boxes0 First set of boxes.
+    /// @param[in] boxes1 Second set of boxes.
+    /// @param[in] can_collide Function to determine if two primitives can collide given their ids.
+    /// @param[out] candidates The candidate collisions.
+    template <typename Candidate, bool triangular = false>
+    static void detect_candidates(
+        const AABBs& boxes0,
+        const AABBs& boxes1,
+        const std::function<bool(size_t, size_t)>& can_collide,
+        std::vector<Candidate>& candidates);
+
+    /// @brief Select the axis along which the box centers have the largest variance.
+    /// @param[in] boxes0 First set of boxes.
+    /// @param[in] boxes1 Second set of boxes.
+    /// @return The axis to sort along.
+    static int select_sort_axis(const AABBs& boxes0, const AABBs& boxes1);
 };
 
-} // namespace ipc
\ No newline at end of file
+} // namespace ipc
@@ -3,19 +3,29 @@
 #include <ipc/config.hpp>
 #include <ipc/ipc.hpp>
 #include <ipc/broad_phase/default_broad_phase.hpp>
+#include <ipc/utils/atomic_min.hpp>
 #include <ipc/utils/eigen_ext.hpp>
 #include <ipc/utils/save_obj.hpp>
 
 #include <igl/remove_unreferenced.h>
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/task_group.h>
 
+#include <atomic>
 #include <fstream>
-#include <shared_mutex>
 
 namespace ipc {
 
 namespace {
+    /// @brief Number of candidates in the first batch of compute_collision_free_stepsize.
+    constexpr size_t CCD_FIRST_BATCH_SIZE = 1024;
+
+    /// @brief Number of candidates between refreshes of a thread's cached tmax.
+    constexpr size_t TMAX_REFRESH_INTERVAL = 16;
+
     // Pad codim_edges because remove_unreferenced requires a N×3 matrix.
     Eigen::MatrixXi pad_edges(Eigen::ConstRef<Eigen::MatrixXi> E)
     {
@@ -42,10 +52,17 @@ void Candidates::build(
 
     const int dim = vertices.cols();
 
+    if (can_reuse(mesh, vertices, vertices, inflation_radius, *broad_phase)) {
+        return;
+    }
+
     clear();
 
+    const double build_radius = inflation_radius + m_safety_margin;
+
     broad_phase->can_vertices_collide = mesh.can_collide;
-    broad_phase->build(vertices, mesh.edges(), mesh.faces(), inflation_radius);
+    broad_phase->update(
+        vertices, mesh.edges(), mesh.faces(), build_radius);
     broad_phase->detect_collision_candidates(dim, *this);
 
     // Codim. vertices to codim. vertices:
@@ -53,7 +70,7 @@ void Candidates::build(
         broad_phase->clear();
         broad_phase->build(
             vertices(mesh.codim_vertices(), Eigen::all), //
-            Eigen::MatrixXi(), Eigen::MatrixXi(), inflation_radius);
+            Eigen::MatrixXi(), Eigen::MatrixXi(), build_radius);
 
         broad_phase->detect_vertex_vertex_candidates(vv_candidates);
         for (auto& [vi, vj] : vv_candidates) {
@@ -92,7 +109,7 @@ void Candidates::build(
             // Ignore c-edge to c-edge and c-vertex to c-vertex
             return ((vi < nCV) ^ (vj < nCV)) && mesh.can_collide(vi, vj);
         };
-        broad_phase->build(V, CE, Eigen::MatrixXi(), inflation_radius);
+        broad_phase->build(V, CE, Eigen::MatrixXi(), build_radius);
 
         broad_phase->detect_edge_vertex_candidates(ev_candidates);
         for (auto& [ei, vi] : ev_candidates) {
@@ -101,6 +118,10 @@ void Candidates::build(
             vi = mesh.codim_vertices()[vi]; // Map back to vertices
         }
     }
+
+    if (m_safety_margin > 0) {
+        cache(mesh, vertices, Eigen::MatrixXd(), build_radius, *broad_phase);
+    }
 }
 
 void Candidates::build(
@@ -114,11 +135,18 @@ void Candidates::build(
 
     const int dim = vertices_t0.cols();
 
+    if (can_reuse(
+            mesh, vertices_t0, vertices_t1, inflation_radius, *broad_phase)) {
+        return;
+    }
+
     clear();
 
+    const double build_radius = inflation_radius + m_safety_margin;
+
     broad_phase->can_vertices_collide = mesh.can_collide;
-    broad_phase->build(
-        vertices_t0, vertices_t1, mesh.edges(), mesh.faces(), inflation_radius);
+    broad_phase->update(
+        vertices_t0, vertices_t1, mesh.edges(), mesh.faces(), build_radius);
     broad_phase->detect_collision_candidates(dim, *this);
 
     // Codim. vertices to codim. vertices:
@@ -127,7 +155,7 @@ void Candidates::build(
         broad_phase->build(
             vertices_t0(mesh.codim_vertices(), Eigen::all),
             vertices_t1(mesh.codim_vertices(), Eigen::all), //
-            Eigen::MatrixXi(), Eigen::MatrixXi(), inflation_radius);
+            Eigen::MatrixXi(), Eigen::MatrixXi(), build_radius);
 
         broad_phase->detect_vertex_vertex_candidates(vv_candidates);
         for (auto& [vi, vj] : vv_candidates) {
@@ -172,7 +200,7 @@ void Candidates::build(
             // Ignore c-edge to c-edge and c-vertex to c-vertex
             return ((vi < nCV) ^ (vj < nCV)) && mesh.can_collide(vi, vj);
         };
-        broad_phase->build(V_t0, V_t1, CE, Eigen::MatrixXi(), inflation_radius);
+        broad_phase->build(V_t0, V_t1, CE, Eigen::MatrixXi(), build_radius);
 
         broad_phase->detect_edge_vertex_candidates(ev_candidates);
         for (auto& [ei, vi] : ev_candidates) {
@@ -181,6 +209,10 @@ void Candidates::build(
             vi = mesh.codim_vertices()[vi]; // Map back to vertices
         }
     }
+
+    if (m_safety_margin > 0) {
+        cache(mesh, vertices_t0, vertices_t1, build_radius, *broad_phase);
+    }
 }
 
 bool Candidates::is_step_collision_free(
@@ -194,21 +226,48 @@ bool Candidates::is_step_collision_free(
     assert(vertices_t1.rows() == mesh.num_vertices());
 
     // Narrow phase
-    for (size_t i = 0; i < size(); i++) {
-        const CollisionStencil& candidate = (*this)[i];
+    std::atomic<bool> is_collision_free = true;
+    tbb::task_group_context context;
+
+    const auto check_range = [&](const size_t begin, const size_t end) {
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(begin, end),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    if (context.is_group_execution_cancelled()) {
+                        return;
+                    }
 
-        double toi;
-        bool is_collision = candidate.ccd(
-            candidate.dof(vertices_t0, mesh.edges(), mesh.faces()),
-            candidate.dof(vertices_t1, mesh.edges(), mesh.faces()), //
-            toi, min_distance, /*tmax=*/1.0, narrow_phase_ccd);
+                    const CollisionStencil& candidate = (*this)[i];
 
-        if (is_collision) {
-            return false;
-        }
+                    double toi;
+                    bool is_collision = candidate.ccd(
+                        candidate.dof(vertices_t0, mesh.edges(), mesh.faces()),
+                        candidate.dof(vertices_t1, mesh.edges(), mesh.faces()),
+                        toi, min_distance, /*tmax=*/1.0, narrow_phase_ccd);
+
+                    if (is_collision) {
+                        // The first collision found decides the result, so
+                        // stop all other threads.
+                        is_collision_free = false;
+                        context.cancel_group_execution();
+                        return;
+                    }
+                }
+            },
+            context);
+    };
+
+    // Check the cheap vertex-vertex and edge-vertex stencils before the
+    // edge-edge and face-vertex ones.
+    const size_t num_point_candidates =
+        vv_candidates.size() + ev_candidates.size();
+    check_range(0, num_point_candidates);
+    if (is_collision_free) {
+        check_range(num_point_candidates, size());
     }
 
-    return true;
+    return is_collision_free;
 }
 
 double Candidates::compute_collision_free_stepsize(
@@ -225,37 +284,80 @@ double Candidates::compute_collision_free_stepsize(
         return 1; // No possible collisions, so can take full step.
     }
 
-    double earliest_toi = 1;
-    std::shared_mutex earliest_toi_mutex;
+    // Order the candidates by a conservative lower bound on their time of
+    // impact, so the candidates most likely to collide early are processed
+    // first and shrink tmax for the rest.
+    const Eigen::VectorXd displacement_norms =
+        (vertices_t1 - vertices_t0).rowwise().norm();
 
+    std::vector<std::pair<double, size_t>> order(size());
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, size()),
-        [&](tbb::blocked_range<size_t> r) {
+        [&](const tbb::blocked_range<size_t>& r) {
             for (size_t i = r.begin(); i < r.end(); i++) {
-                // Use the mutex to read as well in case writing double takes
-                // more than one clock cycle.
-                double tmax;
-                {
-                    std::shared_lock lock(earliest_toi_mutex);
-                    tmax = earliest_toi;
+                const CollisionStencil& candidate = (*this)[i];
+
+                const auto ids =
+                    candidate.vertex_ids(mesh.edges(), mesh.faces());
+                double max_displacement = 0;
+                for (int j = 0; j < candidate.num_vertices(); j++) {
+                    max_displacement =
+                        std::max(max_displacement, displacement_norms[ids[j]]);
                 }
 
-                const CollisionStencil& candidate = (*this)[i];
+                // The points of the two primitives approach each other by at
+                // most twice the largest vertex displacement.
+                const double distance = std::sqrt(candidate.compute_distance(
+                    vertices_t0, mesh.edges(), mesh.faces()));
+                const double toi_lower_bound = max_displacement > 0
+                    ? std::max(distance - min_distance, 0.0)
+                        / (2 * max_displacement)
+                    : std::numeric_limits<double>::infinity();
+
+                order[i] = std::make_pair(toi_lower_bound, i);
+            }
+        });
+    tbb::parallel_sort(order.begin(), order.end());
+
+    std::atomic<double> earliest_toi = 1;
+
+    // Process the candidates in batches of increasing size so the early
+    // candidates reduce tmax before the bulk of the work is done.
+    for (size_t batch_begin = 0, batch_size = CCD_FIRST_BATCH_SIZE;
+         batch_begin < order.size();
+         batch_begin += batch_size, batch_size *= 2) {
+        const size_t batch_end =
+            std::min(batch_begin + batch_size, order.size());
+
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(batch_begin, batch_end),
+            [&](const tbb::blocked_range<size_t>& r) {
+                // Cache tmax locally and only refresh it periodically to
+                // avoid contending on the shared value.
+                double tmax = earliest_toi.load(std::memory_order_relaxed);
+
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    if ((i - r.begin()) % TMAX_REFRESH_INTERVAL == 0) {
+                        tmax = std::min(
+                            tmax, earliest_toi.load(std::memory_order_relaxed));
+                    }
 
-                double toi = std::numeric_limits<double>::infinity(); // output
-                const bool are_colliding = candidate.ccd(
-                    candidate.dof(vertices_t0, mesh.edges(), mesh.faces()),
-                    candidate.dof(vertices_t1, mesh.edges(), mesh.faces()), //
-                    toi, min_distance, tmax, narrow_phase_ccd);
+                    const CollisionStencil& candidate =
+                        (*this)[order[i].second];
 
-                if (are_colliding) {
-                    std::unique_lock lock(earliest_toi_mutex);
-                    if (toi < earliest_toi) {
-                        earliest_toi = toi;
+                    double toi = std::numeric_limits<double>::infinity();
+                    const bool are_colliding = candidate.ccd(
+                        candidate.dof(vertices_t0, mesh.edges(), mesh.faces()),
+                        candidate.dof(vertices_t1, mesh.edges(), mesh.faces()),
+                        toi, min_distance, tmax, narrow_phase_ccd);
+
+                    if (are_colliding && toi < tmax) {
+                        tmax = toi;
+                        atomic_min(earliest_toi, toi);
                     }
                 }
-            }
-        });
+            });
+    }
 
     assert(earliest_toi >= 0 && earliest_toi <= 1.0);
     return earliest_toi;
@@ -342,6 +444,81 @@ void Candidates::clear()
     ev_candidates.clear();
     ee_candidates.clear();
     fv_candidates.clear();
+    m_cached_inflation_radius = -1;
+}
+
+void Candidates::set_safety_margin(const double safety_margin)
+{
+    assert(safety_margin >= 0);
+    m_safety_margin = safety_margin;
+    if (safety_margin <= 0) {
+        m_cached_inflation_radius = -1;
+        m_cached_vertices_t0.resize(0, 0);
+        m_cached_vertices_t1.resize(0, 0);
+        m_cached_edges.resize(0, 0);
+        m_cached_faces.resize(0, 0);
+        m_cached_broad_phase.clear();
+    }
+}
+
+bool Candidates::can_reuse(
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+    const double inflation_radius,
+    const BroadPhase& broad_phase) const
+{
+    if (m_safety_margin <= 0 || m_cached_inflation_radius < inflation_radius
+        || vertices_t0.rows() != m_cached_vertices_t0.rows()
+        || vertices_t0.cols() != m_cached_vertices_t0.cols()
+        || broad_phase.name() != m_cached_broad_phase
+        || mesh.edges().rows() != m_cached_edges.rows()
+        || mesh.edges().cols() != m_cached_edges.cols()
+        || mesh.faces().rows() != m_cached_faces.rows()
+        || mesh.faces().cols() != m_cached_faces.cols()
+        || mesh.edges() != m_cached_edges || mesh.faces() != m_cached_faces) {
+        return false;
+    }
+    assert(vertices_t1.rows() == vertices_t0.rows());
+
+    const Eigen::MatrixXd& cached_vertices_t1 = m_cached_vertices_t1.size()
+        ? m_cached_vertices_t1
+        : m_cached_vertices_t0;
+
+    // Every box moved by at most the largest vertex displacement, so pairs of
+    // boxes inflated by the remaining margin still overlap.
+    const double max_displacement = tbb::parallel_reduce(
+        tbb::blocked_range<Eigen::Index>(0, vertices_t0.rows()), 0.0,
+        [&](const tbb::blocked_range<Eigen::Index>& r, double max_d) {
+            for (Eigen::Index i = r.begin(); i < r.end(); i++) {
+                max_d = std::max({
+                    max_d,
+                    (vertices_t0.row(i) - m_cached_vertices_t0.row(i))
+                        .lpNorm<Eigen::Infinity>(),
+                    (vertices_t1.row(i) - cached_vertices_t1.row(i))
+                        .lpNorm<Eigen::Infinity>(),
+                });
+            }
+            return max_d;
+        },
+        [](double a, double b) { return std::max(a, b); });
+
+    return inflation_radius + max_displacement <= m_cached_inflation_radius;
+}
+
+void Candidates::cache(
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+    const double build_radius,
+    const BroadPhase& broad_phase)
+{
+    m_cached_inflation_radius = build_radius;
+    m_cached_vertices_t0 = vertices_t0;
+    m_cached_vertices_t1 = vertices_t1;
+    m_cached_edges = mesh.edges();
+    m_cached_faces = mesh.faces();
+    m_cached_broad_phase = broad_phase.name();
 }
 
 CollisionStencil& Candidates::operator[](size_t i)
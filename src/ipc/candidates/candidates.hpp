@@ -17,6 +17,7 @@ public:
     Candidates() = default;
 
     /// @brief Initialize the set of discrete collision detection candidates.
+    /// @note If a safety margin is set, the previous candidates are reused when no vertex moved more than the remaining margin.
     /// @param mesh The surface of the collision mesh.
     /// @param vertices Surface vertex positions (rowwise).
     /// @param inflation_radius Amount to inflate the bounding boxes.
@@ -30,6 +31,7 @@ public:
 
     /// @brief Initialize the set of continuous collision detection candidates.
     /// @note Assumes the trajectory is linear.
+    /// @note If a safety margin is set, the previous candidates are reused when no vertex moved more than the remaining margin.
     /// @param mesh The surface of the collision mesh.
     /// @param vertices_t0 Surface vertex starting positions (rowwise).
     /// @param vertices_t1 Surface vertex ending positions (rowwise).
@@ -43,6 +45,25 @@ public:
         const std::shared_ptr<BroadPhase> broad_phase =
             make_default_broad_phase());
 
+    /// @brief Get the safety margin added to the inflation radius when building.
+    /// @return The safety margin.
+    double safety_margin() const { return m_safety_margin; }
+
+    /// @brief Set the safety margin added to the inflation radius when building.
+    ///
+    /// With a positive margin, build() keeps the vertex positions used to
+    /// build the candidates. Subsequent calls to build() on the same mesh
+    /// reuse the candidates as is (skipping the broad phase) while the
+    /// inflation radius plus the largest vertex displacement (∞-norm) since
+    /// then is at most the inflation radius plus margin used to build them.
+    /// The reused candidates are a superset of the ones a new broad phase
+    /// would find. They are rebuilt if the mesh's edges or faces or the broad
+    /// phase method changed.
+    /// @note The candidates are not rebuilt if only mesh.can_collide changed;
+    ///       call clear() after changing it.
+    /// @param safety_margin The safety margin (zero disables reuse).
+    void set_safety_margin(const double safety_margin);
+
     size_t size() const;
 
     bool empty() const;
@@ -54,6 +75,7 @@ public:
 
     /// @brief Determine if the step is collision free from the set of candidates.
     /// @note Assumes the trajectory is linear.
+    /// @note The candidates are checked in parallel and all threads stop at the first collision found.
     /// @param mesh The collision mesh.
     /// @param vertices_t0 Surface vertex starting positions (rowwise).
     /// @param vertices_t1 Surface vertex ending positions (rowwise).
@@ -125,6 +147,49 @@ public:
     std::vector<EdgeVertexCandidate> ev_candidates;
     std::vector<EdgeEdgeCandidate> ee_candidates;
     std::vector<FaceVertexCandidate> fv_candidates;
+
+protected:
+    /// @brief Check if the candidates built for the cached vertices can be reused.
+    /// @param mesh The surface of the collision mesh.
+    /// @param vertices_t0 Surface vertex starting positions (rowwise).
+    /// @param vertices_t1 Surface vertex ending positions (rowwise).
+    /// @param inflation_radius Amount to inflate the bounding boxes.
+    /// @param broad_phase Broad phase method to use.
+    /// @return True if the mesh topology and broad phase method are unchanged and no vertex moved more than the remaining margin.
+    bool can_reuse(
+        const CollisionMesh& mesh,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+        const double inflation_radius,
+        const BroadPhase& broad_phase) const;
+
+    /// @brief Store what the candidates were built with to reuse them.
+    /// @param mesh The surface of the collision mesh.
+    /// @param vertices_t0 Surface vertex starting positions (rowwise).
+    /// @param vertices_t1 Surface vertex ending positions (rowwise, empty if the same as the starting positions).
+    /// @param build_radius Inflation radius (plus margin) used to build the candidates.
+    /// @param broad_phase Broad phase method used.
+    void cache(
+        const CollisionMesh& mesh,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+        const double build_radius,
+        const BroadPhase& broad_phase);
+
+    /// @brief Safety margin added to the inflation radius when building.
+    double m_safety_margin = 0;
+    /// @brief Inflation radius (plus margin) the candidates were built with, or a negative value if they cannot be reused.
+    double m_cached_inflation_radius = -1;
+    /// @brief Vertex starting positions the candidates were built with.
+    Eigen::MatrixXd m_cached_vertices_t0;
+    /// @brief Vertex ending positions the candidates were built with (empty if the same as the starting positions).
+    Eigen::MatrixXd m_cached_vertices_t1;
+    /// @brief Edges of the mesh the candidates were built with.
+    Eigen::MatrixXi m_cached_edges;
+    /// @brief Faces of the mesh the candidates were built with.
+    Eigen::MatrixXi m_cached_faces;
+    /// @brief Name of the broad phase method the candidates were built with.
+    std::string m_cached_broad_phase;
 };
 
 } // namespace ipc
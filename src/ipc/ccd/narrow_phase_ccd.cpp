@@ -0,0 +1,63 @@
+#include "narrow_phase_ccd.hpp"
+
+namespace ipc {
+
+bool NarrowPhaseCCD::batch_edge_edge_ccd(
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+    double& toi,
+    const double min_distance,
+    const double tmax) const
+{
+    assert(vertices_t0.cols() == 12 && vertices_t1.cols() == 12);
+    assert(vertices_t0.rows() == vertices_t1.rows());
+
+    bool is_impacting = false;
+    toi = tmax;
+    for (int i = 0; i < vertices_t0.rows(); i++) {
+        const Eigen::Matrix<double, 12, 1> x_t0 = vertices_t0.row(i);
+        const Eigen::Matrix<double, 12, 1> x_t1 = vertices_t1.row(i);
+
+        double query_toi;
+        if (edge_edge_ccd(
+                x_t0.head<3>(), x_t0.segment<3>(3), x_t0.segment<3>(6),
+                x_t0.tail<3>(), x_t1.head<3>(), x_t1.segment<3>(3),
+                x_t1.segment<3>(6), x_t1.tail<3>(), query_toi, min_distance,
+                toi)) {
+            is_impacting = true;
+            toi = std::min(toi, query_toi);
+        }
+    }
+    return is_impacting;
+}
+
+bool NarrowPhaseCCD::batch_point_triangle_ccd(
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+    double& toi,
+    const double min_distance,
+    const double tmax) const
+{
+    assert(vertices_t0.cols() == 12 && vertices_t1.cols() == 12);
+    assert(vertices_t0.rows() == vertices_t1.rows());
+
+    bool is_impacting = false;
+    toi = tmax;
+    for (int i = 0; i < vertices_t0.rows(); i++) {
+        const Eigen::Matrix<double, 12, 1> x_t0 = vertices_t0.row(i);
+        const Eigen::Matrix<double, 12, 1> x_t1 = vertices_t1.row(i);
+
+        double query_toi;
+        if (point_triangle_ccd(
+                x_t0.head<3>(), x_t0.segment<3>(3), x_t0.segment<3>(6),
+                x_t0.tail<3>(), x_t1.head<3>(), x_t1.segment<3>(3),
+                x_t1.segment<3>(6), x_t1.tail<3>(), query_toi, min_distance,
+                toi)) {
+            is_impacting = true;
+            toi = std::min(toi, query_toi);
+        }
+    }
+    return is_impacting;
+}
+
+} // namespace ipc
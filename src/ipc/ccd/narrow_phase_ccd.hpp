@@ -55,6 +55,36 @@ public:
         double& toi,
         const double min_distance = 0.0,
         const double tmax = 1.0) const = 0;
+
+    /// @brief Computes the earliest time of impact of a batch of edge-edge queries.
+    /// @note The default implementation calls edge_edge_ccd on each query while shrinking tmax.
+    /// @param[in] vertices_t0 Initial positions of the edges' endpoints [ea0, ea1, eb0, eb1] with one query per row (N×12).
+    /// @param[in] vertices_t1 Final positions of the edges' endpoints [ea0, ea1, eb0, eb1] with one query per row (N×12).
+    /// @param[out] toi The earliest time of impact of the queries.
+    /// @param[in] min_distance The minimum distance between the objects.
+    /// @param[in] tmax The maximum time to check for collisions.
+    /// @return True if a collision was detected for any query, false otherwise.
+    virtual bool batch_edge_edge_ccd(
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+        double& toi,
+        const double min_distance = 0.0,
+        const double tmax = 1.0) const;
+
+    /// @brief Computes the earliest time of impact of a batch of point-triangle queries.
+    /// @note The default implementation calls point_triangle_ccd on each query while shrinking tmax.
+    /// @param[in] vertices_t0 Initial positions of the point and triangle vertices [p, t0, t1, t2] with one query per row (N×12).
+    /// @param[in] vertices_t1 Final positions of the point and triangle vertices [p, t0, t1, t2] with one query per row (N×12).
+    /// @param[out] toi The earliest time of impact of the queries.
+    /// @param[in] min_distance The minimum distance between the objects.
+    /// @param[in] tmax The maximum time to check for collisions.
+    /// @return True if a collision was detected for any query, false otherwise.
+    virtual bool batch_point_triangle_ccd(
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+        double& toi,
+        const double min_distance = 0.0,
+        const double tmax = 1.0) const;
 };
 
 } // namespace ipc
\ No newline at end of file
@@ -9,6 +9,9 @@
 #include <tight_inclusion/ccd.hpp>
 
 #include <algorithm> // std::min/max
+#include <functional>
+#include <initializer_list>
+#include <limits>
 
 namespace ipc {
 
@@ -20,6 +23,123 @@ static constexpr double INITIAL_DISTANCE_TOLERANCE_SCALE = 0.5;
 /// number of iterations.
 static constexpr long TIGHT_INCLUSION_UNLIMITED_ITERATIONS = -1;
 
+/// Upper bound on the amount ccd_strategy adds to the minimum distance.
+static constexpr double MAX_EFFECTIVE_DISTANCE_OFFSET = 1e-4;
+
+namespace {
+    /// @brief Bound the relative displacement of any point of one primitive and any point of another.
+    ///
+    /// The points of a primitive are convex combinations of its vertices, so
+    /// their displacement relative to a common translation is bounded by the
+    /// largest relative displacement of the vertices. Subtracting the mean
+    /// displacement tightens the bound (see AdditiveCCD).
+    ///
+    /// @param da Displacements of the first primitive's vertices.
+    /// @param db Displacements of the second primitive's vertices.
+    /// @return Upper bound on the relative displacement of any two points.
+    double max_relative_displacement(
+        const std::initializer_list<Eigen::Vector3d>& da,
+        const std::initializer_list<Eigen::Vector3d>& db)
+    {
+        Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+        for (const Eigen::Vector3d& d : da) {
+            mean += d;
+        }
+        for (const Eigen::Vector3d& d : db) {
+            mean += d;
+        }
+        mean /= da.size() + db.size();
+
+        double max_da_sq = 0, max_db_sq = 0;
+        for (const Eigen::Vector3d& d : da) {
+            max_da_sq = std::max(max_da_sq, (d - mean).squaredNorm());
+        }
+        for (const Eigen::Vector3d& d : db) {
+            max_db_sq = std::max(max_db_sq, (d - mean).squaredNorm());
+        }
+        return std::sqrt(max_da_sq) + std::sqrt(max_db_sq);
+    }
+
+    /// @brief Find the queries of a batch that can come within a distance of each other.
+    ///
+    /// The queries are of the form F(t, u, v) = a(t, u) - b(t, v) where a and
+    /// b are linear interpolations of two (ea0, ea1 and eb0, eb1) or one and
+    /// three (p and t0, t1, t2) moving points. For fixed t, each coordinate of
+    /// F lies in [min a - max b, max a - min b] over the points. The points
+    /// move linearly in t, so the lower bound is concave and the upper bound
+    /// is convex in t, and both are extremal at t = 0 or t = tmax. A query is
+    /// rejected if, for any coordinate, the bounds at both ends lie on the
+    /// same side of [-distance, distance].
+    ///
+    /// The test is evaluated on whole columns of the batch, so it is
+    /// vectorized across the queries.
+    ///
+    /// @param vertices_t0 Initial positions with one query per row (N×12).
+    /// @param vertices_t1 Final positions with one query per row (N×12).
+    /// @param n_a Number of points interpolated by a (the rest belong to b).
+    /// @param distance Distance at which queries are considered colliding.
+    /// @param tmax Maximum time to check for collisions.
+    /// @return The indices of the queries that are not rejected.
+    std::vector<int> inclusion_test(
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+        const int n_a,
+        double distance,
+        const double tmax)
+    {
+        const Eigen::Index n = vertices_t0.rows();
+
+        // Bound the rounding error of the corner values.
+        distance += 16 * std::numeric_limits<double>::epsilon()
+            * std::max(
+                        vertices_t0.cwiseAbs().maxCoeff(),
+                        vertices_t1.cwiseAbs().maxCoeff());
+
+        using ArrayXb = Eigen::Array<bool, Eigen::Dynamic, 1>;
+        ArrayXb is_rejected = ArrayXb::Constant(n, false);
+        ArrayXb is_above(n), is_below(n);
+        Eigen::ArrayXd a_min(n), a_max(n), b_min(n), b_max(n), x(n);
+
+        for (int d = 0; d < 3; d++) {
+            is_above.setConstant(true);
+            is_below.setConstant(true);
+            for (const double t : { 0.0, tmax }) {
+                for (int i = 0; i < 4; i++) {
+                    const int col = 3 * i + d;
+                    x = vertices_t0.col(col).array()
+                        + t
+                            * (vertices_t1.col(col) - vertices_t0.col(col))
+                                  .array();
+                    if (i == 0) {
+                        a_min = a_max = x;
+                    } else if (i < n_a) {
+                        a_min = a_min.min(x);
+                        a_max = a_max.max(x);
+                    } else if (i == n_a) {
+                        b_min = b_max = x;
+                    } else {
+                        b_min = b_min.min(x);
+                        b_max = b_max.max(x);
+                    }
+                }
+
+                // F_d(t) ∈ [a_min - b_max, a_max - b_min]
+                is_above = is_above && (a_min - b_max > distance);
+                is_below = is_below && (a_max - b_min < -distance);
+            }
+            is_rejected = is_rejected || is_above || is_below;
+        }
+
+        std::vector<int> remaining;
+        for (int i = 0; i < n; i++) {
+            if (!is_rejected[i]) {
+                remaining.push_back(i);
+            }
+        }
+        return remaining;
+    }
+} // namespace
+
 TightInclusionCCD::TightInclusionCCD(
     const double _tolerance,
     const long _max_iterations,
@@ -30,6 +150,52 @@ TightInclusionCCD::TightInclusionCCD(
 {
 }
 
+TightInclusionCCD::PrefilterStatistics
+TightInclusionCCD::prefilter_statistics() const
+{
+    PrefilterStatistics statistics;
+    statistics.num_queries =
+        m_num_prefilter_queries.combine(std::plus<size_t>());
+    statistics.num_rejected =
+        m_num_prefilter_rejections.combine(std::plus<size_t>());
+    return statistics;
+}
+
+void TightInclusionCCD::reset_prefilter_statistics()
+{
+    m_num_prefilter_queries.clear();
+    m_num_prefilter_rejections.clear();
+}
+
+bool TightInclusionCCD::is_rejected_by_prefilter(
+    const double initial_distance,
+    const double max_disp_mag,
+    const double min_distance,
+    const double tmax) const
+{
+    if (!use_prefilter) {
+        return false;
+    }
+    m_num_prefilter_queries.local()++;
+
+    // Tight Inclusion only reports collisions once the distance is within the
+    // minimum effective distance, which is at most this (see ccd_strategy).
+    const double max_effective_distance =
+        min_distance + MAX_EFFECTIVE_DISTANCE_OFFSET;
+
+    // Smallest distance reachable by tmax, with slack for rounding error.
+    const double max_closing = tmax * max_disp_mag;
+    const double min_reachable_distance = initial_distance - max_closing
+        - 16 * std::numeric_limits<double>::epsilon()
+            * (initial_distance + max_closing);
+
+    if (min_reachable_distance > max_effective_distance) {
+        m_num_prefilter_rejections.local()++;
+        return true;
+    }
+    return false;
+}
+
 bool TightInclusionCCD::ccd_strategy(
     const std::function<bool(
         double /*min_distance*/, bool /*no_zero_toi*/, double& /*toi*/)>& ccd,
@@ -45,7 +211,8 @@ bool TightInclusionCCD::ccd_strategy(
     double min_effective_distance =
         (1.0 - conservative_rescaling) * (initial_distance - min_distance);
     // Tight Inclusion performs better when the minimum separation is small
-    min_effective_distance = std::min(min_effective_distance, 1e-4);
+    min_effective_distance =
+        std::min(min_effective_distance, MAX_EFFECTIVE_DISTANCE_OFFSET);
     min_effective_distance += min_distance;
 
     assert(min_effective_distance < initial_distance);
@@ -91,6 +258,13 @@ bool TightInclusionCCD::point_point_ccd_3D(
         return check_initial_distance(initial_distance, min_distance, toi);
     }
 
+    if (is_rejected_by_prefilter(
+            initial_distance,
+            max_relative_displacement({ p0_t1 - p0_t0 }, { p1_t1 - p1_t0 }),
+            min_distance, tmax)) {
+        return false;
+    }
+
     const double adjusted_tolerance = std::min(
         INITIAL_DISTANCE_TOLERANCE_SCALE * initial_distance, tolerance);
 
@@ -164,6 +338,14 @@ bool TightInclusionCCD::point_edge_ccd_3D(
         return check_initial_distance(initial_distance, min_distance, toi);
     }
 
+    if (is_rejected_by_prefilter(
+            initial_distance,
+            max_relative_displacement(
+                { p_t1 - p_t0 }, { e0_t1 - e0_t0, e1_t1 - e1_t0 }),
+            min_distance, tmax)) {
+        return false;
+    }
+
     const double adjusted_tolerance = std::min(
         INITIAL_DISTANCE_TOLERANCE_SCALE * initial_distance, tolerance);
 
@@ -242,6 +424,15 @@ bool TightInclusionCCD::edge_edge_ccd(
         return check_initial_distance(initial_distance, min_distance, toi);
     }
 
+    if (is_rejected_by_prefilter(
+            initial_distance,
+            max_relative_displacement(
+                { ea0_t1 - ea0_t0, ea1_t1 - ea1_t0 },
+                { eb0_t1 - eb0_t0, eb1_t1 - eb1_t0 }),
+            min_distance, tmax)) {
+        return false;
+    }
+
     const double adjusted_tolerance = std::min(
         INITIAL_DISTANCE_TOLERANCE_SCALE * initial_distance, tolerance);
 
@@ -300,6 +491,15 @@ bool TightInclusionCCD::point_triangle_ccd(
         return check_initial_distance(initial_distance, min_distance, toi);
     }
 
+    if (is_rejected_by_prefilter(
+            initial_distance,
+            max_relative_displacement(
+                { p_t1 - p_t0 },
+                { t0_t1 - t0_t0, t1_t1 - t1_t0, t2_t1 - t2_t0 }),
+            min_distance, tmax)) {
+        return false;
+    }
+
     const double adjusted_tolerance = std::min(
         INITIAL_DISTANCE_TOLERANCE_SCALE * initial_distance, tolerance);
 
@@ -335,4 +535,68 @@ bool TightInclusionCCD::point_triangle_ccd(
         ccd, min_distance, initial_distance, conservative_rescaling, toi);
 }
 
-} // namespace ipc
\ No newline at end of file
+// ============================================================================
+
+bool TightInclusionCCD::batch_edge_edge_ccd(
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+    double& toi,
+    const double min_distance,
+    const double tmax) const
+{
+    assert(vertices_t0.cols() == 12 && vertices_t1.cols() == 12);
+    assert(vertices_t0.rows() == vertices_t1.rows());
+
+    bool is_impacting = false;
+    toi = tmax;
+    for (const int i : inclusion_test(
+             vertices_t0, vertices_t1, /*n_a=*/2,
+             min_distance + MAX_EFFECTIVE_DISTANCE_OFFSET, tmax)) {
+        const Eigen::Matrix<double, 12, 1> x_t0 = vertices_t0.row(i);
+        const Eigen::Matrix<double, 12, 1> x_t1 = vertices_t1.row(i);
+
+        double query_toi;
+        if (TightInclusionCCD::edge_edge_ccd(
+                x_t0.head<3>(), x_t0.segment<3>(3), x_t0.segment<3>(6),
+                x_t0.tail<3>(), x_t1.head<3>(), x_t1.segment<3>(3),
+                x_t1.segment<3>(6), x_t1.tail<3>(), query_toi, min_distance,
+                toi)) {
+            is_impacting = true;
+            toi = std::min(toi, query_toi);
+        }
+    }
+    return is_impacting;
+}
+
+bool TightInclusionCCD::batch_point_triangle_ccd(
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+    double& toi,
+    const double min_distance,
+    const double tmax) const
+{
+    assert(vertices_t0.cols() == 12 && vertices_t1.cols() == 12);
+    assert(vertices_t0.rows() == vertices_t1.rows());
+
+    bool is_impacting = false;
+    toi = tmax;
+    for (const int i : inclusion_test(
+             vertices_t0, vertices_t1, /*n_a=*/1,
+             min_distance + MAX_EFFECTIVE_DISTANCE_OFFSET, tmax)) {
+        const Eigen::Matrix<double, 12, 1> x_t0 = vertices_t0.row(i);
+        const Eigen::Matrix<double, 12, 1> x_t1 = vertices_t1.row(i);
+
+        double query_toi;
+        if (TightInclusionCCD::point_triangle_ccd(
+                x_t0.head<3>(), x_t0.segment<3>(3), x_t0.segment<3>(6),
+                x_t0.tail<3>(), x_t1.head<3>(), x_t1.segment<3>(3),
+                x_t1.segment<3>(6), x_t1.tail<3>(), query_toi, min_distance,
+                toi)) {
+            is_impacting = true;
+            toi = std::min(toi, query_toi);
+        }
+    }
+    return is_impacting;
+}
+
+} // namespace ipc
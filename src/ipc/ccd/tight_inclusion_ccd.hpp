@@ -2,6 +2,8 @@
 
 #include <ipc/ccd/narrow_phase_ccd.hpp>
 
+#include <tbb/enumerable_thread_specific.h>
+
 namespace ipc {
 
 class TightInclusionCCD : public NarrowPhaseCCD {
@@ -118,6 +120,58 @@ public:
         const double min_distance = 0.0,
         const double tmax = 1.0) const override;
 
+    /// @brief Computes the earliest time of impact of a batch of edge-edge queries.
+    /// @note The queries are first tested together with a vectorized inclusion test, and only the remaining ones are solved with edge_edge_ccd.
+    /// @param[in] vertices_t0 Initial positions of the edges' endpoints [ea0, ea1, eb0, eb1] with one query per row (N×12).
+    /// @param[in] vertices_t1 Final positions of the edges' endpoints [ea0, ea1, eb0, eb1] with one query per row (N×12).
+    /// @param[out] toi The earliest time of impact of the queries.
+    /// @param[in] min_distance The minimum distance between the objects.
+    /// @param[in] tmax The maximum time to check for collisions.
+    /// @return True if a collision was detected for any query, false otherwise.
+    bool batch_edge_edge_ccd(
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+        double& toi,
+        const double min_distance = 0.0,
+        const double tmax = 1.0) const override;
+
+    /// @brief Computes the earliest time of impact of a batch of point-triangle queries.
+    /// @note The queries are first tested together with a vectorized inclusion test, and only the remaining ones are solved with point_triangle_ccd.
+    /// @param[in] vertices_t0 Initial positions of the point and triangle vertices [p, t0, t1, t2] with one query per row (N×12).
+    /// @param[in] vertices_t1 Final positions of the point and triangle vertices [p, t0, t1, t2] with one query per row (N×12).
+    /// @param[out] toi The earliest time of impact of the queries.
+    /// @param[in] min_distance The minimum distance between the objects.
+    /// @param[in] tmax The maximum time to check for collisions.
+    /// @return True if a collision was detected for any query, false otherwise.
+    bool batch_point_triangle_ccd(
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+        double& toi,
+        const double min_distance = 0.0,
+        const double tmax = 1.0) const override;
+
+    /// @brief Counters of the queries seen by the linear-bound prefilter.
+    struct PrefilterStatistics {
+        /// @brief Number of queries checked by the prefilter.
+        size_t num_queries = 0;
+        /// @brief Number of queries rejected without running the root finder.
+        size_t num_rejected = 0;
+
+        /// @brief Fraction of the checked queries that were rejected.
+        double rejection_rate() const
+        {
+            return num_queries == 0 ? 0.0
+                                    : double(num_rejected) / num_queries;
+        }
+    };
+
+    /// @brief Get the counters of the linear-bound prefilter.
+    PrefilterStatistics prefilter_statistics() const;
+
+    /// @brief Reset the counters of the linear-bound prefilter.
+    /// @note Must not be called while queries are running on other threads.
+    void reset_prefilter_statistics();
+
     /// @brief Solver tolerance.
     double tolerance;
 
@@ -127,7 +181,30 @@ public:
     /// @brief Conservative rescaling of the time of impact.
     double conservative_rescaling;
 
+    /// @brief Reject queries whose distance cannot close within tmax before running the root finder.
+    bool use_prefilter = true;
+
 private:
+    /// @brief Per-thread counter, summed when read.
+    using Counter = tbb::enumerable_thread_specific<size_t>;
+
+    /// @brief Check if a query cannot collide by bounding the motion of its closest points.
+    ///
+    /// The distance between the primitives decreases at most as fast as the
+    /// relative displacement of any two of their points, so it stays above
+    /// initial_distance - t * max_disp_mag.
+    ///
+    /// @param initial_distance The initial distance between the objects.
+    /// @param max_disp_mag Upper bound on the relative displacement of any two points of the objects.
+    /// @param min_distance The minimum distance between the objects.
+    /// @param tmax The maximum time to check for collisions.
+    /// @return True if the query cannot collide before tmax, false otherwise.
+    bool is_rejected_by_prefilter(
+        const double initial_distance,
+        const double max_disp_mag,
+        const double min_distance,
+        const double tmax) const;
+
     /// @brief Computes the time of impact between two points in 3D using continuous collision detection.
     /// @param[in] p0_t0 The initial position of the first point.
     /// @param[in] p1_t0 The initial position of the second point.
@@ -183,6 +260,11 @@ private:
         const double initial_distance,
         const double conservative_rescaling,
         double& toi);
+
+    /// @brief Number of queries checked by the prefilter on each thread.
+    mutable Counter m_num_prefilter_queries { size_t(0) };
+    /// @brief Number of queries rejected by the prefilter on each thread.
+    mutable Counter m_num_prefilter_rejections { size_t(0) };
 };
 
 } // namespace ipc
\ No newline at end of file
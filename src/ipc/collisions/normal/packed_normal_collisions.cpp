@@ -0,0 +1,117 @@
+#include "packed_normal_collisions.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+namespace ipc {
+
+namespace {
+    /// @brief Copy a vector of collisions into a group.
+    template <typename Group, typename Collision, typename Pack>
+    void pack_group(
+        const std::vector<Collision>& collisions,
+        const CollisionMesh& mesh,
+        Group& group,
+        Pack&& pack_extra)
+    {
+        group.resize(collisions.size());
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(size_t(0), collisions.size()),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    const Collision& collision = collisions[i];
+                    const std::array<index_t, 4> ids =
+                        collision.vertex_ids(mesh.edges(), mesh.faces());
+                    std::copy_n(
+                        ids.begin(), Group::num_vertices,
+                        group.vertex_ids[i].begin());
+                    group.weights[i] = collision.weight;
+                    group.dmins[i] = collision.dmin;
+                    pack_extra(i, collision);
+                }
+            });
+    }
+} // namespace
+
+void PackedNormalCollisions::build(
+    const NormalCollisions& collisions, const CollisionMesh& mesh)
+{
+    pack_group(
+        collisions.vv_collisions, mesh, vv,
+        [&](size_t i, const VertexVertexNormalCollision&) {
+            vv.dtypes[i] = PointPointDistanceType::AUTO;
+        });
+    pack_group(
+        collisions.ev_collisions, mesh, ev,
+        [&](size_t i, const EdgeVertexNormalCollision& c) {
+            ev.dtypes[i] = c.known_dtype();
+        });
+    pack_group(
+        collisions.ee_collisions, mesh, ee,
+        [&](size_t i, const EdgeEdgeNormalCollision& c) {
+            ee.dtypes[i] = c.known_dtype();
+            ee.eps_x[i] = c.eps_x;
+        });
+    pack_group(
+        collisions.fv_collisions, mesh, fv,
+        [&](size_t i, const FaceVertexNormalCollision& c) {
+            fv.dtypes[i] = c.known_dtype();
+        });
+    pv = collisions.pv_collisions;
+}
+
+void PackedNormalCollisions::clear()
+{
+    vv.resize(0);
+    ev.resize(0);
+    ee.resize(0);
+    fv.resize(0);
+    pv.clear();
+}
+
+std::array<index_t, 4> PackedNormalCollisions::vertex_ids(size_t i) const
+{
+    if (i < vv.size()) {
+        return { { vv.vertex_ids[i][0], vv.vertex_ids[i][1], -1, -1 } };
+    }
+    i -= vv.size();
+    if (i < ev.size()) {
+        const std::array<index_t, 3>& ids = ev.vertex_ids[i];
+        return { { ids[0], ids[1], ids[2], -1 } };
+    }
+    i -= ev.size();
+    if (i < ee.size()) {
+        return ee.vertex_ids[i];
+    }
+    i -= ee.size();
+    if (i < fv.size()) {
+        return fv.vertex_ids[i];
+    }
+    i -= fv.size();
+    if (i < pv.size()) {
+        return { { pv[i].vertex_id, -1, -1, -1 } };
+    }
+    throw std::out_of_range("Collision index is out of range!");
+}
+
+int PackedNormalCollisions::num_vertices(size_t i) const
+{
+    if (i < vv.size()) {
+        return 2;
+    }
+    i -= vv.size();
+    if (i < ev.size()) {
+        return 3;
+    }
+    i -= ev.size();
+    if (i < ee.size() + fv.size()) {
+        return 4;
+    }
+    i -= ee.size() + fv.size();
+    if (i < pv.size()) {
+        return 1;
+    }
+    throw std::out_of_range("Collision index is out of range!");
+}
+
+} // namespace ipc
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <ipc/collisions/normal/normal_collisions.hpp>
+#include <ipc/distance/distance_type.hpp>
+
+#include <array>
+#include <vector>
+
+namespace ipc {
+
+/// @brief A flat copy of a set of normal collisions.
+///
+/// NormalCollisions stores polymorphic collision objects, so every potential
+/// evaluation goes through virtual calls to get a collision's vertices and
+/// distance. Here the collisions are grouped by type, and each group stores
+/// the vertex ids, weights, minimum distances, and distance types of its
+/// collisions in contiguous arrays. This lets the potentials evaluate each
+/// group with statically dispatched distance functions. The barrier itself is
+/// still evaluated through the potential's virtual interface.
+///
+/// The collisions are stored in the same order as in NormalCollisions (vertex-
+/// vertex, edge-vertex, edge-edge, face-vertex, then plane-vertex).
+///
+/// @note Plane-vertex collisions are rare and have no vertex pair to pack, so
+///       they are copied as is and evaluated through the virtual interface.
+class PackedNormalCollisions {
+public:
+    /// @brief Collisions of one type stored as parallel arrays.
+    /// @tparam N Number of vertices of each collision.
+    /// @tparam DistanceType Type of the closest pair between the primitives.
+    template <int N, typename DistanceType> struct Group {
+        /// @brief Number of vertices of each collision.
+        static constexpr int num_vertices = N;
+
+        /// @brief Number of collisions in the group.
+        size_t size() const { return vertex_ids.size(); }
+
+        /// @brief Resize the arrays to n collisions.
+        void resize(const size_t n)
+        {
+            vertex_ids.resize(n);
+            weights.resize(n);
+            dmins.resize(n);
+            dtypes.resize(n);
+        }
+
+        /// @brief Vertex ids of each collision.
+        std::vector<std::array<index_t, N>> vertex_ids;
+        /// @brief Weight of each collision.
+        std::vector<double> weights;
+        /// @brief Minimum distance of each collision.
+        std::vector<double> dmins;
+        /// @brief Closest pair of each collision.
+        std::vector<DistanceType> dtypes;
+    };
+
+    /// @brief Edge-edge collisions with their mollifier thresholds.
+    struct EdgeEdgeGroup : Group<4, EdgeEdgeDistanceType> {
+        /// @brief Resize the arrays to n collisions.
+        void resize(const size_t n)
+        {
+            Group::resize(n);
+            eps_x.resize(n);
+        }
+
+        /// @brief Mollifier threshold of each collision.
+        std::vector<double> eps_x;
+    };
+
+    PackedNormalCollisions() = default;
+
+    /// @brief Construct a packed copy of a set of collisions.
+    /// @param collisions The collisions to pack.
+    /// @param mesh The collision mesh.
+    PackedNormalCollisions(
+        const NormalCollisions& collisions, const CollisionMesh& mesh)
+    {
+        build(collisions, mesh);
+    }
+
+    /// @brief Pack a set of collisions.
+    /// @param collisions The collisions to pack.
+    /// @param mesh The collision mesh.
+    void build(const NormalCollisions& collisions, const CollisionMesh& mesh);
+
+    /// @brief Get the number of collisions.
+    size_t size() const
+    {
+        return vv.size() + ev.size() + ee.size() + fv.size() + pv.size();
+    }
+
+    /// @brief Get if the set of collisions is empty.
+    bool empty() const { return size() == 0; }
+
+    /// @brief Clear the set of collisions.
+    void clear();
+
+    /// @brief Get the vertex ids of the i-th collision.
+    /// @note The ids past the collision's number of vertices are -1.
+    std::array<index_t, 4> vertex_ids(size_t i) const;
+
+    /// @brief Get the number of vertices of the i-th collision.
+    int num_vertices(size_t i) const;
+
+    /// @brief Vertex-vertex collisions.
+    Group<2, PointPointDistanceType> vv;
+    /// @brief Edge-vertex collisions (vertex ids are [vertex, edge0, edge1]).
+    Group<3, PointEdgeDistanceType> ev;
+    /// @brief Edge-edge collisions.
+    EdgeEdgeGroup ee;
+    /// @brief Face-vertex collisions (ids are [vertex, face0, face1, face2]).
+    Group<4, PointTriangleDistanceType> fv;
+    /// @brief Plane-vertex collisions (not packed).
+    std::vector<PlaneVertexNormalCollision> pv;
+};
+
+} // namespace ipc
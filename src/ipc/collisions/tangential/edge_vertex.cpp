@@ -21,6 +21,9 @@ EdgeVertexTangentialCollision::EdgeVertexTangentialCollision(
     const double normal_force)
     : EdgeVertexTangentialCollision(collision)
 {
+    const int dim = positions.size() / 3;
+    dtype = point_edge_distance_type(
+        positions.head(dim), positions.segment(dim, dim), positions.tail(dim));
     TangentialCollision::init(collision, positions, normal_force);
 }
 
@@ -31,6 +34,9 @@ EdgeVertexTangentialCollision::EdgeVertexTangentialCollision(
     const double normal_stiffness)
     : EdgeVertexTangentialCollision(collision)
 {
+    const int dim = positions.size() / 3;
+    dtype = point_edge_distance_type(
+        positions.head(dim), positions.segment(dim, dim), positions.tail(dim));
     TangentialCollision::init(
         collision, positions, normal_potential, normal_stiffness);
 }
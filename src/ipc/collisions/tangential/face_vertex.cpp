@@ -21,6 +21,9 @@ FaceVertexTangentialCollision::FaceVertexTangentialCollision(
     const double normal_force)
     : FaceVertexTangentialCollision(collision)
 {
+    dtype = point_triangle_distance_type(
+        positions.head<3>(), positions.segment<3>(3), positions.segment<3>(6),
+        positions.tail<3>());
     TangentialCollision::init(collision, positions, normal_force);
 }
 
@@ -31,6 +34,9 @@ FaceVertexTangentialCollision::FaceVertexTangentialCollision(
     const double normal_stiffness)
     : FaceVertexTangentialCollision(collision)
 {
+    dtype = point_triangle_distance_type(
+        positions.head<3>(), positions.segment<3>(3), positions.segment<3>(6),
+        positions.tail<3>());
     TangentialCollision::init(
         collision, positions, normal_potential, normal_stiffness);
 }
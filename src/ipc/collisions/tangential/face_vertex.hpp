@@ -24,7 +24,14 @@ public:
         const NormalPotential& normal_potential,
         const double normal_stiffness);
 
+    /// @brief Cached distance type.
+    /// Classified once from the positions the collision is built with, so the
+    /// distance evaluations do not have to classify it again.
+    PointTriangleDistanceType dtype = PointTriangleDistanceType::AUTO;
+
 protected:
+    PointTriangleDistanceType known_dtype() const override { return dtype; }
+
     MatrixMax<double, 3, 2> compute_tangent_basis(
         Eigen::ConstRef<VectorMax12d> positions) const override;
 
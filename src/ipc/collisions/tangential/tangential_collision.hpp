@@ -6,6 +6,8 @@
 #include <ipc/tangent/relative_velocity.hpp>
 #include <ipc/utils/eigen_ext.hpp>
 
+#include <memory>
+
 namespace ipc {
 
 class TangentialCollision : virtual public CollisionStencil {
@@ -90,7 +92,10 @@ public:
 public:
     /// @brief Normal force magnitude
     double normal_force_magnitude;
-    std::shared_ptr<SmoothCollision> smooth_collision;
+    /// @brief Smooth collision this collision was built from (if any).
+    /// @note Shares ownership of the storage of the SmoothCollisions passed to
+    ///       TangentialCollisions::build_for_smooth_contact.
+    std::shared_ptr<const SmoothCollision> smooth_collision;
 
     /// @brief Ratio between normal and tangential forces (e.g., friction coefficient)
     double mu;
@@ -124,7 +124,7 @@ void TangentialCollisions::build_for_smooth_contact(
                 ptr = &(FC_fv.back());
             }
             if (ptr)
-                ptr->smooth_collision = collisions.collisions[i];
+                ptr->smooth_collision = collisions.shared_collision(i);
         } else {
             TangentialCollision* ptr = nullptr;
             if (const auto cvv = dynamic_cast<
@@ -161,7 +161,7 @@ void TangentialCollisions::build_for_smooth_contact(
                 ptr = &(FC_ev.back());
             }
             if (ptr)
-                ptr->smooth_collision = collisions.collisions[i];
+                ptr->smooth_collision = collisions.shared_collision(i);
         }
     }
 }
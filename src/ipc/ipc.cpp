@@ -3,6 +3,7 @@
 #include <ipc/config.hpp>
 #include <ipc/broad_phase/default_broad_phase.hpp>
 #include <ipc/candidates/candidates.hpp>
+#include <ipc/utils/atomic_min.hpp>
 #include <ipc/utils/intersection.hpp>
 #include <ipc/utils/world_bbox_diagonal_length.hpp>
 
@@ -12,8 +13,97 @@
 
 #include <igl/predicates/segment_segment_intersect.h>
 
+#include <atomic>
+#include <type_traits>
+
 namespace ipc {
 
+namespace {
+    /// @brief Number of candidates the broad phase passes to the narrow phase at once.
+    constexpr size_t CCD_TILE_SIZE = 1024;
+
+    /// @brief Narrow phase of compute_collision_free_stepsize run on tiles of candidates as the broad phase finds them.
+    class StreamingCCD {
+    public:
+        StreamingCCD(
+            const CollisionMesh& mesh,
+            Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
+            Eigen::ConstRef<Eigen::MatrixXd> vertices_t1,
+            const double min_distance,
+            const NarrowPhaseCCD& narrow_phase_ccd)
+            : m_mesh(mesh)
+            , m_vertices_t0(vertices_t0)
+            , m_vertices_t1(vertices_t1)
+            , m_min_distance(min_distance)
+            , m_narrow_phase_ccd(narrow_phase_ccd)
+        {
+        }
+
+        /// @brief Run CCD on a tile of candidates.
+        template <typename Candidate>
+        void operator()(const std::vector<Candidate>& tile)
+        {
+            const Eigen::MatrixXi& E = m_mesh.edges();
+            const Eigen::MatrixXi& F = m_mesh.faces();
+
+            double tmax = m_earliest_toi.load(std::memory_order_relaxed);
+
+            if constexpr (
+                std::is_same_v<Candidate, EdgeEdgeCandidate>
+                || std::is_same_v<Candidate, FaceVertexCandidate>) {
+                // Gather the queries and solve them as a batch.
+                Eigen::MatrixXd batch_t0(tile.size(), 12);
+                Eigen::MatrixXd batch_t1(tile.size(), 12);
+                for (size_t i = 0; i < tile.size(); i++) {
+                    batch_t0.row(i) =
+                        tile[i].dof(m_vertices_t0, E, F).transpose();
+                    batch_t1.row(i) =
+                        tile[i].dof(m_vertices_t1, E, F).transpose();
+                }
+
+                double toi = std::numeric_limits<double>::infinity();
+                bool are_colliding;
+                if constexpr (std::is_same_v<Candidate, EdgeEdgeCandidate>) {
+                    are_colliding = m_narrow_phase_ccd.batch_edge_edge_ccd(
+                        batch_t0, batch_t1, toi, m_min_distance, tmax);
+                } else {
+                    are_colliding =
+                        m_narrow_phase_ccd.batch_point_triangle_ccd(
+                            batch_t0, batch_t1, toi, m_min_distance, tmax);
+                }
+
+                if (are_colliding && toi < tmax) {
+                    atomic_min(m_earliest_toi, toi);
+                }
+            } else {
+                for (const Candidate& candidate : tile) {
+                    double toi = std::numeric_limits<double>::infinity();
+                    const bool are_colliding = candidate.ccd(
+                        candidate.dof(m_vertices_t0, E, F),
+                        candidate.dof(m_vertices_t1, E, F), toi,
+                        m_min_distance, tmax, m_narrow_phase_ccd);
+
+                    if (are_colliding && toi < tmax) {
+                        atomic_min(m_earliest_toi, toi);
+                    }
+                    tmax = m_earliest_toi.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /// @brief Earliest time of impact of the candidates seen so far.
+        double earliest_toi() const { return m_earliest_toi; }
+
+    private:
+        const CollisionMesh& m_mesh;
+        Eigen::ConstRef<Eigen::MatrixXd> m_vertices_t0;
+        Eigen::ConstRef<Eigen::MatrixXd> m_vertices_t1;
+        const double m_min_distance;
+        const NarrowPhaseCCD& m_narrow_phase_ccd;
+        std::atomic<double> m_earliest_toi = 1;
+    };
+} // namespace
+
 bool is_step_collision_free(
     const CollisionMesh& mesh,
     Eigen::ConstRef<Eigen::MatrixXd> vertices_t0,
@@ -75,15 +165,41 @@ double compute_collision_free_stepsize(
     assert(broad_phase->name() != "SweepAndTiniestQueue");
 #endif
 
+    if (mesh.num_codim_vertices()) {
+        // Codim. candidates need extra broad phases on subsets of the mesh, so
+        // build all candidates before the narrow phase.
+        Candidates candidates;
+        candidates.build(
+            mesh, vertices_t0, vertices_t1,
+            /*inflation_radius=*/0.5 * min_distance, broad_phase);
+
+        return candidates.compute_collision_free_stepsize(
+            mesh, vertices_t0, vertices_t1, min_distance, narrow_phase_ccd);
+    }
+
     // Broad phase
-    Candidates candidates;
-    candidates.build(
-        mesh, vertices_t0, vertices_t1, /*inflation_radius=*/0.5 * min_distance,
-        broad_phase);
+    broad_phase->can_vertices_collide = mesh.can_collide;
+    broad_phase->update(
+        vertices_t0, vertices_t1, mesh.edges(), mesh.faces(),
+        /*inflation_radius=*/0.5 * min_distance);
 
-    // Narrow phase
-    return candidates.compute_collision_free_stepsize(
+    // Narrow phase on tiles of candidates as they are found, so the
+    // candidates are never stored all at once.
+    StreamingCCD ccd(
         mesh, vertices_t0, vertices_t1, min_distance, narrow_phase_ccd);
+    const auto process_tile = [&](const auto& tile) { ccd(tile); };
+
+    if (vertices_t0.cols() == 2) {
+        broad_phase->stream_edge_vertex_candidates(process_tile, CCD_TILE_SIZE);
+    } else {
+        broad_phase->stream_edge_edge_candidates(process_tile, CCD_TILE_SIZE);
+        broad_phase->stream_face_vertex_candidates(
+            process_tile, CCD_TILE_SIZE);
+    }
+
+    const double earliest_toi = ccd.earliest_toi();
+    assert(earliest_toi >= 0 && earliest_toi <= 1.0);
+    return earliest_toi;
 }
 
 // ============================================================================
@@ -32,6 +32,7 @@ bool is_step_collision_free(
 
 /// @brief Computes a maximal step size that is collision free.
 /// @note Assumes the trajectory is linear.
+/// @note The broad phase streams tiles of candidates to the narrow phase instead of storing all of them, except for meshes with codimensional vertices.
 /// @param mesh The collision mesh.
 /// @param vertices_t0 Vertex vertices at start as rows of a matrix. Assumes vertices_t0 is intersection free.
 /// @param vertices_t1 Surface vertex vertices at end as rows of a matrix.
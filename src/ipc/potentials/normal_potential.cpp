@@ -1,7 +1,222 @@
 #include "normal_potential.hpp"
 
+#include <ipc/distance/edge_edge.hpp>
+#include <ipc/distance/edge_edge_mollifier.hpp>
+#include <ipc/distance/point_edge.hpp>
+#include <ipc/distance/point_point.hpp>
+#include <ipc/distance/point_triangle.hpp>
+#include <ipc/utils/local_to_global.hpp>
+#include <ipc/utils/MaybeParallelFor.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
 namespace ipc {
 
+namespace {
+    using VVGroup = PackedNormalCollisions::Group<2, PointPointDistanceType>;
+    using EVGroup = PackedNormalCollisions::Group<3, PointEdgeDistanceType>;
+    using EEGroup = PackedNormalCollisions::EdgeEdgeGroup;
+    using FVGroup = PackedNormalCollisions::Group<4, PointTriangleDistanceType>;
+
+    /// @brief Gather the positions of a collision's vertices.
+    template <size_t N>
+    VectorMax12d gather(
+        Eigen::ConstRef<Eigen::MatrixXd> X, const std::array<index_t, N>& ids)
+    {
+        const int dim = X.cols();
+        VectorMax12d x(N * dim);
+        for (int i = 0; i < N; i++) {
+            x.segment(dim * i, dim) = X.row(ids[i]);
+        }
+        return x;
+    }
+
+    // Distances of each group with the closest pair known at compile time.
+
+    double distance(const VVGroup&, size_t, Eigen::ConstRef<VectorMax12d> x)
+    {
+        const int dim = x.size() / 2;
+        return point_point_distance(x.head(dim), x.tail(dim));
+    }
+
+    VectorMax12d
+    distance_gradient(const VVGroup&, size_t, Eigen::ConstRef<VectorMax12d> x)
+    {
+        const int dim = x.size() / 2;
+        return point_point_distance_gradient(x.head(dim), x.tail(dim));
+    }
+
+    MatrixMax12d
+    distance_hessian(const VVGroup&, size_t, Eigen::ConstRef<VectorMax12d> x)
+    {
+        const int dim = x.size() / 2;
+        return point_point_distance_hessian(x.head(dim), x.tail(dim));
+    }
+
+    double
+    distance(const EVGroup& g, size_t i, Eigen::ConstRef<VectorMax12d> x)
+    {
+        const int dim = x.size() / 3;
+        return point_edge_distance(
+            x.head(dim), x.segment(dim, dim), x.tail(dim), g.dtypes[i]);
+    }
+
+    VectorMax12d distance_gradient(
+        const EVGroup& g, size_t i, Eigen::ConstRef<VectorMax12d> x)
+    {
+        const int dim = x.size() / 3;
+        return point_edge_distance_gradient(
+            x.head(dim), x.segment(dim, dim), x.tail(dim), g.dtypes[i]);
+    }
+
+    MatrixMax12d distance_hessian(
+        const EVGroup& g, size_t i, Eigen::ConstRef<VectorMax12d> x)
+    {
+        const int dim = x.size() / 3;
+        return point_edge_distance_hessian(
+            x.head(dim), x.segment(dim, dim), x.tail(dim), g.dtypes[i]);
+    }
+
+    double
+    distance(const EEGroup& g, size_t i, Eigen::ConstRef<VectorMax12d> x)
+    {
+        return edge_edge_distance(
+            x.segment<3>(0), x.segment<3>(3), x.segment<3>(6),
+            x.segment<3>(9), g.dtypes[i]);
+    }
+
+    VectorMax12d distance_gradient(
+        const EEGroup& g, size_t i, Eigen::ConstRef<VectorMax12d> x)
+    {
+        return edge_edge_distance_gradient(
+            x.segment<3>(0), x.segment<3>(3), x.segment<3>(6),
+            x.segment<3>(9), g.dtypes[i]);
+    }
+
+    MatrixMax12d distance_hessian(
+        const EEGroup& g, size_t i, Eigen::ConstRef<VectorMax12d> x)
+    {
+        return edge_edge_distance_hessian(
+            x.segment<3>(0), x.segment<3>(3), x.segment<3>(6),
+            x.segment<3>(9), g.dtypes[i]);
+    }
+
+    double
+    distance(const FVGroup& g, size_t i, Eigen::ConstRef<VectorMax12d> x)
+    {
+        return point_triangle_distance(
+            x.segment<3>(0), x.segment<3>(3), x.segment<3>(6),
+            x.segment<3>(9), g.dtypes[i]);
+    }
+
+    VectorMax12d distance_gradient(
+        const FVGroup& g, size_t i, Eigen::ConstRef<VectorMax12d> x)
+    {
+        return point_triangle_distance_gradient(
+            x.segment<3>(0), x.segment<3>(3), x.segment<3>(6),
+            x.segment<3>(9), g.dtypes[i]);
+    }
+
+    MatrixMax12d distance_hessian(
+        const FVGroup& g, size_t i, Eigen::ConstRef<VectorMax12d> x)
+    {
+        return point_triangle_distance_hessian(
+            x.segment<3>(0), x.segment<3>(3), x.segment<3>(6),
+            x.segment<3>(9), g.dtypes[i]);
+    }
+
+    // Only edge-edge collisions are mollified.
+
+    template <typename Group> constexpr bool is_mollified = false;
+    template <> constexpr bool is_mollified<EEGroup> = true;
+
+    double
+    mollifier(const EEGroup& g, size_t i, Eigen::ConstRef<VectorMax12d> x)
+    {
+        return edge_edge_mollifier(
+            x.segment<3>(0), x.segment<3>(3), x.segment<3>(6),
+            x.segment<3>(9), g.eps_x[i]);
+    }
+
+    VectorMax12d mollifier_gradient(
+        const EEGroup& g, size_t i, Eigen::ConstRef<VectorMax12d> x)
+    {
+        return edge_edge_mollifier_gradient(
+            x.segment<3>(0), x.segment<3>(3), x.segment<3>(6),
+            x.segment<3>(9), g.eps_x[i]);
+    }
+
+    MatrixMax12d mollifier_hessian(
+        const EEGroup& g, size_t i, Eigen::ConstRef<VectorMax12d> x)
+    {
+        return edge_edge_mollifier_hessian(
+            x.segment<3>(0), x.segment<3>(3), x.segment<3>(6),
+            x.segment<3>(9), g.eps_x[i]);
+    }
+
+    // Chain rule of w * m(x) * f(d(x)) shared by the packed and single
+    // collision methods. Unmollified collisions take m(x) = 1 and ∇m(x) = 0.
+
+    /// @brief ∇[w f(d(x))] = w f'(d(x)) ∇d(x)
+    VectorMax12d potential_gradient(
+        const double w,
+        const double grad_f,
+        Eigen::ConstRef<VectorMax12d> grad_d)
+    {
+        return (w * grad_f) * grad_d;
+    }
+
+    /// @brief ∇[w m(x) f(d(x))] = w f(d(x)) ∇m(x) + w m(x) f'(d(x)) ∇d(x)
+    VectorMax12d potential_gradient(
+        const double w,
+        const double f,
+        const double grad_f,
+        Eigen::ConstRef<VectorMax12d> grad_d,
+        const double m,
+        Eigen::ConstRef<VectorMax12d> grad_m)
+    {
+        return (w * f) * grad_m + (w * m * grad_f) * grad_d;
+    }
+
+    /// @brief ∇²[w f(d(x))] = w f"(d(x)) ∇d(x) ∇d(x)ᵀ + w f'(d(x)) ∇²d(x)
+    MatrixMax12d potential_hessian(
+        const double w,
+        const double grad_f,
+        const double hess_f,
+        Eigen::ConstRef<VectorMax12d> grad_d,
+        Eigen::ConstRef<MatrixMax12d> hess_d)
+    {
+        return (w * hess_f) * grad_d * grad_d.transpose()
+            + (w * grad_f) * hess_d;
+    }
+
+    /// @brief ∇²[w m(x) f(d(x))]
+    MatrixMax12d potential_hessian(
+        const double w,
+        const double f,
+        const double grad_f,
+        const double hess_f,
+        Eigen::ConstRef<VectorMax12d> grad_d,
+        Eigen::ConstRef<MatrixMax12d> hess_d,
+        const double m,
+        Eigen::ConstRef<VectorMax12d> grad_m,
+        Eigen::ConstRef<MatrixMax12d> hess_m)
+    {
+        // ∇f(d(x)) * ∇m(x)ᵀ
+        const MatrixMax12d grad_f_grad_m =
+            (w * grad_f) * grad_d * grad_m.transpose();
+
+        // ∇²[m(x) * f(d(x))] = ∇[∇m(x) * f(d(x)) + m(x) * ∇f(d(x))]
+        //                    = ∇²m(x) * f(d(x)) + ∇f(d(x)) * ∇m(x)ᵀ
+        //                      + ∇m(x) * ∇f(d(x))ᵀ + m(x) * ∇²f(d(x))
+        return (w * f) * hess_m + grad_f_grad_m + grad_f_grad_m.transpose()
+            + (w * m * hess_f) * grad_d * grad_d.transpose()
+            + (w * m * grad_f) * hess_d;
+    }
+} // namespace
+
 // -- Cumulative methods -------------------------------------------------------
 
 Eigen::SparseMatrix<double> NormalPotential::shape_derivative(
@@ -47,6 +262,201 @@ Eigen::SparseMatrix<double> NormalPotential::shape_derivative(
     return shape_derivative;
 }
 
+double NormalPotential::operator()(
+    const PackedNormalCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> X) const
+{
+    assert(X.rows() == mesh.num_vertices());
+
+    if (collisions.empty()) {
+        return 0;
+    }
+
+    tbb::enumerable_thread_specific<double> storage(0);
+
+    const auto accumulate = [&](const auto& group) {
+        using Group = std::decay_t<decltype(group)>;
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(size_t(0), group.size()),
+            [&](const tbb::blocked_range<size_t>& r) {
+                auto& local_potential = storage.local();
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    const VectorMax12d x = gather(X, group.vertex_ids[i]);
+                    // w * m(x) * f(d(x))
+                    double f = group.weights[i]
+                        * (*this)(distance(group, i, x), group.dmins[i]);
+                    if constexpr (is_mollified<Group>) {
+                        f *= mollifier(group, i, x);
+                    }
+                    local_potential += f;
+                }
+            });
+    };
+
+    accumulate(collisions.vv);
+    accumulate(collisions.ev);
+    accumulate(collisions.ee);
+    accumulate(collisions.fv);
+
+    double potential =
+        storage.combine([](double a, double b) { return a + b; });
+    for (const PlaneVertexNormalCollision& collision : collisions.pv) {
+        potential +=
+            (*this)(collision, collision.dof(X, mesh.edges(), mesh.faces()));
+    }
+    return potential;
+}
+
+Eigen::VectorXd NormalPotential::gradient(
+    const PackedNormalCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> X) const
+{
+    assert(X.rows() == mesh.num_vertices());
+
+    if (collisions.empty()) {
+        return Eigen::VectorXd::Zero(X.size());
+    }
+
+    const int dim = X.cols();
+
+    // Use sparse local storage if the collisions touch few of the DOF.
+    const size_t max_nonzeros = collisions.size() * element_size;
+    auto storage = ipc::utils::create_thread_storage(
+        LocalThreadVecStorage(X.size(), max_nonzeros));
+
+    const auto accumulate = [&](const auto& group) {
+        using Group = std::decay_t<decltype(group)>;
+        ipc::utils::maybe_parallel_for(
+            group.size(), [&](int start, int end, int thread_id) {
+                auto& global_grad =
+                    ipc::utils::get_local_thread_storage(storage, thread_id);
+
+                for (size_t i = start; i < end; i++) {
+                    const VectorMax12d x = gather(X, group.vertex_ids[i]);
+                    const double w = group.weights[i];
+
+                    // d(x)
+                    const double d = distance(group, i, x);
+                    // ∇d(x)
+                    const VectorMax12d grad_d = distance_gradient(group, i, x);
+                    // f'(d(x))
+                    const double grad_f = gradient(d, group.dmins[i]);
+
+                    VectorMax12d local_grad;
+                    if constexpr (!is_mollified<Group>) {
+                        local_grad = potential_gradient(w, grad_f, grad_d);
+                    } else {
+                        local_grad = potential_gradient(
+                            w, (*this)(d, group.dmins[i]), grad_f, grad_d,
+                            mollifier(group, i, x),
+                            mollifier_gradient(group, i, x));
+                    }
+
+                    local_gradient_to_global_gradient(
+                        local_grad, group.vertex_ids[i], dim, global_grad);
+                }
+            });
+    };
+
+    accumulate(collisions.vv);
+    accumulate(collisions.ev);
+    accumulate(collisions.ee);
+    accumulate(collisions.fv);
+
+    Eigen::VectorXd grad;
+    grad.setZero(X.size());
+    for (const auto& local_storage : storage)
+        local_storage.add_to(grad);
+
+    for (const PlaneVertexNormalCollision& collision : collisions.pv) {
+        local_gradient_to_global_gradient(
+            gradient(
+                collision, collision.dof(X, mesh.edges(), mesh.faces())),
+            collision.vertex_ids(mesh.edges(), mesh.faces()), dim, grad);
+    }
+    return grad;
+}
+
+Eigen::SparseMatrix<double> NormalPotential::hessian(
+    const PackedNormalCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> X,
+    const PSDProjectionMethod project_hessian_to_psd) const
+{
+    assert(X.rows() == mesh.num_vertices());
+
+    if (collisions.empty()) {
+        return Eigen::SparseMatrix<double>(X.size(), X.size());
+    }
+
+    const auto local_hessian = [&](const auto& group,
+                                   const size_t i) -> MatrixMax12d {
+        using Group = std::decay_t<decltype(group)>;
+
+        const VectorMax12d x = gather(X, group.vertex_ids[i]);
+        const double w = group.weights[i];
+        const double dmin = group.dmins[i];
+
+        // d(x)
+        const double d = distance(group, i, x);
+        // ∇d(x)
+        const VectorMax12d grad_d = distance_gradient(group, i, x);
+        // ∇²d(x)
+        const MatrixMax12d hess_d = distance_hessian(group, i, x);
+
+        // f'(d(x))
+        const double grad_f = gradient(d, dmin);
+        // f"(d(x))
+        const double hess_f = hessian(d, dmin);
+
+        MatrixMax12d hess;
+        if constexpr (!is_mollified<Group>) {
+            hess = potential_hessian(w, grad_f, hess_f, grad_d, hess_d);
+        } else {
+            hess = potential_hessian(
+                w, (*this)(d, dmin), grad_f, hess_f, grad_d, hess_d,
+                mollifier(group, i, x), mollifier_gradient(group, i, x),
+                mollifier_hessian(group, i, x));
+        }
+
+        // Need to project entire hessian because w can be negative
+        return project_to_psd(hess, project_hessian_to_psd);
+    };
+
+    const Eigen::MatrixXi& edges = mesh.edges();
+    const Eigen::MatrixXi& faces = mesh.faces();
+
+    HessianAssembler assembler;
+    assembler.init(
+        collisions.size(), X.rows(), X.cols(),
+        [&](size_t i) { return collisions.vertex_ids(i); },
+        [&](size_t i) { return collisions.num_vertices(i); });
+
+    return assembler.assemble([&](size_t i) -> MatrixMax12d {
+        if (i < collisions.vv.size()) {
+            return local_hessian(collisions.vv, i);
+        }
+        i -= collisions.vv.size();
+        if (i < collisions.ev.size()) {
+            return local_hessian(collisions.ev, i);
+        }
+        i -= collisions.ev.size();
+        if (i < collisions.ee.size()) {
+            return local_hessian(collisions.ee, i);
+        }
+        i -= collisions.ee.size();
+        if (i < collisions.fv.size()) {
+            return local_hessian(collisions.fv, i);
+        }
+        i -= collisions.fv.size();
+        const PlaneVertexNormalCollision& collision = collisions.pv[i];
+        return hessian(
+            collision, collision.dof(X, edges, faces), project_hessian_to_psd);
+    });
+}
+
 // -- Single collision methods -------------------------------------------------
 
 double NormalPotential::operator()(
@@ -75,17 +485,14 @@ VectorMax12d NormalPotential::gradient(
     const double grad_f = gradient(d, collision.dmin);
 
     if (!collision.is_mollified()) {
-        // ∇[f(d(x))] = f'(d(x)) * ∇d(x)
-        return (collision.weight * grad_f) * grad_d;
+        return potential_gradient(collision.weight, grad_f, grad_d);
     }
 
     const double m = collision.mollifier(positions); // m(x)
     const VectorMax12d grad_m =
         collision.mollifier_gradient(positions); // ∇m(x)
 
-    // ∇[m(x) * f(d(x))] = f(d(x)) * ∇m(x) + m(x) * ∇ f(d(x))
-    return (collision.weight * f) * grad_m
-        + (collision.weight * m * grad_f) * grad_d;
+    return potential_gradient(collision.weight, f, grad_f, grad_d, m, grad_m);
 }
 
 MatrixMax12d NormalPotential::hessian(
@@ -107,10 +514,8 @@ MatrixMax12d NormalPotential::hessian(
 
     MatrixMax12d hess;
     if (!collision.is_mollified()) {
-        // ∇²[f(d(x))] = ∇(f'(d(x)) * ∇d(x))
-        //             = f"(d(x)) * ∇d(x) * ∇d(x)ᵀ + f'(d(x)) * ∇²d(x)
-        hess = (collision.weight * hess_f) * grad_d * grad_d.transpose()
-            + (collision.weight * grad_f) * hess_d;
+        hess = potential_hessian(
+            collision.weight, grad_f, hess_f, grad_d, hess_d);
     } else {
         const double f = (*this)(d, collision.dmin); // f(d(x))
 
@@ -121,19 +526,9 @@ MatrixMax12d NormalPotential::hessian(
         // ∇² m(x)
         const MatrixMax12d hess_m = collision.mollifier_hessian(positions);
 
-        const double weighted_m = collision.weight * m;
-
-        // ∇f(d(x)) * ∇m(x)ᵀ
-        const MatrixMax12d grad_f_grad_m =
-            (collision.weight * grad_f) * grad_d * grad_m.transpose();
-
-        // ∇²[m(x) * f(d(x))] = ∇[∇m(x) * f(d(x)) + m(x) * ∇f(d(x))]
-        //                    = ∇²m(x) * f(d(x)) + ∇f(d(x)) * ∇m(x)ᵀ
-        //                      + ∇m(x) * ∇f(d(x))ᵀ + m(x) * ∇²f(d(x))
-        hess = (collision.weight * f) * hess_m + grad_f_grad_m
-            + grad_f_grad_m.transpose()
-            + (weighted_m * hess_f) * grad_d * grad_d.transpose()
-            + (weighted_m * grad_f) * hess_d;
+        hess = potential_hessian(
+            collision.weight, f, grad_f, hess_f, grad_d, hess_d, m, grad_m,
+            hess_m);
     }
 
     // Need to project entire hessian because w can be negative
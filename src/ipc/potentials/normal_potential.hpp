@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ipc/collisions/normal/normal_collisions.hpp>
+#include <ipc/collisions/normal/packed_normal_collisions.hpp>
 #include <ipc/potentials/potential.hpp>
 
 namespace ipc {
@@ -32,6 +33,39 @@ public:
         const CollisionMesh& mesh,
         Eigen::ConstRef<Eigen::MatrixXd> vertices) const;
 
+    /// @brief Compute the potential for a packed set of collisions.
+    /// @param collisions The packed set of collisions.
+    /// @param mesh The collision mesh.
+    /// @param X Degrees of freedom of the collision mesh (e.g., vertices or velocities).
+    /// @returns The potential for a set of collisions.
+    double operator()(
+        const PackedNormalCollisions& collisions,
+        const CollisionMesh& mesh,
+        Eigen::ConstRef<Eigen::MatrixXd> X) const;
+
+    /// @brief Compute the gradient of the potential for a packed set of collisions.
+    /// @param collisions The packed set of collisions.
+    /// @param mesh The collision mesh.
+    /// @param X Degrees of freedom of the collision mesh (e.g., vertices or velocities).
+    /// @returns The gradient of the potential w.r.t. X. This will have a size of |X|.
+    Eigen::VectorXd gradient(
+        const PackedNormalCollisions& collisions,
+        const CollisionMesh& mesh,
+        Eigen::ConstRef<Eigen::MatrixXd> X) const;
+
+    /// @brief Compute the hessian of the potential for a packed set of collisions.
+    /// @param collisions The packed set of collisions.
+    /// @param mesh The collision mesh.
+    /// @param X Degrees of freedom of the collision mesh (e.g., vertices or velocities).
+    /// @param project_hessian_to_psd Make sure the hessian is positive semi-definite.
+    /// @returns The Hessian of the potential w.r.t. X. This will have a size of |X|×|X|.
+    Eigen::SparseMatrix<double> hessian(
+        const PackedNormalCollisions& collisions,
+        const CollisionMesh& mesh,
+        Eigen::ConstRef<Eigen::MatrixXd> X,
+        const PSDProjectionMethod project_hessian_to_psd =
+            PSDProjectionMethod::NONE) const;
+
     // -- Single collision methods ---------------------------------------------
 
     /// @brief Compute the potential for a single collision.
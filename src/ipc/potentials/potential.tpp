@@ -54,8 +54,10 @@ Eigen::VectorXd Potential<TCollisions>::gradient(
 
     const int dim = X.cols();
 
-    auto storage = ipc::utils::create_thread_storage<Eigen::VectorXd>(
-        Eigen::VectorXd::Zero(X.size()));
+    // Use sparse local storage if the collisions touch few of the DOF.
+    const size_t max_nonzeros = collisions.size() * element_size;
+    auto storage = ipc::utils::create_thread_storage(
+        LocalThreadVecStorage(X.size(), max_nonzeros));
     ipc::utils::maybe_parallel_for(
         collisions.size(), [&](int start, int end, int thread_id) {
             auto& global_grad =
@@ -80,7 +82,7 @@ Eigen::VectorXd Potential<TCollisions>::gradient(
     Eigen::VectorXd grad;
     grad.setZero(X.size());
     for (const auto& local_storage : storage)
-        grad += local_storage;
+        local_storage.add_to(grad);
     return grad;
 }
 
@@ -100,120 +102,177 @@ Eigen::SparseMatrix<double> Potential<TCollisions>::hessian(
     const Eigen::MatrixXi& edges = mesh.edges();
     const Eigen::MatrixXi& faces = mesh.faces();
 
-    const int dim = X.cols();
-    const int ndof = X.size();
+    // Color the collisions and write their local Hessians directly into the
+    // compressed matrix.
+    HessianAssembler assembler;
+    assembler.init(
+        collisions.size(), X.rows(), X.cols(),
+        [&](size_t i) { return collisions[i].vertex_ids(edges, faces); },
+        [&](size_t i) { return collisions[i].num_vertices(); });
+
+    return assembler.assemble([&](size_t i) {
+        return this->hessian(
+            collisions[i], collisions[i].dof(X, edges, faces),
+            project_hessian_to_psd);
+    });
+}
 
-    const int max_triplets_size = int(1e7);
-    const int buffer_size = std::min(max_triplets_size, ndof);
-    auto storage = ipc::utils::create_thread_storage(
-        LocalThreadMatStorage(buffer_size, ndof, ndof));
-    ipc::utils::maybe_parallel_for(
-        collisions.size(), [&](int start, int end, int thread_id) {
-            auto& hess_triplets =
-                ipc::utils::get_local_thread_storage(storage, thread_id);
+template <class TCollisions>
+bool Potential<TCollisions>::hessian(
+    const TCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> X,
+    HessianAssembler& assembler,
+    Eigen::SparseMatrix<double>& hess,
+    const PSDProjectionMethod project_hessian_to_psd) const
+{
+    assert(X.rows() == mesh.num_vertices());
 
-            for (size_t i = start; i < end; i++) {
-                const TCollision& collision = collisions[i];
+    const Eigen::MatrixXi& edges = mesh.edges();
+    const Eigen::MatrixXi& faces = mesh.faces();
 
-                const MatrixMax<
-                    double, Potential<TCollisions>::element_size,
-                    Potential<TCollisions>::element_size>
-                    local_hess = this->hessian(
-                        collisions[i], collisions[i].dof(X, edges, faces),
-                        project_hessian_to_psd);
+    const bool pattern_changed = assembler.update(
+        collisions.size(), X.rows(), X.cols(),
+        [&](size_t i) { return collisions[i].vertex_ids(edges, faces); },
+        [&](size_t i) { return collisions[i].num_vertices(); });
 
-                const std::array<index_t, TCollision::element_size> vids =
-                    collision.vertex_ids(edges, faces);
+    assembler.assemble(
+        [&](size_t i) {
+            return this->hessian(
+                collisions[i], collisions[i].dof(X, edges, faces),
+                project_hessian_to_psd);
+        },
+        hess);
 
-                local_hessian_to_global_triplets(
-                    local_hess, vids, dim, *(hess_triplets.cache));
-            }
+    return pattern_changed;
+}
+
+template <class TCollisions>
+BlockSparseMatrix Potential<TCollisions>::block_hessian(
+    const TCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> X,
+    const PSDProjectionMethod project_hessian_to_psd) const
+{
+    assert(X.rows() == mesh.num_vertices());
+
+    const Eigen::MatrixXi& edges = mesh.edges();
+    const Eigen::MatrixXi& faces = mesh.faces();
+
+    HessianAssembler assembler;
+    assembler.init(
+        collisions.size(), X.rows(), X.cols(),
+        [&](size_t i) { return collisions[i].vertex_ids(edges, faces); },
+        [&](size_t i) { return collisions[i].num_vertices(); });
+
+    return assembler.assemble_blocks([&](size_t i) {
+        return this->hessian(
+            collisions[i], collisions[i].dof(X, edges, faces),
+            project_hessian_to_psd);
+    });
+}
+
+template <class TCollisions>
+Eigen::VectorXd Potential<TCollisions>::hessian_vector_product(
+    const TCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> X,
+    Eigen::ConstRef<Eigen::VectorXd> v,
+    const PSDProjectionMethod project_hessian_to_psd) const
+{
+    assert(X.rows() == mesh.num_vertices());
+    assert(v.size() == X.size());
+
+    return hessian_vector_product(
+        collisions, mesh, X.cols(), v, [&](size_t i) {
+            return this->hessian(
+                collisions[i],
+                collisions[i].dof(X, mesh.edges(), mesh.faces()),
+                project_hessian_to_psd);
         });
+}
 
-    Eigen::SparseMatrix<double> hess(ndof, ndof);
+template <class TCollisions>
+std::vector<MatrixMax<
+    double,
+    Potential<TCollisions>::element_size,
+    Potential<TCollisions>::element_size>>
+Potential<TCollisions>::local_hessians(
+    const TCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> X,
+    const PSDProjectionMethod project_hessian_to_psd) const
+{
+    assert(X.rows() == mesh.num_vertices());
 
-    // Assemble the stiffness matrix by concatenating the tuples in each local
-    // storage
+    std::vector<MatrixMax<double, element_size, element_size>> hessians(
+        collisions.size());
 
-    // Collect thread storages
-    std::vector<LocalThreadMatStorage*> storages(storage.size());
-    int index = 0;
-    for (auto& local_storage : storage) {
-        storages[index++] = &local_storage;
-    }
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), collisions.size()),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                hessians[i] = this->hessian(
+                    collisions[i],
+                    collisions[i].dof(X, mesh.edges(), mesh.faces()),
+                    project_hessian_to_psd);
+            }
+        });
 
-    utils::maybe_parallel_for(
-        storages.size(), [&](int i) { storages[i]->cache->prune(); });
+    return hessians;
+}
 
-    if (storage.size() == 0) {
-        return Eigen::SparseMatrix<double>();
-    }
+template <class TCollisions>
+Eigen::VectorXd Potential<TCollisions>::hessian_vector_product(
+    const TCollisions& collisions,
+    const CollisionMesh& mesh,
+    const std::vector<MatrixMax<double, element_size, element_size>>&
+        local_hessians,
+    Eigen::ConstRef<Eigen::VectorXd> v) const
+{
+    assert(local_hessians.size() == collisions.size());
+    assert(v.size() % mesh.num_vertices() == 0);
 
-    // Prepares for parallel concatenation
-    std::vector<int> offsets(storage.size());
+    return hessian_vector_product(
+        collisions, mesh, v.size() / mesh.num_vertices(), v,
+        [&](size_t i) -> const auto& { return local_hessians[i]; });
+}
 
-    index = 0;
-    int triplet_count = 0;
-    for (auto& local_storage : storage) {
-        offsets[index++] = triplet_count;
-        triplet_count += local_storage.cache->triplet_count();
+template <class TCollisions>
+template <typename LocalHessian>
+Eigen::VectorXd Potential<TCollisions>::hessian_vector_product(
+    const TCollisions& collisions,
+    const CollisionMesh& mesh,
+    const int dim,
+    Eigen::ConstRef<Eigen::VectorXd> v,
+    LocalHessian&& local_hessian) const
+{
+    if (collisions.empty()) {
+        return Eigen::VectorXd::Zero(v.size());
     }
 
-    std::vector<Eigen::Triplet<double>> triplets;
-
-    assert(storages.size() >= 1);
-    if (storages[0]->cache->is_dense()) {
-        // Serially merge local storages
-        Eigen::MatrixXd tmp(hess);
-        for (const auto& local_storage : storage)
-            tmp += dynamic_cast<const DenseMatrixCache&>(*local_storage.cache)
-                       .mat();
-        hess = tmp.sparseView();
-        hess.makeCompressed();
-    } else if (triplet_count >= triplets.max_size()) {
-        // Serial fallback version in case the vector of triplets cannot be
-        // allocated
-
-        logger().warn(
-            "Cannot allocate space for triplets, switching to serial assembly.");
-
-        // Serially merge local storages
-        for (LocalThreadMatStorage& local_storage : storage)
-            hess += local_storage.cache->get_matrix(false); // will also prune
-        hess.makeCompressed();
-    } else {
-        triplets.resize(triplet_count);
-
-        // Parallel copy into triplets
-        utils::maybe_parallel_for(storages.size(), [&](int i) {
-            const SparseMatrixCache& cache =
-                dynamic_cast<const SparseMatrixCache&>(*storages[i]->cache);
-            int offset = offsets[i];
-
-            std::copy(
-                cache.entries().begin(), cache.entries().end(),
-                triplets.begin() + offset);
-            offset += cache.entries().size();
-
-            if (cache.mat().nonZeros() > 0) {
-                int count = 0;
-                for (int k = 0; k < cache.mat().outerSize(); ++k) {
-                    for (Eigen::SparseMatrix<double>::InnerIterator it(
-                             cache.mat(), k);
-                         it; ++it) {
-                        assert(count < cache.mat().nonZeros());
-                        triplets[offset + count++] = Eigen::Triplet<double>(
-                            it.row(), it.col(), it.value());
-                    }
-                }
+    // Use sparse local storage if the collisions touch few of the DOF.
+    const size_t max_nonzeros = collisions.size() * element_size;
+    auto storage = ipc::utils::create_thread_storage(
+        LocalThreadVecStorage(v.size(), max_nonzeros));
+    ipc::utils::maybe_parallel_for(
+        collisions.size(), [&](int start, int end, int thread_id) {
+            auto& global_hess_v =
+                ipc::utils::get_local_thread_storage(storage, thread_id);
+
+            for (size_t i = start; i < end; i++) {
+                local_hessian_vector_product_to_global(
+                    local_hessian(i),
+                    collisions[i].vertex_ids(mesh.edges(), mesh.faces()), dim,
+                    v, global_hess_v);
             }
         });
 
-        // Sort and assemble
-        hess.setFromTriplets(triplets.begin(), triplets.end());
-    }
-
-    return hess;
+    Eigen::VectorXd hess_v;
+    hess_v.setZero(v.size());
+    for (const auto& local_storage : storage)
+        local_storage.add_to(hess_v);
+    return hess_v;
 }
 
 } // namespace ipc
\ No newline at end of file
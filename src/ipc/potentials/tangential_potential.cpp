@@ -1,5 +1,7 @@
 #include "friction_potential.hpp"
 
+#include <ipc/utils/merge_thread_local.hpp>
+
 namespace ipc {
 
 // -- Cumulative methods -------------------------------------------------------
@@ -15,22 +17,45 @@ Eigen::VectorXd TangentialPotential::force(
     const double dmin,
     const bool no_mu) const
 {
+    Eigen::VectorXd out = Eigen::VectorXd::Zero(velocities.size());
+    force(
+        collisions, mesh, rest_positions, lagged_displacements, velocities,
+        normal_potential, normal_stiffness, out, dmin, no_mu);
+    return out;
+}
+
+void TangentialPotential::force(
+    const TangentialCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> rest_positions,
+    Eigen::ConstRef<Eigen::MatrixXd> lagged_displacements,
+    Eigen::ConstRef<Eigen::MatrixXd> velocities,
+    const NormalPotential& normal_potential,
+    const double normal_stiffness,
+    Eigen::Ref<Eigen::VectorXd> out,
+    const double dmin,
+    const bool no_mu) const
+{
+    assert(out.size() == velocities.size());
+
     if (collisions.empty()) {
-        return Eigen::VectorXd::Zero(velocities.size());
+        return;
     }
 
     const int dim = velocities.cols();
     const Eigen::MatrixXi& edges = mesh.edges();
     const Eigen::MatrixXi& faces = mesh.faces();
 
-    tbb::combinable<Eigen::VectorXd> storage(
-        Eigen::VectorXd::Zero(velocities.size()));
+    // Use sparse local storage if the collisions touch few of the DOF.
+    const size_t max_nonzeros = collisions.size() * element_size;
+    auto storage = ipc::utils::create_thread_storage(
+        LocalThreadVecStorage(velocities.size(), max_nonzeros));
+    ipc::utils::maybe_parallel_for(
+        collisions.size(), [&](int start, int end, int thread_id) {
+            auto& global_force =
+                ipc::utils::get_local_thread_storage(storage, thread_id);
 
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(size_t(0), collisions.size()),
-        [&](const tbb::blocked_range<size_t>& r) {
-            Eigen::VectorXd& global_force = storage.local();
-            for (size_t i = r.begin(); i < r.end(); i++) {
+            for (size_t i = start; i < end; i++) {
                 const auto& collision = collisions[i];
 
                 const VectorMax12d local_force = force(
@@ -47,8 +72,9 @@ Eigen::VectorXd TangentialPotential::force(
             }
         });
 
-    return storage.combine([](const Eigen::VectorXd& a,
-                              const Eigen::VectorXd& b) { return a + b; });
+    for (const auto& local_storage : storage) {
+        local_storage.add_to(out);
+    }
 }
 
 Eigen::SparseMatrix<double> TangentialPotential::force_jacobian(
@@ -68,72 +94,126 @@ Eigen::SparseMatrix<double> TangentialPotential::force_jacobian(
     }
 
     const int dim = velocities.cols();
-    Eigen::ConstRef<Eigen::MatrixXi> edges = mesh.edges();
-    Eigen::ConstRef<Eigen::MatrixXi> faces = mesh.faces();
-
-    tbb::enumerable_thread_specific<std::vector<Eigen::Triplet<double>>>
-        storage;
-
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(size_t(0), collisions.size()),
-        [&](const tbb::blocked_range<size_t>& r) {
-            auto& jac_triplets = storage.local();
-
-            for (size_t i = r.begin(); i < r.end(); i++) {
-                const TangentialCollision& collision = collisions[i];
-
-                const MatrixMax12d local_force_jacobian = force_jacobian(
-                    collision, collision.dof(rest_positions, edges, faces),
-                    collision.dof(lagged_displacements, edges, faces),
-                    collision.dof(velocities, edges, faces), //
-                    normal_potential, normal_stiffness, wrt, dmin);
-
-                const std::array<index_t, 4> vis =
-                    collision.vertex_ids(mesh.edges(), mesh.faces());
-
-                local_hessian_to_global_triplets(
-                    local_force_jacobian, vis, dim, jac_triplets);
-            }
-        });
+    const Eigen::MatrixXi& edges = mesh.edges();
+    const Eigen::MatrixXi& faces = mesh.faces();
 
-    Eigen::SparseMatrix<double> jacobian(velocities.size(), velocities.size());
-    for (const auto& local_jac_triplets : storage) {
-        Eigen::SparseMatrix<double> local_jacobian(
-            velocities.size(), velocities.size());
-        local_jacobian.setFromTriplets(
-            local_jac_triplets.begin(), local_jac_triplets.end());
-        jacobian += local_jacobian;
-    }
+    // Color the collisions and write their local Jacobians directly into the
+    // compressed matrix.
+    HessianAssembler assembler;
+    assembler.init(
+        collisions.size(), velocities.rows(), dim,
+        [&](size_t i) { return collisions[i].vertex_ids(edges, faces); },
+        [&](size_t i) { return collisions[i].num_vertices(); });
+
+    Eigen::SparseMatrix<double> jacobian = assembler.assemble([&](size_t i) {
+        const TangentialCollision& collision = collisions[i];
+        return force_jacobian(
+            collision, collision.dof(rest_positions, edges, faces),
+            collision.dof(lagged_displacements, edges, faces),
+            collision.dof(velocities, edges, faces), //
+            normal_potential, normal_stiffness, wrt, dmin);
+    });
 
     // if wrt == X then compute ∇ₓ w(x)
     if (wrt == DiffWRT::REST_POSITIONS) {
-        for (int i = 0; i < collisions.size(); i++) {
+        for (size_t i = 0; i < collisions.size(); i++) {
             const TangentialCollision& collision = collisions[i];
             assert(collision.weight_gradient.size() == rest_positions.size());
             if (collision.weight_gradient.size() != rest_positions.size()) {
                 throw std::runtime_error(
                     "Shape derivative is not computed for friction collision!");
             }
+        }
 
-            VectorMax12d local_force = force(
-                collision, collision.dof(rest_positions, edges, faces),
-                collision.dof(lagged_displacements, edges, faces),
-                collision.dof(velocities, edges, faces), //
-                normal_potential, normal_stiffness, dmin);
-            assert(collision.weight != 0);
-            local_force /= collision.weight;
+        // Add the outer products (F / w) ⊗ ∇w as triplets in one pass.
+        tbb::enumerable_thread_specific<std::vector<Eigen::Triplet<double>>>
+            storage;
 
-            Eigen::SparseVector<double> force(rest_positions.size());
-            force.reserve(local_force.size());
-            local_gradient_to_global_gradient(
-                local_force, collision.vertex_ids(edges, faces), dim, force);
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(size_t(0), collisions.size()),
+            [&](const tbb::blocked_range<size_t>& r) {
+                auto& triplets = storage.local();
 
-            jacobian += force * collision.weight_gradient.transpose();
-        }
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    const TangentialCollision& collision = collisions[i];
+
+                    VectorMax12d local_force = force(
+                        collision, collision.dof(rest_positions, edges, faces),
+                        collision.dof(lagged_displacements, edges, faces),
+                        collision.dof(velocities, edges, faces), //
+                        normal_potential, normal_stiffness, dmin);
+                    assert(collision.weight != 0);
+                    local_force /= collision.weight;
+
+                    const std::array<index_t, 4> vis =
+                        collision.vertex_ids(edges, faces);
+
+                    for (Eigen::SparseVector<double>::InnerIterator it(
+                             collision.weight_gradient);
+                         it; ++it) {
+                        for (int j = 0; j < local_force.size(); j++) {
+                            triplets.emplace_back(
+                                dim * vis[j / dim] + j % dim, it.index(),
+                                local_force[j] * it.value());
+                        }
+                    }
+                }
+            });
+
+        std::vector<Eigen::Triplet<double>> triplets;
+        merge_thread_local_vectors(storage, triplets);
+
+        Eigen::SparseMatrix<double> weight_jacobian(
+            velocities.size(), rest_positions.size());
+        weight_jacobian.setFromTriplets(triplets.begin(), triplets.end());
+        jacobian += weight_jacobian;
     }
 
     return jacobian;
 }
+
+BlockSparseMatrix TangentialPotential::block_force_jacobian(
+    const TangentialCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> rest_positions,
+    Eigen::ConstRef<Eigen::MatrixXd> lagged_displacements,
+    Eigen::ConstRef<Eigen::MatrixXd> velocities,
+    const NormalPotential& normal_potential,
+    const double normal_stiffness,
+    const DiffWRT wrt,
+    const double dmin) const
+{
+    const int dim = velocities.cols();
+
+    // The shape derivative couples every collision to the vertices of its
+    // weight gradient, so it does not share the collision block pattern.
+    if (wrt == DiffWRT::REST_POSITIONS) {
+        return BlockSparseMatrix(
+            force_jacobian(
+                collisions, mesh, rest_positions, lagged_displacements,
+                velocities, normal_potential, normal_stiffness, wrt, dmin),
+            dim);
+    }
+
+    const Eigen::MatrixXi& edges = mesh.edges();
+    const Eigen::MatrixXi& faces = mesh.faces();
+
+    HessianAssembler assembler;
+    assembler.init(
+        collisions.size(), velocities.rows(), dim,
+        [&](size_t i) { return collisions[i].vertex_ids(edges, faces); },
+        [&](size_t i) { return collisions[i].num_vertices(); });
+
+    return assembler.assemble_blocks([&](size_t i) {
+        const TangentialCollision& collision = collisions[i];
+        return force_jacobian(
+            collision, collision.dof(rest_positions, edges, faces),
+            collision.dof(lagged_displacements, edges, faces),
+            collision.dof(velocities, edges, faces), //
+            normal_potential, normal_stiffness, wrt, dmin);
+    });
+}
+
 // -- Single collision methods -------------------------------------------------
 
 double TangentialPotential::operator()(
@@ -580,7 +660,7 @@ Eigen::SparseMatrix<double> TangentialPotential::smooth_contact_force_jacobian(
                 Eigen::VectorXd normal_force_grad;
                 std::vector<index_t> cc_vert_ids;
                 Eigen::MatrixXd Xt = rest_positions + lagged_displacements;
-                auto cc = collision.smooth_collision;
+                const auto& cc = collision.smooth_collision;
                 const Eigen::VectorXd contact_grad =
                     cc->gradient(cc->dof(Xt), params);
                 const Eigen::MatrixXd contact_hess =
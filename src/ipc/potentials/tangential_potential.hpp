@@ -50,6 +50,30 @@ public:
         const double dmin = 0,
         const bool no_mu = false) const;
 
+    /// @brief Add the friction force from the given velocities to a vector.
+    /// @note This allows summing several forces into one buffer without allocating a vector per force.
+    /// @param collisions The set of collisions.
+    /// @param mesh The collision mesh.
+    /// @param rest_positions Rest positions of the vertices (rowwise).
+    /// @param lagged_displacements Previous displacements of the vertices (rowwise).
+    /// @param velocities Current displacements of the vertices (rowwise).
+    /// @param normal_potential Normal potential (used for normal force magnitude).
+    /// @param normal_stiffness Normal stiffness (used for normal force magnitude).
+    /// @param[in,out] out Vector of size |velocities| to add the friction force to.
+    /// @param dmin Minimum distance (used for normal force magnitude).
+    /// @param no_mu whether to not multiply by mu
+    void force(
+        const TangentialCollisions& collisions,
+        const CollisionMesh& mesh,
+        Eigen::ConstRef<Eigen::MatrixXd> rest_positions,
+        Eigen::ConstRef<Eigen::MatrixXd> lagged_displacements,
+        Eigen::ConstRef<Eigen::MatrixXd> velocities,
+        const NormalPotential& normal_potential,
+        const double normal_stiffness,
+        Eigen::Ref<Eigen::VectorXd> out,
+        const double dmin = 0,
+        const bool no_mu = false) const;
+
     /// @brief Compute the Jacobian of the friction force wrt the velocities.
     /// @param collisions The set of collisions.
     /// @param mesh The collision mesh.
@@ -72,6 +96,28 @@ public:
         const DiffWRT wrt,
         const double dmin = 0) const;
 
+    /// @brief Compute the Jacobian of the friction force as dim×dim vertex blocks.
+    /// @param collisions The set of collisions.
+    /// @param mesh The collision mesh.
+    /// @param rest_positions Rest positions of the vertices (rowwise).
+    /// @param lagged_displacements Previous displacements of the vertices (rowwise).
+    /// @param velocities Current displacements of the vertices (rowwise).
+    /// @param normal_potential Normal potential (used for normal force magnitude).
+    /// @param normal_stiffness Normal stiffness (used for normal force magnitude).
+    /// @param wrt The variable to take the derivative with respect to.
+    /// @param dmin Minimum distance (used for normal force magnitude).
+    /// @return The block sparse Jacobian of the friction force.
+    BlockSparseMatrix block_force_jacobian(
+        const TangentialCollisions& collisions,
+        const CollisionMesh& mesh,
+        Eigen::ConstRef<Eigen::MatrixXd> rest_positions,
+        Eigen::ConstRef<Eigen::MatrixXd> lagged_displacements,
+        Eigen::ConstRef<Eigen::MatrixXd> velocities,
+        const NormalPotential& normal_potential,
+        const double normal_stiffness,
+        const DiffWRT wrt,
+        const double dmin = 0) const;
+
     Eigen::VectorXd smooth_contact_force(
         const TangentialCollisions& collisions,
         const CollisionMesh& mesh,
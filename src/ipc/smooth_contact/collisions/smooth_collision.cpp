@@ -132,7 +132,7 @@ SmoothCollisionTemplate<PrimitiveA, PrimitiveB>::SmoothCollisionTemplate(
 
 template <typename PrimitiveA, typename PrimitiveB>
 double SmoothCollisionTemplate<PrimitiveA, PrimitiveB>::operator()(
-    Eigen::ConstRef<Vector<double, -1, element_size>> positions,
+    Eigen::ConstRef<Eigen::VectorXd> positions,
     const ParameterType& params) const
 {
     Vector<double, n_core_points * dim> x;
@@ -166,8 +166,8 @@ double SmoothCollisionTemplate<PrimitiveA, PrimitiveB>::operator()(
 
 template <typename PrimitiveA, typename PrimitiveB>
 auto SmoothCollisionTemplate<PrimitiveA, PrimitiveB>::gradient(
-    Eigen::ConstRef<Vector<double, -1, element_size>> positions,
-    const ParameterType& params) const -> Vector<double, -1, element_size>
+    Eigen::ConstRef<Eigen::VectorXd> positions,
+    const ParameterType& params) const -> Eigen::VectorXd
 {
     const auto core_indices = get_core_indices();
 
@@ -273,10 +273,10 @@ auto SmoothCollisionTemplate<PrimitiveA, PrimitiveB>::gradient(
 }
 
 template <typename PrimitiveA, typename PrimitiveB>
-auto SmoothCollisionTemplate<PrimitiveA, PrimitiveB>::hessian(
-    Eigen::ConstRef<Vector<double, -1, element_size>> positions,
-    const ParameterType& params) const
-    -> MatrixMax<double, element_size, element_size>
+void SmoothCollisionTemplate<PrimitiveA, PrimitiveB>::hessian(
+    Eigen::ConstRef<Eigen::VectorXd> positions,
+    const ParameterType& params,
+    Eigen::MatrixXd& hess) const
 {
     const auto core_indices = get_core_indices();
 
@@ -395,79 +395,74 @@ auto SmoothCollisionTemplate<PrimitiveA, PrimitiveB>::hessian(
     }
 
     // grad of tangent/normal terms
-    double orient = 0;
-    Vector<double, -1, element_size> gOrient;
-    MatrixMax<double, element_size, element_size> hOrient;
+    const int nA = pA->n_dofs(), nB = pB->n_dofs();
+    const double potential_a =
+        pA->potential(closest_direction, positions.head(nA));
+    const double potential_b =
+        pB->potential(-closest_direction, positions.tail(nB));
+    const double orient = potential_a * potential_b;
+
+    Vector<double, -1, element_size>
+        gA = Vector<double, -1, element_size>::Zero(n_dofs()),
+        gB = Vector<double, -1, element_size>::Zero(n_dofs());
+    gA(core_indices) =
+        closest_direction_grad.transpose() * gA_reduced.head(dim);
+    gA.head(nA) += gA_reduced.tail(nA);
+    gB(core_indices) =
+        closest_direction_grad.transpose() * -gB_reduced.head(dim);
+    gB.tail(nB) += gB_reduced.tail(nB);
+    const Vector<double, -1, element_size> gOrient =
+        gA * potential_b + gB * potential_a;
+
+    // hOrient = potential_b * hA + potential_a * hB + gA * gBᵀ + gB * gAᵀ,
+    // accumulated directly into hess.
+    hess.setZero(n_dofs(), n_dofs());
     {
-        Vector<double, -1, element_size>
-            gA = Vector<double, -1, element_size>::Zero(n_dofs()),
-            gB = Vector<double, -1, element_size>::Zero(n_dofs());
-        MatrixMax<double, element_size, element_size>
-            hA = MatrixMax<double, element_size, element_size>::Zero(
-                n_dofs(), n_dofs()),
-            hB = MatrixMax<double, element_size, element_size>::Zero(
-                n_dofs(), n_dofs());
-        {
-            gA(core_indices) =
-                closest_direction_grad.transpose() * gA_reduced.head(dim);
-            gA.head(pA->n_dofs()) += gA_reduced.tail(pA->n_dofs());
-
-            hA(core_indices, core_indices) = closest_direction_grad.transpose()
-                * hA_reduced.topLeftCorner(dim, dim) * closest_direction_grad;
-            for (int d = 0; d < dim; d++)
-                hA(core_indices, core_indices) +=
-                    gA_reduced(d) * closest_direction_hess[d];
-
-            hA.topLeftCorner(pA->n_dofs(), pA->n_dofs()) +=
-                hA_reduced.bottomRightCorner(pA->n_dofs(), pA->n_dofs());
-            hA(core_indices, Eigen::seqN(0, pA->n_dofs())) +=
-                closest_direction_grad.transpose()
-                * hA_reduced.topRightCorner(dim, pA->n_dofs());
-            hA(Eigen::seqN(0, pA->n_dofs()), core_indices) +=
-                hA_reduced.bottomLeftCorner(pA->n_dofs(), dim)
-                * closest_direction_grad;
-
-            gB(core_indices) =
-                closest_direction_grad.transpose() * -gB_reduced.head(dim);
-            gB.tail(pB->n_dofs()) += gB_reduced.tail(pB->n_dofs());
-
-            hB(core_indices, core_indices) = closest_direction_grad.transpose()
-                * hB_reduced.topLeftCorner(dim, dim) * closest_direction_grad;
-            for (int d = 0; d < dim; d++)
-                hB(core_indices, core_indices) -=
-                    gB_reduced(d) * closest_direction_hess[d];
-
-            hB.bottomRightCorner(pB->n_dofs(), pB->n_dofs()) +=
-                hB_reduced.bottomRightCorner(pB->n_dofs(), pB->n_dofs());
-            hB(core_indices, Eigen::seqN(pA->n_dofs(), pB->n_dofs())) -=
-                closest_direction_grad.transpose()
-                * hB_reduced.topRightCorner(dim, pB->n_dofs());
-            hB(Eigen::seqN(pA->n_dofs(), pB->n_dofs()), core_indices) -=
-                hB_reduced.bottomLeftCorner(pB->n_dofs(), dim)
-                * closest_direction_grad;
+        Eigen::Matrix<double, n_core_dofs, n_core_dofs> hA_core =
+            closest_direction_grad.transpose()
+            * hA_reduced.topLeftCorner(dim, dim) * closest_direction_grad;
+        Eigen::Matrix<double, n_core_dofs, n_core_dofs> hB_core =
+            closest_direction_grad.transpose()
+            * hB_reduced.topLeftCorner(dim, dim) * closest_direction_grad;
+        for (int d = 0; d < dim; d++) {
+            hA_core += gA_reduced(d) * closest_direction_hess[d];
+            hB_core -= gB_reduced(d) * closest_direction_hess[d];
         }
-        const double potential_a =
-            pA->potential(closest_direction, positions.head(pA->n_dofs()));
-        const double potential_b =
-            pB->potential(-closest_direction, positions.tail(pB->n_dofs()));
-
-        orient = potential_a * potential_b;
-        gOrient = gA * potential_b + gB * potential_a;
-        hOrient = (potential_a * hB + potential_b * hA)
-            + (gA * gB.transpose() + gB * gA.transpose());
+        hess(core_indices, core_indices) =
+            potential_b * hA_core + potential_a * hB_core;
     }
 
-    // merge barrier into orient
-    hOrient *= barrier;
-    hOrient(core_indices, core_indices) += hBarrier * orient;
-    hOrient(Eigen::all, core_indices) += gOrient * gBarrier.transpose();
-    hOrient(core_indices, Eigen::all) += gBarrier * gOrient.transpose();
-    gOrient *= barrier;
-    gOrient(core_indices) += gBarrier * orient;
-    orient *= barrier;
+    hess.topLeftCorner(nA, nA) +=
+        potential_b * hA_reduced.bottomRightCorner(nA, nA);
+    hess(core_indices, Eigen::seqN(0, nA)) += potential_b
+        * (closest_direction_grad.transpose()
+           * hA_reduced.topRightCorner(dim, nA));
+    hess(Eigen::seqN(0, nA), core_indices) += potential_b
+        * (hA_reduced.bottomLeftCorner(nA, dim) * closest_direction_grad);
+
+    hess.bottomRightCorner(nB, nB) +=
+        potential_a * hB_reduced.bottomRightCorner(nB, nB);
+    hess(core_indices, Eigen::seqN(nA, nB)) -= potential_a
+        * (closest_direction_grad.transpose()
+           * hB_reduced.topRightCorner(dim, nB));
+    hess(Eigen::seqN(nA, nB), core_indices) -= potential_a
+        * (hB_reduced.bottomLeftCorner(nB, dim) * closest_direction_grad);
+
+    hess.noalias() += gA * gB.transpose();
+    hess.noalias() += gB * gA.transpose();
 
-    // return hOrient
-    return (hOrient + hOrient.transpose()) / 2.;
+    // merge barrier into orient
+    hess *= barrier;
+    hess(core_indices, core_indices) += hBarrier * orient;
+    hess(Eigen::all, core_indices) += gOrient * gBarrier.transpose();
+    hess(core_indices, Eigen::all) += gBarrier * gOrient.transpose();
+
+    // symmetrize in place
+    for (int j = 1; j < hess.cols(); j++) {
+        for (int i = 0; i < j; i++) {
+            hess(i, j) = hess(j, i) = (hess(i, j) + hess(j, i)) / 2.;
+        }
+    }
 }
 
 // ---- distance ----
@@ -28,6 +28,11 @@ public:
     {
     }
 
+    // Collisions are stored by value in SmoothCollisions, so they must be
+    // movable.
+    SmoothCollision(SmoothCollision&&) = default;
+    SmoothCollision& operator=(SmoothCollision&&) = default;
+
     virtual ~SmoothCollision() = default;
 
     bool is_active() const { return is_active_; }
@@ -45,7 +50,7 @@ public:
 
     /// @brief Get the vertex IDs of the collision stencil.
     /// @return The vertex IDs of the collision stencil. Size is always 4, but elements i > num_vertices() are -1.
-    std::vector<index_t> vertex_ids() const { return vertex_ids_; }
+    const std::vector<index_t>& vertex_ids() const { return vertex_ids_; }
 
     /// @brief Get the vertex attributes of the collision stencil.
     /// @tparam T Type of the attributes
@@ -75,16 +80,38 @@ public:
     compute_distance(Eigen::ConstRef<Eigen::MatrixXd> vertices) const = 0;
 
     virtual double operator()(
-        Eigen::ConstRef<Vector<double, -1, element_size>> positions,
+        Eigen::ConstRef<Eigen::VectorXd> positions,
         const ParameterType& params) const = 0;
 
-    virtual Vector<double, -1, element_size> gradient(
-        Eigen::ConstRef<Vector<double, -1, element_size>> positions,
+    /// @brief Compute the gradient of the stencil's potential.
+    /// @param positions Stencil's vertex positions.
+    /// @param params Smooth contact parameters.
+    /// @return Gradient of size n_dofs().
+    virtual Eigen::VectorXd gradient(
+        Eigen::ConstRef<Eigen::VectorXd> positions,
         const ParameterType& params) const = 0;
 
-    virtual MatrixMax<double, element_size, element_size> hessian(
-        Eigen::ConstRef<Vector<double, -1, element_size>> positions,
-        const ParameterType& params) const = 0;
+    /// @brief Compute the Hessian of the stencil's potential.
+    /// @param positions Stencil's vertex positions.
+    /// @param params Smooth contact parameters.
+    /// @return Hessian of size n_dofs() x n_dofs().
+    Eigen::MatrixXd hessian(
+        Eigen::ConstRef<Eigen::VectorXd> positions,
+        const ParameterType& params) const
+    {
+        Eigen::MatrixXd hess;
+        hessian(positions, params, hess);
+        return hess;
+    }
+
+    /// @brief Compute the Hessian of the stencil's potential into caller-owned storage.
+    /// @param[in] positions Stencil's vertex positions.
+    /// @param[in] params Smooth contact parameters.
+    /// @param[out] hess Hessian of size n_dofs() x n_dofs(). Its storage is reused if it already has this size.
+    virtual void hessian(
+        Eigen::ConstRef<Eigen::VectorXd> positions,
+        const ParameterType& params,
+        Eigen::MatrixXd& hess) const = 0;
 
     bool operator==(const SmoothCollision& other) const
     {
@@ -120,7 +147,7 @@ protected:
 };
 
 template <typename PrimitiveA, typename PrimitiveB>
-class SmoothCollisionTemplate : public SmoothCollision {
+class SmoothCollisionTemplate final : public SmoothCollision {
 public:
     using Super = SmoothCollision;
     using DTYPE = typename PrimitiveDistType<PrimitiveA, PrimitiveB>::type;
@@ -140,6 +167,8 @@ public:
         const ParameterType& param,
         const double& dhat,
         const Eigen::MatrixXd& V);
+    SmoothCollisionTemplate(SmoothCollisionTemplate&&) = default;
+    SmoothCollisionTemplate& operator=(SmoothCollisionTemplate&&) = default;
     virtual ~SmoothCollisionTemplate() = default;
 
     std::string name() const override;
@@ -164,16 +193,19 @@ public:
     // ---- non distance type potential ----
 
     double operator()(
-        Eigen::ConstRef<Vector<double, -1, element_size>> positions,
+        Eigen::ConstRef<Eigen::VectorXd> positions,
         const ParameterType& params) const override;
 
-    Vector<double, -1, element_size> gradient(
-        Eigen::ConstRef<Vector<double, -1, element_size>> positions,
+    Eigen::VectorXd gradient(
+        Eigen::ConstRef<Eigen::VectorXd> positions,
         const ParameterType& params) const override;
 
-    MatrixMax<double, element_size, element_size> hessian(
-        Eigen::ConstRef<Vector<double, -1, element_size>> positions,
-        const ParameterType& params) const override;
+    using SmoothCollision::hessian;
+
+    void hessian(
+        Eigen::ConstRef<Eigen::VectorXd> positions,
+        const ParameterType& params,
+        Eigen::MatrixXd& hess) const override;
 
     // ---- distance ----
 
@@ -2,8 +2,38 @@
 
 #include <ipc/utils/AutodiffTypes.hpp>
 
+#include <type_traits>
+
 namespace ipc {
 
+namespace {
+    /// @brief Positions of a point and its neighbors, one per row.
+    using PositionMatrix = Eigen::Matrix<
+        double, -1, 3, Eigen::ColMajor, n_vert_neighbors_3d, 3>;
+    using PositionMap =
+        Eigen::Map<const Eigen::Matrix<double, -1, 3, Eigen::RowMajor>>;
+
+    /// @brief Call f with the number of neighbors as a compile-time constant
+    ///        for the common valences of a triangle mesh, or with -1 otherwise.
+    template <typename F> auto dispatch_n_neighbors(const int n, F&& f)
+    {
+        switch (n) {
+        case 4:
+            return f(std::integral_constant<int, 4>());
+        case 5:
+            return f(std::integral_constant<int, 5>());
+        case 6:
+            return f(std::integral_constant<int, 6>());
+        case 7:
+            return f(std::integral_constant<int, 7>());
+        case 8:
+            return f(std::integral_constant<int, 8>());
+        default:
+            return f(std::integral_constant<int, -1>());
+        }
+    }
+} // namespace
+
 Point3::Point3(
     const long& id,
     const CollisionMesh& mesh,
@@ -90,10 +120,11 @@ Vector<double, -1, Point3::max_size + Point3::dim> Point3::grad(
     return smooth_point3_term<T, -1>(X.bottomRows(X.rows() - 1), X.row(0))
         .getGradient();
 #else
-    const Eigen::Matrix<double, -1, dim> X =
-        slice_positions<double, -1, dim>(x);
-    const auto [val, grad] = smooth_point3_term_gradient(d, X, _param);
-    return grad;
+    const PositionMatrix X = PositionMap(x.data(), x.size() / dim, dim);
+    return dispatch_n_neighbors(
+        n_neighbors, [&](auto n) -> Vector<double, -1, max_size + dim> {
+            return std::get<1>(term_gradient<decltype(n)::value>(d, X, _param));
+        });
 #endif
 }
 
@@ -113,26 +144,88 @@ Point3::hessian(
     return smooth_point3_term<T, -1>(X.bottomRows(X.rows() - 1), X.row(0))
         .getHessian();
 #else
-    const auto X = slice_positions<double, -1, dim>(x);
-    const auto [val, grad, hess] = smooth_point3_term_hessian(d, X, _param);
-    return hess;
+    const PositionMatrix X = PositionMap(x.data(), x.size() / dim, dim);
+    return dispatch_n_neighbors(
+        n_neighbors,
+        [&](auto n) -> MatrixMax<double, max_size + dim, max_size + dim> {
+            return std::get<2>(term_hessian<decltype(n)::value>(d, X, _param));
+        });
 #endif
 }
 
+GradType<-1> Point3::smooth_point3_term_gradient(
+    const Eigen::Ref<const RowVector3<double>>& direc,
+    const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& X,
+    const ParameterType& param) const
+{
+    return dispatch_n_neighbors(n_neighbors, [&](auto n) -> GradType<-1> {
+        return term_gradient<decltype(n)::value>(direc, X, param);
+    });
+}
+
+HessianType<-1> Point3::smooth_point3_term_hessian(
+    const Eigen::Ref<const RowVector3<double>>& direc,
+    const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& X,
+    const ParameterType& param) const
+{
+    return dispatch_n_neighbors(n_neighbors, [&](auto n) -> HessianType<-1> {
+        return term_hessian<decltype(n)::value>(direc, X, param);
+    });
+}
+
 GradType<-1> Point3::smooth_point3_term_tangent_gradient(
     const Eigen::Ref<const RowVector3<double>>& direc,
     const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& tangents,
     const double& alpha,
     const double& beta) const
+{
+    return tangent_gradient<-1>(direc, tangents, alpha, beta);
+}
+
+HessianType<-1> Point3::smooth_point3_term_tangent_hessian(
+    const Eigen::Ref<const RowVector3<double>>& direc,
+    const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& tangents,
+    const double& alpha,
+    const double& beta) const
+{
+    return tangent_hessian<-1>(direc, tangents, alpha, beta);
+}
+
+GradType<-1> Point3::smooth_point3_term_normal_gradient(
+    const Eigen::Ref<const RowVector3<double>>& direc,
+    const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& tangents,
+    const double& alpha,
+    const double& beta) const
+{
+    return normal_gradient<-1>(direc, tangents, alpha, beta);
+}
+
+HessianType<-1> Point3::smooth_point3_term_normal_hessian(
+    const Eigen::Ref<const RowVector3<double>>& direc,
+    const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& tangents,
+    const double& alpha,
+    const double& beta) const
+{
+    return normal_hessian<-1>(direc, tangents, alpha, beta);
+}
+
+template <int N>
+auto Point3::tangent_gradient(
+    const Eigen::Ref<const RowVector3<double>>& direc,
+    const Tangents<N>& tangents,
+    const double& alpha,
+    const double& beta) const -> GradType<n_tangent_dofs<N>>
 {
     const int nn = tangents.rows();
-    Eigen::VectorXd values = Eigen::VectorXd::Ones(nn, 1);
-    Eigen::VectorXd acc_val_1 = Eigen::VectorXd::Ones(nn, 1);
-    std::vector<Vector6d> tmp_grad(nn);
+    Vector<double, N> values = Vector<double, N>::Ones(nn);
+    Vector<double, N> acc_val_1 = Vector<double, N>::Ones(nn);
+    Eigen::Matrix<double, 6, N> tmp_grad(6, nn);
     for (int a = 0; a < nn; a++) {
         if (_otypes.tangent_type(a) == HEAVISIDE_TYPE::VARIANT) {
-            std::tie(values(a), tmp_grad[a]) = opposite_direction_penalty_grad(
+            const auto [y, dy] = opposite_direction_penalty_grad(
                 tangents.row(a), direc, alpha, beta);
+            values(a) = y;
+            tmp_grad.col(a) = dy;
             for (int b = 0; b < nn; b++)
                 if (_otypes.tangent_type(b) == HEAVISIDE_TYPE::VARIANT
                     && b != a)
@@ -140,35 +233,45 @@ GradType<-1> Point3::smooth_point3_term_tangent_gradient(
         }
     }
 
-    Eigen::VectorXd tangent_grad = Eigen::VectorXd::Zero((nn + 1) * 3);
+    Vector<double, n_tangent_dofs<N>> tangent_grad =
+        Vector<double, n_tangent_dofs<N>>::Zero((nn + 1) * 3);
     for (int a = 0; a < nn; a++) {
         if (_otypes.tangent_type(a) == HEAVISIDE_TYPE::VARIANT) {
             const int id = (a + 1) * 3;
-            tangent_grad.segment<3>(id) = tmp_grad[a].head<3>() * acc_val_1(a);
-            tangent_grad.segment<3>(0) += tmp_grad[a].tail<3>() * acc_val_1(a);
+            tangent_grad.template segment<3>(id) =
+                tmp_grad.col(a).template head<3>() * acc_val_1(a);
+            tangent_grad.template segment<3>(0) +=
+                tmp_grad.col(a).template tail<3>() * acc_val_1(a);
         }
     }
 
     return std::make_tuple(values.prod(), tangent_grad);
 }
 
-HessianType<-1> Point3::smooth_point3_term_tangent_hessian(
+template <int N>
+auto Point3::tangent_hessian(
     const Eigen::Ref<const RowVector3<double>>& direc,
-    const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& tangents,
+    const Tangents<N>& tangents,
     const double& alpha,
-    const double& beta) const
+    const double& beta) const -> HessianType<n_tangent_dofs<N>>
 {
+    constexpr int n_dofs = n_tangent_dofs<N>;
+
     const int nn = tangents.rows();
-    Eigen::VectorXd values = Eigen::VectorXd::Ones(nn, 1);
-    Eigen::VectorXd acc_val_1 = Eigen::VectorXd::Ones(nn, 1);
-    Eigen::MatrixXd acc_val_2 = Eigen::MatrixXd::Ones(nn, nn);
-    std::vector<Vector6d> tmp_grad(nn);
-    std::vector<Matrix6d> tmp_hess(nn);
+    Vector<double, N> values = Vector<double, N>::Ones(nn);
+    Vector<double, N> acc_val_1 = Vector<double, N>::Ones(nn);
+    Eigen::Matrix<double, N, N> acc_val_2 =
+        Eigen::Matrix<double, N, N>::Ones(nn, nn);
+    Eigen::Matrix<double, 6, N> tmp_grad(6, nn);
+    // The 6x6 Hessians of the penalties stacked side by side
+    Eigen::Matrix<double, 6, N < 0 ? -1 : 6 * N> tmp_hess(6, 6 * nn);
     for (int a = 0; a < nn; a++) {
         if (_otypes.tangent_type(a) == HEAVISIDE_TYPE::VARIANT) {
-            std::tie(values(a), tmp_grad[a], tmp_hess[a]) =
-                opposite_direction_penalty_hess(
-                    tangents.row(a), direc, alpha, beta);
+            const auto [y, dy, ddy] = opposite_direction_penalty_hess(
+                tangents.row(a), direc, alpha, beta);
+            values(a) = y;
+            tmp_grad.col(a) = dy;
+            tmp_hess.template middleCols<6>(6 * a) = ddy;
             for (int b = 0; b < nn; b++) {
                 if (b != a) {
                     acc_val_1(b) *= values(a);
@@ -181,58 +284,70 @@ HessianType<-1> Point3::smooth_point3_term_tangent_hessian(
         }
     }
 
-    Eigen::VectorXd tangent_grad = Eigen::VectorXd::Zero((nn + 1) * 3);
-    Eigen::MatrixXd tangent_hess =
-        Eigen::MatrixXd::Zero(tangent_grad.size(), tangent_grad.size());
+    Vector<double, n_dofs> tangent_grad =
+        Vector<double, n_dofs>::Zero((nn + 1) * 3);
+    Eigen::Matrix<double, n_dofs, n_dofs> tangent_hess =
+        Eigen::Matrix<double, n_dofs, n_dofs>::Zero(
+            tangent_grad.size(), tangent_grad.size());
     Eigen::Vector3d tmp;
     for (int a = 0; a < nn; a++) {
         if (_otypes.tangent_type(a) == HEAVISIDE_TYPE::VARIANT) {
             const int id = (a + 1) * 3;
-            tangent_grad.segment<3>(id) = tmp_grad[a].head<3>() * acc_val_1(a);
-            tangent_grad.segment<3>(0) += tmp_grad[a].tail<3>() * acc_val_1(a);
+            const auto grad_a = tmp_grad.col(a);
+            const auto hess_a = tmp_hess.template middleCols<6>(6 * a);
+
+            tangent_grad.template segment<3>(id) =
+                grad_a.template head<3>() * acc_val_1(a);
+            tangent_grad.template segment<3>(0) +=
+                grad_a.template tail<3>() * acc_val_1(a);
 
             tmp.setZero();
             for (int b = 0; b < nn; b++)
                 if (_otypes.tangent_type(b) == HEAVISIDE_TYPE::VARIANT
                     && b != a) {
-                    tmp += tmp_grad[b].tail<3>() * acc_val_2(a, b);
-                    tangent_hess.block<3, 3>(id, (b + 1) * 3) =
-                        tmp_grad[a].head<3>()
-                        * tmp_grad[b].head<3>().transpose() * acc_val_2(a, b);
-                    tangent_hess.block<3, 3>((b + 1) * 3, id) =
-                        tmp_grad[b].head<3>()
-                        * tmp_grad[a].head<3>().transpose() * acc_val_2(a, b);
+                    const auto grad_b = tmp_grad.col(b);
+                    tmp += grad_b.template tail<3>() * acc_val_2(a, b);
+                    tangent_hess.template block<3, 3>(id, (b + 1) * 3) =
+                        grad_a.template head<3>()
+                        * grad_b.template head<3>().transpose()
+                        * acc_val_2(a, b);
+                    tangent_hess.template block<3, 3>((b + 1) * 3, id) =
+                        grad_b.template head<3>()
+                        * grad_a.template head<3>().transpose()
+                        * acc_val_2(a, b);
                 }
 
-            tangent_hess.block<3, 3>(id, id) =
-                tmp_hess[a].block<3, 3>(0, 0) * acc_val_1(a);
-            tangent_hess.block<3, 3>(0, 0) +=
-                tmp_hess[a].block<3, 3>(3, 3) * acc_val_1(a);
-            tangent_hess.block<3, 3>(0, 0) +=
-                tmp_grad[a].tail<3>() * tmp.transpose();
-
-            tangent_hess.block<3, 3>(id, 0) +=
-                tmp_hess[a].block<3, 3>(0, 3) * acc_val_1(a);
-            tangent_hess.block<3, 3>(0, id) +=
-                tmp_hess[a].block<3, 3>(3, 0) * acc_val_1(a);
-            tangent_hess.block<3, 3>(id, 0) +=
-                tmp_grad[a].head<3>() * tmp.transpose();
-            tangent_hess.block<3, 3>(0, id) +=
-                tmp * tmp_grad[a].head<3>().transpose();
+            tangent_hess.template block<3, 3>(id, id) =
+                hess_a.template block<3, 3>(0, 0) * acc_val_1(a);
+            tangent_hess.template block<3, 3>(0, 0) +=
+                hess_a.template block<3, 3>(3, 3) * acc_val_1(a);
+            tangent_hess.template block<3, 3>(0, 0) +=
+                grad_a.template tail<3>() * tmp.transpose();
+
+            tangent_hess.template block<3, 3>(id, 0) +=
+                hess_a.template block<3, 3>(0, 3) * acc_val_1(a);
+            tangent_hess.template block<3, 3>(0, id) +=
+                hess_a.template block<3, 3>(3, 0) * acc_val_1(a);
+            tangent_hess.template block<3, 3>(id, 0) +=
+                grad_a.template head<3>() * tmp.transpose();
+            tangent_hess.template block<3, 3>(0, id) +=
+                tmp * grad_a.template head<3>().transpose();
         }
     }
 
     return std::make_tuple(values.prod(), tangent_grad, tangent_hess);
 }
 
-GradType<-1> Point3::smooth_point3_term_normal_gradient(
+template <int N>
+auto Point3::normal_gradient(
     const Eigen::Ref<const RowVector3<double>>& direc,
-    const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& tangents,
+    const Tangents<N>& tangents,
     const double& alpha,
-    const double& beta) const
+    const double& beta) const -> GradType<n_tangent_dofs<N>>
 {
-    Eigen::VectorXd grad =
-        Eigen::VectorXd::Zero(tangents.size() + direc.size());
+    Vector<double, n_tangent_dofs<N>> grad =
+        Vector<double, n_tangent_dofs<N>>::Zero(
+            tangents.size() + direc.size());
     if (!orientable || _otypes.normal_type(0) == HEAVISIDE_TYPE::ONE)
         return std::make_tuple(1., grad);
 
@@ -251,9 +366,9 @@ GradType<-1> Point3::smooth_point3_term_normal_gradient(
 
             normal_term += y;
 
-            grad.segment<3>(id1) += dy.head<3>();
-            grad.segment<3>(id2) += dy.segment<3>(3);
-            grad.head<3>() -= dy.tail<3>();
+            grad.template segment<3>(id1) += dy.head<3>();
+            grad.template segment<3>(id2) += dy.segment<3>(3);
+            grad.template head<3>() -= dy.tail<3>();
         }
     }
 
@@ -290,17 +405,23 @@ GradType<-1> Point3::smooth_point3_term_normal_gradient(
     const double grad_val =
         Math<double>::smooth_heaviside_grad(normal_term - 1, 1., 0);
 
-    return std::make_tuple(val, grad * grad_val);
+    grad *= grad_val;
+    return std::make_tuple(val, grad);
 }
 
-HessianType<-1> Point3::smooth_point3_term_normal_hessian(
+template <int N>
+auto Point3::normal_hessian(
     const Eigen::Ref<const RowVector3<double>>& direc,
-    const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& tangents,
+    const Tangents<N>& tangents,
     const double& alpha,
-    const double& beta) const
+    const double& beta) const -> HessianType<n_tangent_dofs<N>>
 {
-    Eigen::VectorXd grad = Eigen::VectorXd::Zero((tangents.rows() + 1) * 3);
-    Eigen::MatrixXd hess = Eigen::MatrixXd::Zero(grad.size(), grad.size());
+    constexpr int n_dofs = n_tangent_dofs<N>;
+
+    Vector<double, n_dofs> grad =
+        Vector<double, n_dofs>::Zero((tangents.rows() + 1) * 3);
+    Eigen::Matrix<double, n_dofs, n_dofs> hess =
+        Eigen::Matrix<double, n_dofs, n_dofs>::Zero(grad.size(), grad.size());
     if (!orientable || _otypes.normal_type(0) == HEAVISIDE_TYPE::ONE)
         return std::make_tuple(1., grad, hess);
 
@@ -341,24 +462,29 @@ HessianType<-1> Point3::smooth_point3_term_normal_hessian(
     // TODO: replace with efficient code
     double normal_term = 0;
     {
-        using T = ADHessian<-1>;
-        Eigen::VectorXd tmp(direc.size() + tangents.size());
-        tmp.head<3>() = direc;
-        for (int i = 0; i < tangents.rows(); i++)
-            tmp.segment<3>(3 * i + 3) = tangents.row(i);
-
-        DiffScalarBase::setVariableCount(tmp.size());
-        const Eigen::Matrix<T, -1, dim> X = slice_positions<T, -1, dim>(tmp);
-
+        using T = ADHessian<n_dofs>;
+        DiffScalarBase::setVariableCount(grad.size());
+
+        // The variables are [direc, tangents]. Only the rows used by a face
+        // are created, as a matrix of all of them can be too big for the
+        // stack when the derivatives are fixed-size.
+        const auto variables = [&](const int i) {
+            const RowVector3<double> x =
+                i == 0 ? RowVector3<double>(direc) : tangents.row(i - 1);
+            return RowVector3<T>(
+                T(3 * i, x(0)), T(3 * i + 1, x(1)), T(3 * i + 2, x(2)));
+        };
+
+        const RowVector3<T> dn = variables(0);
         T normal_term_ad(0.);
         for (int a = 0; a < faces.rows(); a++) {
             if (_otypes.normal_type(a) == HEAVISIDE_TYPE::VARIANT)
                 normal_term_ad =
                     normal_term_ad
                     + Math<T>::smooth_heaviside(
-                        -X.row(0).dot(X.row(faces(a, 1))
-                                          .cross(X.row(faces(a, 2)))
-                                          .normalized()),
+                        -dn.dot(variables(faces(a, 1))
+                                    .cross(variables(faces(a, 2)))
+                                    .normalized()),
                         _param.alpha_n, _param.beta_n);
         }
 
@@ -373,9 +499,9 @@ HessianType<-1> Point3::smooth_point3_term_normal_hessian(
     const double hess_val =
         Math<double>::smooth_heaviside_hess(normal_term - 1, 1., 0);
 
-    return std::make_tuple(
-        val, grad * grad_val,
-        grad * hess_val * grad.transpose() + grad_val * hess);
+    hess = grad * hess_val * grad.transpose() + grad_val * hess;
+    grad *= grad_val;
+    return std::make_tuple(val, grad, hess);
 }
 
 bool Point3::smooth_point3_term_type(
@@ -416,34 +542,35 @@ bool Point3::smooth_point3_term_type(
     return normal_term > 0;
 }
 
-GradType<-1> Point3::smooth_point3_term_gradient(
+template <int N>
+auto Point3::term_gradient(
     const Eigen::Ref<const RowVector3<double>>& direc,
     const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& X,
-    const ParameterType& param) const
+    const ParameterType& param) const -> GradType<n_term_dofs<N>>
 {
+    assert(N < 0 || N == n_neighbors);
     const int n_dofs = (X.rows() + 1) * 3;
     const int n_neighbor_dofs = n_neighbors * 3;
 
-    const Eigen::Matrix<double, -1, 3, Eigen::RowMajor> tangents =
+    const Tangents<N> tangents =
         X.bottomRows(n_neighbors).rowwise() - X.row(0);
-    const Eigen::VectorXd tangents_vec =
-        Eigen::Map<const Eigen::VectorXd>(tangents.data(), tangents.size());
+    const Eigen::Map<const Vector<double, N < 0 ? -1 : 3 * N>> tangents_vec(
+        tangents.data(), tangents.size());
 
     auto [dn, dn_grad] = normalize_vector_grad(direc);
     dn *= -1;
     dn_grad *= -1;
 
     const auto [tangent_term, tangent_grad] =
-        smooth_point3_term_tangent_gradient(
-            dn, tangents, param.alpha_t, param.beta_t);
+        tangent_gradient<N>(dn, tangents, param.alpha_t, param.beta_t);
 
-    auto [normal_term, normal_grad] = smooth_point3_term_normal_gradient(
-        dn, tangents, param.alpha_n, param.beta_n);
+    auto [normal_term, normal_grad] =
+        normal_gradient<N>(dn, tangents, param.alpha_n, param.beta_n);
 
     double val = tangent_term * normal_term;
 
     // gradient wrt. [dn, tangents]
-    Eigen::VectorXd grad_tmp =
+    Vector<double, n_tangent_dofs<N>> grad_tmp =
         tangent_grad * normal_term + normal_grad * tangent_term;
 
     const double weight = tangents.squaredNorm() / 3.;
@@ -453,27 +580,29 @@ GradType<-1> Point3::smooth_point3_term_gradient(
     val *= weight;
 
     // gradient wrt. [direc, v, neighbors]
-    Eigen::VectorXd grad(n_dofs);
-    grad.head<3>() = dn_grad * grad_tmp.head<3>();
+    Vector<double, n_term_dofs<N>> grad(n_dofs);
+    grad.template head<3>() = dn_grad * grad_tmp.template head<3>();
     for (int d = 0; d < 3; d++)
         grad(d + 3) = -grad_tmp(Eigen::seqN(d + 3, n_neighbors, 3)).sum();
     grad.tail(n_neighbor_dofs) = grad_tmp.tail(n_neighbor_dofs);
 
-    return std::tuple(val, grad);
+    return std::make_tuple(val, grad);
 }
 
-HessianType<-1> Point3::smooth_point3_term_hessian(
+template <int N>
+auto Point3::term_hessian(
     const Eigen::Ref<const RowVector3<double>>& direc,
     const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& X,
-    const ParameterType& param) const
+    const ParameterType& param) const -> HessianType<n_term_dofs<N>>
 {
+    assert(N < 0 || N == n_neighbors);
     const int n_dofs = (X.rows() + 1) * 3;
     const int n_neighbor_dofs = n_neighbors * 3;
 
-    const Eigen::Matrix<double, -1, 3, Eigen::RowMajor> tangents =
+    const Tangents<N> tangents =
         X.bottomRows(n_neighbors).rowwise() - X.row(0);
-    const Eigen::VectorXd tangents_vec =
-        Eigen::Map<const Eigen::VectorXd>(tangents.data(), tangents.size());
+    const Eigen::Map<const Vector<double, N < 0 ? -1 : 3 * N>> tangents_vec(
+        tangents.data(), tangents.size());
 
     auto [dn, dn_grad, dn_hess] = normalize_vector_hess(direc);
     dn *= -1;
@@ -482,22 +611,21 @@ HessianType<-1> Point3::smooth_point3_term_hessian(
         mat *= -1;
 
     const auto [tangent_term, tangent_grad, tangent_hess] =
-        smooth_point3_term_tangent_hessian(
-            dn, tangents, param.alpha_t, param.beta_t);
+        tangent_hessian<N>(dn, tangents, param.alpha_t, param.beta_t);
 
     auto [normal_term, normal_grad, normal_hess] =
-        smooth_point3_term_normal_hessian(
-            dn, tangents, param.alpha_n, param.beta_n);
+        normal_hessian<N>(dn, tangents, param.alpha_n, param.beta_n);
 
     double val = tangent_term * normal_term;
 
     // gradient wrt. [dn, tangents]
-    Eigen::VectorXd grad_tmp =
+    Vector<double, n_tangent_dofs<N>> grad_tmp =
         tangent_grad * normal_term + normal_grad * tangent_term;
 
     // hessian wrt. [dn, tangents]
-    Eigen::MatrixXd hess_tmp = tangent_hess * normal_term
-        + normal_hess * tangent_term + tangent_grad * normal_grad.transpose()
+    Eigen::Matrix<double, n_tangent_dofs<N>, n_tangent_dofs<N>> hess_tmp =
+        tangent_hess * normal_term + normal_hess * tangent_term
+        + tangent_grad * normal_grad.transpose()
         + normal_grad * tangent_grad.transpose();
 
     const double weight = tangents.squaredNorm() / 3.;
@@ -516,18 +644,18 @@ HessianType<-1> Point3::smooth_point3_term_hessian(
     val *= weight;
 
     // gradient wrt. [direc, v, neighbors]
-    Eigen::VectorXd grad(n_dofs);
-    grad.head<3>() = dn_grad * grad_tmp.head<3>();
+    Vector<double, n_term_dofs<N>> grad(n_dofs);
+    grad.template head<3>() = dn_grad * grad_tmp.template head<3>();
     for (int d = 0; d < 3; d++)
         grad(d + 3) = -grad_tmp(Eigen::seqN(d + 3, n_neighbors, 3)).sum();
     grad.tail(n_neighbor_dofs) = grad_tmp.tail(n_neighbor_dofs);
 
     // hessian wrt. [direc, v, neighbors]
-    Eigen::MatrixXd hess;
+    Eigen::Matrix<double, n_term_dofs<N>, n_term_dofs<N>> hess;
     hess.setZero(n_dofs, n_dofs);
 
-    hess.topLeftCorner<3, 3>() =
-        dn_grad * hess_tmp.topLeftCorner<3, 3>() * dn_grad.transpose()
+    hess.template topLeftCorner<3, 3>() = dn_grad
+            * hess_tmp.template topLeftCorner<3, 3>() * dn_grad.transpose()
         + dn_hess[0] * grad_tmp(0) + dn_hess[1] * grad_tmp(1)
         + dn_hess[2] * grad_tmp(2);
     hess.bottomRightCorner(n_neighbor_dofs, n_neighbor_dofs) =
@@ -539,16 +667,21 @@ HessianType<-1> Point3::smooth_point3_term_hessian(
         hess_tmp.bottomLeftCorner(n_neighbor_dofs, 3) * dn_grad;
 
     for (int k = 0, id = 3; k < n_neighbors; k++, id += 3) {
-        hess.block<3, 3>(0, 3) -= dn_grad * hess_tmp.block<3, 3>(0, id);
-        hess.block<3, 3>(3, 0) -= hess_tmp.block<3, 3>(id, 0) * dn_grad;
+        hess.template block<3, 3>(0, 3) -=
+            dn_grad * hess_tmp.template block<3, 3>(0, id);
+        hess.template block<3, 3>(3, 0) -=
+            hess_tmp.template block<3, 3>(id, 0) * dn_grad;
         for (int l = 0, jd = 3; l < n_neighbors; l++, jd += 3) {
-            hess.block<3, 3>(3, 3) += hess_tmp.block<3, 3>(id, jd);
-            hess.block<3, 3>(3, 3 + id) -= hess_tmp.block<3, 3>(jd, id);
-            hess.block<3, 3>(3 + id, 3) -= hess_tmp.block<3, 3>(id, jd);
+            hess.template block<3, 3>(3, 3) +=
+                hess_tmp.template block<3, 3>(id, jd);
+            hess.template block<3, 3>(3, 3 + id) -=
+                hess_tmp.template block<3, 3>(jd, id);
+            hess.template block<3, 3>(3 + id, 3) -=
+                hess_tmp.template block<3, 3>(id, jd);
         }
     }
 
-    return std::tuple(val, grad, hess);
+    return std::make_tuple(val, grad, hess);
 }
 
 template <typename scalar, int n_verts>
@@ -590,4 +723,27 @@ scalar Point3::smooth_point3_term(
 
     return weight * normal_term * tangent_term;
 }
+
+// Explicit instantiations of the term derivatives for the dispatched valences.
+
+#define IPC_INSTANTIATE_POINT3_TERM(N)                                         \
+    template GradType<Point3::n_term_dofs<N>>                                  \
+    Point3::term_gradient<N>(                                                  \
+        const Eigen::Ref<const RowVector3<double>>&,                           \
+        const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>&,                 \
+        const ParameterType&) const;                                           \
+    template HessianType<Point3::n_term_dofs<N>>                               \
+    Point3::term_hessian<N>(                                                   \
+        const Eigen::Ref<const RowVector3<double>>&,                           \
+        const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>&,                 \
+        const ParameterType&) const;
+
+IPC_INSTANTIATE_POINT3_TERM(-1)
+IPC_INSTANTIATE_POINT3_TERM(4)
+IPC_INSTANTIATE_POINT3_TERM(5)
+IPC_INSTANTIATE_POINT3_TERM(6)
+IPC_INSTANTIATE_POINT3_TERM(7)
+IPC_INSTANTIATE_POINT3_TERM(8)
+
+#undef IPC_INSTANTIATE_POINT3_TERM
 } // namespace ipc
@@ -86,7 +86,73 @@ public:
         const double& alpha,
         const double& beta) const;
 
+    /// @brief Size of the derivatives wrt. [direc, v, neighbors] of a point
+    ///        with N neighbors (-1 if the number is only known at runtime).
+    template <int N>
+    static constexpr int n_term_dofs = N < 0 ? -1 : 3 * (N + 2);
+
+    /// @brief Gradient of the term for a one-ring of N neighbors.
+    ///
+    /// smooth_point3_term_gradient() calls this with N fixed at compile time
+    /// for 4 to 8 neighbors, so every vector and matrix is fixed-size and no
+    /// heap allocation happens. N = -1 is the fallback for any other valence.
+    ///
+    /// @tparam N Number of neighbors of the point, or -1.
+    template <int N>
+    GradType<n_term_dofs<N>> term_gradient(
+        const Eigen::Ref<const RowVector3<double>>& direc,
+        const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& X,
+        const ParameterType& param) const;
+
+    /// @brief Hessian of the term for a one-ring of N neighbors.
+    /// @tparam N Number of neighbors of the point, or -1.
+    template <int N>
+    HessianType<n_term_dofs<N>> term_hessian(
+        const Eigen::Ref<const RowVector3<double>>& direc,
+        const Eigen::Ref<const Eigen::Matrix<double, -1, 3>>& X,
+        const ParameterType& param) const;
+
 private:
+    /// @brief Size of the derivatives wrt. [dn, tangents] of a point with N
+    ///        neighbors (-1 if the number is only known at runtime).
+    template <int N>
+    static constexpr int n_tangent_dofs = N < 0 ? -1 : 3 * (N + 1);
+
+    /// @brief Edge vectors from the point to its N neighbors.
+    template <int N>
+    using Tangents = Eigen::Matrix<double, N, 3, Eigen::RowMajor>;
+
+    // Implementations of the tangent and normal derivatives for a one-ring of
+    // N neighbors (see term_gradient).
+
+    template <int N>
+    GradType<n_tangent_dofs<N>> tangent_gradient(
+        const Eigen::Ref<const RowVector3<double>>& direc,
+        const Tangents<N>& tangents,
+        const double& alpha,
+        const double& beta) const;
+
+    template <int N>
+    HessianType<n_tangent_dofs<N>> tangent_hessian(
+        const Eigen::Ref<const RowVector3<double>>& direc,
+        const Tangents<N>& tangents,
+        const double& alpha,
+        const double& beta) const;
+
+    template <int N>
+    GradType<n_tangent_dofs<N>> normal_gradient(
+        const Eigen::Ref<const RowVector3<double>>& direc,
+        const Tangents<N>& tangents,
+        const double& alpha,
+        const double& beta) const;
+
+    template <int N>
+    HessianType<n_tangent_dofs<N>> normal_hessian(
+        const Eigen::Ref<const RowVector3<double>>& direc,
+        const Tangents<N>& tangents,
+        const double& alpha,
+        const double& beta) const;
+
     int n_neighbors;
     ORIENTATION_TYPES _otypes;
 
@@ -18,6 +18,28 @@
 
 namespace ipc {
 
+namespace {
+    /// @brief Find the i-th collision in the concatenation of the pools.
+    /// @return A pointer to the collision, or nullptr if i is out of range.
+    template <typename Collision, typename Pools>
+    Collision* find_collision(Pools& pools, size_t i)
+    {
+        Collision* collision = nullptr;
+        const auto find = [&](auto& pool) {
+            if (collision != nullptr) {
+                return;
+            }
+            if (i < pool.size()) {
+                collision = &pool[i];
+            } else {
+                i -= pool.size();
+            }
+        };
+        std::apply([&](auto&... pool) { (find(pool), ...); }, pools);
+        return collision;
+    }
+} // namespace
+
 void SmoothCollisions::compute_adaptive_dhat(
     const CollisionMesh& mesh,
     Eigen::ConstRef<Eigen::MatrixXd> vertices, // set to zero for rest pose
@@ -42,56 +64,116 @@ void SmoothCollisions::compute_adaptive_dhat(
     else
         face_adaptive_dhat.resize(0);
 
+    lower_adaptive_dhat(*this, vertices, param);
+    propagate_adaptive_dhat(mesh);
+}
+
+void SmoothCollisions::update_adaptive_dhat(
+    const Candidates& new_candidates,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices,
+    const ParameterType param)
+{
+    assert(vertices.rows() == mesh.num_vertices());
+
+    // Primitives added since the last update start at dhat.
+    const auto grow = [&](Eigen::VectorXd& adaptive_dhat, const int n) {
+        const int n_old = std::min<int>(adaptive_dhat.size(), n);
+        adaptive_dhat.conservativeResize(n);
+        adaptive_dhat.tail(n - n_old).setConstant(param.dhat);
+    };
+    grow(vert_adaptive_dhat, mesh.num_vertices());
+    grow(edge_adaptive_dhat, mesh.num_edges());
+    grow(face_adaptive_dhat, mesh.dim() == 3 ? mesh.num_faces() : 0);
+
+    SmoothCollisions new_collisions;
+    new_collisions.build(
+        new_candidates, mesh, vertices, param,
+        false /*disable adaptive dhat to compute true pairs*/);
+
+    lower_adaptive_dhat(new_collisions, vertices, param);
+    propagate_adaptive_dhat(mesh);
+}
+
+void SmoothCollisions::lower_adaptive_dhat(
+    const SmoothCollisions& new_collisions,
+    Eigen::ConstRef<Eigen::MatrixXd> vertices,
+    const ParameterType& param)
+{
+    // The distances are the expensive part, so compute them in parallel and
+    // only scatter the minimums serially.
+    std::vector<double> distances(new_collisions.size());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, new_collisions.size()),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                distances[i] = param.get_adaptive_dhat_ratio()
+                    * sqrt(new_collisions[i].compute_distance(vertices));
+            }
+        });
+
     auto assign_min = [](double& a, const double& b) -> void {
         a = std::min(a, b);
     };
 
-    for (const auto& cc : collisions) {
-        const double dist = param.get_adaptive_dhat_ratio()
-            * sqrt(cc->compute_distance(vertices));
-        switch (cc->type()) {
+    for (size_t i = 0; i < new_collisions.size(); i++) {
+        const SmoothCollision& cc = new_collisions[i];
+        const double dist = distances[i];
+        switch (cc.type()) {
         case CollisionType::EdgeEdge:
-            assign_min(edge_adaptive_dhat((*cc)[0]), dist);
-            assign_min(edge_adaptive_dhat((*cc)[1]), dist);
+            assign_min(edge_adaptive_dhat(cc[0]), dist);
+            assign_min(edge_adaptive_dhat(cc[1]), dist);
             break;
         case CollisionType::EdgeVertex:
-            assign_min(edge_adaptive_dhat((*cc)[0]), dist);
-            assign_min(vert_adaptive_dhat((*cc)[1]), dist);
+            assign_min(edge_adaptive_dhat(cc[0]), dist);
+            assign_min(vert_adaptive_dhat(cc[1]), dist);
             break;
         case CollisionType::FaceVertex:
-            assign_min(face_adaptive_dhat((*cc)[0]), dist);
-            assign_min(vert_adaptive_dhat((*cc)[1]), dist);
+            assign_min(face_adaptive_dhat(cc[0]), dist);
+            assign_min(vert_adaptive_dhat(cc[1]), dist);
             break;
         case CollisionType::VertexVertex:
-            assign_min(vert_adaptive_dhat((*cc)[0]), dist);
-            assign_min(vert_adaptive_dhat((*cc)[1]), dist);
+            assign_min(vert_adaptive_dhat(cc[0]), dist);
+            assign_min(vert_adaptive_dhat(cc[1]), dist);
             break;
         default:
             throw std::runtime_error("Invalid collision type!");
         }
     }
+}
 
+void SmoothCollisions::propagate_adaptive_dhat(const CollisionMesh& mesh)
+{
     // face adaptive dhat should be minimum of all its adjacent vertices and
     // edges
     if (mesh.dim() == 3)
-        for (int f = 0; f < mesh.num_faces(); f++) {
-            for (int lv = 0; lv < 3; lv++) {
-                face_adaptive_dhat(f) = std::min(
-                    face_adaptive_dhat(f),
-                    vert_adaptive_dhat(mesh.faces()(f, lv)));
-                face_adaptive_dhat(f) = std::min(
-                    face_adaptive_dhat(f),
-                    edge_adaptive_dhat(mesh.faces_to_edges()(f, lv)));
-            }
-        }
+        tbb::parallel_for(
+            tbb::blocked_range<int>(0, mesh.num_faces()),
+            [&](const tbb::blocked_range<int>& r) {
+                for (int f = r.begin(); f < r.end(); f++) {
+                    for (int lv = 0; lv < 3; lv++) {
+                        face_adaptive_dhat(f) = std::min(
+                            face_adaptive_dhat(f),
+                            vert_adaptive_dhat(mesh.faces()(f, lv)));
+                        face_adaptive_dhat(f) = std::min(
+                            face_adaptive_dhat(f),
+                            edge_adaptive_dhat(mesh.faces_to_edges()(f, lv)));
+                    }
+                }
+            });
 
     // edge adaptive dhat should be minimum of all its adjacent vertices
-    for (int e = 0; e < mesh.num_edges(); e++) {
-        for (int lv = 0; lv < 2; lv++) {
-            edge_adaptive_dhat(e) = std::min(
-                edge_adaptive_dhat(e), vert_adaptive_dhat(mesh.edges()(e, lv)));
-        }
-    }
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, mesh.num_edges()),
+        [&](const tbb::blocked_range<int>& r) {
+            for (int e = r.begin(); e < r.end(); e++) {
+                for (int lv = 0; lv < 2; lv++) {
+                    edge_adaptive_dhat(e) = std::min(
+                        edge_adaptive_dhat(e),
+                        vert_adaptive_dhat(mesh.edges()(e, lv)));
+                }
+            }
+        });
 
     logger().debug(
         "Adaptive dhat: vert dhat min {:.2e}, max {:.2e}",
@@ -159,8 +241,7 @@ void SmoothCollisions::build(
 
     if (mesh.dim() == 2) {
         auto storage =
-            ipc::utils::create_thread_storage<SmoothCollisionsBuilder<2>>(
-                SmoothCollisionsBuilder<2>());
+            ipc::utils::create_thread_storage<SmoothCollisionsBuilder<2>>();
         ipc::utils::maybe_parallel_for(
             candidates_.ev_candidates.size(),
             [&](int start, int end, int thread_id) {
@@ -173,8 +254,7 @@ void SmoothCollisions::build(
         SmoothCollisionsBuilder<2>::merge(storage, *this);
     } else {
         auto storage =
-            ipc::utils::create_thread_storage<SmoothCollisionsBuilder<3>>(
-                SmoothCollisionsBuilder<3>());
+            ipc::utils::create_thread_storage<SmoothCollisionsBuilder<3>>();
         ipc::utils::maybe_parallel_for(
             candidates_.ee_candidates.size(),
             [&](int start, int end, int thread_id) {
@@ -200,14 +280,28 @@ void SmoothCollisions::build(
 }
 
 // ============================================================================
-size_t SmoothCollisions::size() const { return collisions.size(); }
-bool SmoothCollisions::empty() const { return collisions.empty(); }
-void SmoothCollisions::clear() { collisions.clear(); }
+size_t SmoothCollisions::size() const
+{
+    return std::apply(
+        [](const auto&... pool) { return (pool.size() + ...); }, pools());
+}
+
+bool SmoothCollisions::empty() const { return size() == 0; }
+
+void SmoothCollisions::clear()
+{
+    if (m_pools.use_count() > 1) {
+        // Leave the current pools to the shared_collision() handles.
+        m_pools = std::make_shared<Pools>();
+    } else {
+        std::apply([](auto&... pool) { (pool.clear(), ...); }, *m_pools);
+    }
+}
 
 typename SmoothCollisions::value_type& SmoothCollisions::operator[](size_t i)
 {
-    if (i < collisions.size()) {
-        return *collisions[i];
+    if (value_type* collision = find_collision<value_type>(pools(), i)) {
+        return *collision;
     }
     throw std::out_of_range("Collision index is out of range!");
 }
@@ -215,26 +309,34 @@ typename SmoothCollisions::value_type& SmoothCollisions::operator[](size_t i)
 const typename SmoothCollisions::value_type&
 SmoothCollisions::operator[](size_t i) const
 {
-    if (i < collisions.size()) {
-        return *collisions[i];
+    if (const value_type* collision =
+            find_collision<const value_type>(pools(), i)) {
+        return *collision;
     }
     throw std::out_of_range("Collision index is out of range!");
 }
 
+std::shared_ptr<const typename SmoothCollisions::value_type>
+SmoothCollisions::shared_collision(size_t i) const
+{
+    return std::shared_ptr<const value_type>(m_pools, &(*this)[i]);
+}
+
 std::string SmoothCollisions::to_string(
     const CollisionMesh& mesh,
     Eigen::ConstRef<Eigen::MatrixXd> vertices,
     const ParameterType& params) const
 {
     std::stringstream ss;
-    for (const auto& cc : collisions) {
+    for (size_t i = 0; i < size(); i++) {
+        const SmoothCollision& cc = (*this)[i];
         ss << "\n";
         {
             ss << fmt::format(
-                "[{}]: ({} {}) dist {} potential {} grad {}", cc->name(),
-                (*cc)[0], (*cc)[1], cc->compute_distance(vertices),
-                (*cc)(cc->dof(vertices), params),
-                (*cc).gradient(cc->dof(vertices), params).norm());
+                "[{}]: ({} {}) dist {} potential {} grad {}", cc.name(), cc[0],
+                cc[1], cc.compute_distance(vertices),
+                cc(cc.dof(vertices), params),
+                cc.gradient(cc.dof(vertices), params).norm());
         }
     }
     return ss.str();
@@ -279,7 +381,7 @@ double SmoothCollisions::compute_active_minimum_distance(
 {
     assert(vertices.rows() == mesh.num_vertices());
 
-    if (collisions.empty()) {
+    if (empty()) {
         return std::numeric_limits<double>::infinity();
     }
 
@@ -287,14 +389,15 @@ double SmoothCollisions::compute_active_minimum_distance(
         std::numeric_limits<double>::infinity());
 
     tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, collisions.size()),
+        tbb::blocked_range<size_t>(0, size()),
         [&](tbb::blocked_range<size_t> r) {
             double& local_min_dist = storage.local();
 
             for (size_t i = r.begin(); i < r.end(); i++) {
-                const double dist = collisions[i]->compute_distance(vertices);
+                const SmoothCollision& cc = (*this)[i];
+                const double dist = cc.compute_distance(vertices);
 
-                if (collisions[i]->is_active() && dist < local_min_dist) {
+                if (cc.is_active() && dist < local_min_dist) {
                     local_min_dist = dist;
                 }
             }
@@ -12,16 +12,44 @@
 
 #include <Eigen/Core>
 
+#include <memory>
+#include <tuple>
 #include <vector>
 
 namespace ipc {
+
+/// @brief A set of smooth contact collisions.
+///
+/// The collisions are stored by value in one contiguous pool per primitive
+/// pair type. Collisions are indexed in the order of the pools (2D
+/// vertex-vertex, 2D edge-vertex, 3D vertex-vertex, 3D edge-vertex, edge-edge,
+/// then face-vertex).
+///
+/// @note Adding a collision invalidates references to the collisions of the
+///       same type. Use shared_collision() to keep a collision alive after the
+///       set is cleared, rebuilt, or destroyed.
 class SmoothCollisions {
 public:
     /// @brief The type of the collisions.
     using value_type = SmoothCollision;
 
+    /// @brief Contiguous storage of collisions of one primitive pair type.
+    template <typename PrimitiveA, typename PrimitiveB>
+    using Pool = std::vector<SmoothCollisionTemplate<PrimitiveA, PrimitiveB>>;
+
+    /// @brief One pool per primitive pair type.
+    using Pools = std::tuple<
+        Pool<Point2, Point2>,
+        Pool<Edge2, Point2>,
+        Pool<Point3, Point3>,
+        Pool<Edge3, Point3>,
+        Pool<Edge3, Edge3>,
+        Pool<Face, Point3>>;
+
 public:
     SmoothCollisions() = default;
+    SmoothCollisions(SmoothCollisions&&) = default;
+    SmoothCollisions& operator=(SmoothCollisions&&) = default;
     virtual ~SmoothCollisions() = default;
 
     void compute_adaptive_dhat(
@@ -31,6 +59,23 @@ public:
         const std::shared_ptr<BroadPhase> broad_phase =
             make_default_broad_phase());
 
+    /// @brief Lower the adaptive dhat using only a set of new candidates.
+    ///
+    /// The adaptive dhat of a primitive is a minimum over its candidates, so
+    /// after compute_adaptive_dhat() it only needs to be updated with the
+    /// candidates added since (e.g., after refining the mesh). Primitives
+    /// added to the mesh start at param.dhat.
+    ///
+    /// @param new_candidates Candidates not yet accounted for.
+    /// @param mesh The collision mesh.
+    /// @param vertices Vertices of the collision mesh.
+    /// @param param Smooth contact parameters.
+    void update_adaptive_dhat(
+        const Candidates& new_candidates,
+        const CollisionMesh& mesh,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices,
+        const ParameterType param);
+
     /// @brief Initialize the set of collisions used to compute the barrier potential.
     /// @param mesh The collision mesh.
     /// @param vertices Vertices of the collision mesh.
@@ -75,6 +120,48 @@ public:
     /// @return A const reference to the collision.
     const value_type& operator[](size_t i) const;
 
+    /// @brief Get a handle to the collision at index i that shares ownership of its pool.
+    /// @note The handle stays valid after this set is cleared, rebuilt, or destroyed, but not after collisions are added to it without clearing it first.
+    /// @param i The index of the collision.
+    /// @return A shared pointer to the collision.
+    std::shared_ptr<const value_type> shared_collision(size_t i) const;
+
+    /// @brief Get all the pools of collisions.
+    const Pools& pools() const { return *m_pools; }
+
+    /// @brief Get all the pools of collisions.
+    /// @note The pools must not be modified while shared_collision() handles to them are alive.
+    Pools& pools()
+    {
+        assert(m_pools.use_count() == 1);
+        return *m_pools;
+    }
+
+    /// @brief Get the pool of collisions between two primitive types.
+    template <typename PrimitiveA, typename PrimitiveB>
+    Pool<PrimitiveA, PrimitiveB>& pool()
+    {
+        return std::get<Pool<PrimitiveA, PrimitiveB>>(pools());
+    }
+
+    /// @brief Get the pool of collisions between two primitive types.
+    template <typename PrimitiveA, typename PrimitiveB>
+    const Pool<PrimitiveA, PrimitiveB>& pool() const
+    {
+        return std::get<Pool<PrimitiveA, PrimitiveB>>(pools());
+    }
+
+    /// @brief Construct a collision at the end of its pool.
+    /// @param args Arguments of the SmoothCollisionTemplate constructor.
+    /// @return A reference to the new collision.
+    template <typename PrimitiveA, typename PrimitiveB, typename... Args>
+    SmoothCollisionTemplate<PrimitiveA, PrimitiveB>&
+    emplace_back(Args&&... args)
+    {
+        return pool<PrimitiveA, PrimitiveB>().emplace_back(
+            std::forward<Args>(args)...);
+    }
+
     double compute_minimum_distance(
         const CollisionMesh& mesh,
         Eigen::ConstRef<Eigen::MatrixXd> vertices) const;
@@ -120,9 +207,22 @@ public:
 
     inline int n_candidates() const { return candidates.size(); }
 
-public:
-    std::vector<std::shared_ptr<value_type>> collisions;
+private:
+    /// @brief Lower the adaptive dhat of the primitives of each collision to
+    ///        the scaled distance of the collision.
+    void lower_adaptive_dhat(
+        const SmoothCollisions& new_collisions,
+        Eigen::ConstRef<Eigen::MatrixXd> vertices,
+        const ParameterType& param);
 
+    /// @brief Lower the adaptive dhat of the edges and faces to the minimum of
+    ///        their vertices (and edges).
+    void propagate_adaptive_dhat(const CollisionMesh& mesh);
+
+    /// @brief Storage of the collisions, shared with shared_collision() handles.
+    std::shared_ptr<Pools> m_pools = std::make_shared<Pools>();
+
+public:
     Eigen::VectorXd vert_adaptive_dhat;
     Eigen::VectorXd edge_adaptive_dhat;
     Eigen::VectorXd face_adaptive_dhat;
@@ -13,30 +13,60 @@
 namespace ipc {
 
 namespace {
-    template <int dim, typename TCollision>
+    /// @brief Construct a collision and keep it if it is active.
+    template <typename PrimitiveA, typename PrimitiveB, typename... Args>
     void add_collision(
-        const std::shared_ptr<TCollision>& pair,
-        unordered_map<std::pair<long, long>, std::shared_ptr<TCollision>>&
-            cc_to_id_,
-        std::vector<std::shared_ptr<typename SmoothCollisions::value_type>>&
-            collisions_)
+        SmoothCollisions::Pool<PrimitiveA, PrimitiveB>& collisions_,
+        Args&&... args)
     {
-        if (pair->is_active()
-            && cc_to_id_.find(pair->get_hash()) == cc_to_id_.end()) {
-            // New collision, so add it to the end of collisions
-            cc_to_id_.emplace(pair->get_hash(), pair);
-            collisions_.push_back(pair);
+        collisions_.emplace_back(std::forward<Args>(args)...);
+        if (!collisions_.back().is_active()) {
+            collisions_.pop_back();
         }
     }
 
-    template <int dim, typename TCollision>
+    /// @brief Construct a collision unless its pair was already constructed.
+    template <typename PrimitiveA, typename PrimitiveB, typename... Args>
     void add_collision(
-        const std::shared_ptr<TCollision>& pair,
-        std::vector<std::shared_ptr<typename SmoothCollisions::value_type>>&
-            collisions_)
+        const std::pair<long, long>& key,
+        unordered_set<std::pair<long, long>>& keys_,
+        SmoothCollisions::Pool<PrimitiveA, PrimitiveB>& collisions_,
+        Args&&... args)
     {
-        if (pair->is_active())
-            collisions_.push_back(pair);
+        if (keys_.find(key) != keys_.end()) {
+            return;
+        }
+        const size_t n = collisions_.size();
+        add_collision(collisions_, std::forward<Args>(args)...);
+        if (collisions_.size() > n) {
+            keys_.insert(key);
+        }
+    }
+
+    /// @brief Move the collisions of one type from the builders to a pool.
+    /// @param builders Thread-local builders.
+    /// @param get_pool Function returning a builder's pool of the type.
+    /// @param merged Pool to append the collisions to.
+    /// @param unique Whether to drop the collisions of pairs already merged.
+    template <typename Builders, typename GetPool, typename Pool>
+    void merge_pool(
+        Builders& builders, GetPool&& get_pool, Pool& merged, const bool unique)
+    {
+        size_t total = merged.size();
+        for (auto& builder : builders) {
+            total += get_pool(builder).size();
+        }
+        merged.reserve(total);
+
+        unordered_set<std::pair<long, long>> keys;
+        for (auto& builder : builders) {
+            for (auto& collision : get_pool(builder)) {
+                if (!unique || keys.insert(collision.get_hash()).second) {
+                    merged.push_back(std::move(collision));
+                }
+            }
+            get_pool(builder).clear();
+        }
     }
 } // namespace
 
@@ -53,22 +83,21 @@ void SmoothCollisionsBuilder<2>::add_edge_vertex_collisions(
     for (size_t i = start_i; i < end_i; i++) {
         const auto& [ei, vi] = candidates[i];
 
-        add_collision<2, SmoothCollisionTemplate<Edge2, Point2>>(
-            std::make_shared<SmoothCollisionTemplate<Edge2, Point2>>(
-                ei, vi, PointEdgeDistanceType::AUTO, mesh, param,
-                std::min(edge_dhat(ei), vert_dhat(vi)), vertices),
-            vert_edge_2_to_id, collisions);
+        add_collision(
+            { ei, vi }, vert_edge_2_keys, vert_edge_2, ei, vi,
+            PointEdgeDistanceType::AUTO, mesh, param,
+            std::min(edge_dhat(ei), vert_dhat(vi)), vertices);
 
         for (int j : { 0, 1 }) {
             const auto& vj = mesh.edges()(ei, j);
             const double dhat = std::min(vert_dhat(vi), vert_dhat(vj));
             if ((vertices.row(vi) - vertices.row(vj)).norm() >= dhat)
                 continue;
-            add_collision<2, SmoothCollisionTemplate<Point2, Point2>>(
-                std::make_shared<SmoothCollisionTemplate<Point2, Point2>>(
-                    std::min<long>(vi, vj), std::max<long>(vi, vj),
-                    PointPointDistanceType::AUTO, mesh, param, dhat, vertices),
-                vert_vert_2_to_id, collisions);
+            const std::pair<long, long> key(
+                std::min<long>(vi, vj), std::max<long>(vi, vj));
+            add_collision(
+                key, vert_vert_2_keys, vert_vert_2, key.first, key.second,
+                PointPointDistanceType::AUTO, mesh, param, dhat, vertices);
         }
     }
 }
@@ -101,11 +130,9 @@ void SmoothCollisionsBuilder<3>::add_edge_edge_collisions(
             || distance >= param.dhat)
             continue;
 
-        add_collision<3, SmoothCollisionTemplate<Edge3, Edge3>>(
-            std::make_shared<SmoothCollisionTemplate<Edge3, Edge3>>(
-                std::min(eai, ebi), std::max(eai, ebi), actual_dtype, mesh,
-                param, std::min(edge_dhat(eai), edge_dhat(ebi)), vertices),
-            collisions);
+        add_collision(
+            edge_edge_3, std::min(eai, ebi), std::max(eai, ebi), actual_dtype,
+            mesh, param, std::min(edge_dhat(eai), edge_dhat(ebi)), vertices);
     }
 }
 
@@ -136,22 +163,20 @@ void SmoothCollisionsBuilder<3>::add_face_vertex_collisions(
             continue;
 
         if (pt_dtype == PointTriangleDistanceType::P_T)
-            add_collision<3, SmoothCollisionTemplate<Face, Point3>>(
-                std::make_shared<SmoothCollisionTemplate<Face, Point3>>(
-                    fi, vi, pt_dtype, mesh, param,
-                    std::min(face_dhat(fi), vert_dhat(vi)), vertices),
-                collisions);
+            add_collision(
+                face_vert_3, fi, vi, pt_dtype, mesh, param,
+                std::min(face_dhat(fi), vert_dhat(vi)), vertices);
 
         for (int lv = 0; lv < 3; lv++) {
             const auto& vj = mesh.faces()(fi, lv);
             const double dhat = std::min(vert_dhat(vi), vert_dhat(vj));
             if ((vertices.row(vi) - vertices.row(vj)).norm() >= dhat)
                 continue;
-            add_collision<3, SmoothCollisionTemplate<Point3, Point3>>(
-                std::make_shared<SmoothCollisionTemplate<Point3, Point3>>(
-                    std::min<long>(vi, vj), std::max<long>(vi, vj),
-                    PointPointDistanceType::AUTO, mesh, param, dhat, vertices),
-                vert_vert_3_to_id, collisions);
+            const std::pair<long, long> key(
+                std::min<long>(vi, vj), std::max<long>(vi, vj));
+            add_collision(
+                key, vert_vert_3_keys, vert_vert_3, key.first, key.second,
+                PointPointDistanceType::AUTO, mesh, param, dhat, vertices);
         }
 
         for (int le = 0; le < 3; le++) {
@@ -169,109 +194,73 @@ void SmoothCollisionsBuilder<3>::add_face_vertex_collisions(
                 || sqrt(distance_sqr) >= dhat)
                 continue;
 
-            add_collision<3, SmoothCollisionTemplate<Edge3, Point3>>(
-                std::make_shared<SmoothCollisionTemplate<Edge3, Point3>>(
-                    eid, vi, pe_dtype, mesh, param, dhat, vertices),
-                edge_vert_3_to_id, collisions);
+            add_collision(
+                { eid, vi }, edge_vert_3_keys, edge_vert_3, eid, vi, pe_dtype,
+                mesh, param, dhat, vertices);
         }
     }
 }
 
 void SmoothCollisionsBuilder<3>::merge(
-    const utils::ParallelCacheType<SmoothCollisionsBuilder<3>>& local_storage,
+    utils::ParallelCacheType<SmoothCollisionsBuilder<3>>& local_storage,
     SmoothCollisions& merged_collisions)
 {
-    unordered_map<
-        std::pair<long, long>,
-        std::shared_ptr<SmoothCollisionTemplate<Point3, Point3>>>
-        vert_vert_3_to_id;
-    unordered_map<
-        std::pair<long, long>,
-        std::shared_ptr<SmoothCollisionTemplate<Edge3, Point3>>>
-        edge_vert_3_to_id;
-
-    // size up the hash items
-    size_t total = 0;
-    for (const auto& storage : local_storage)
-        total += storage.collisions.size();
-
-    merged_collisions.collisions.reserve(total);
-
-    // merge
-    for (const auto& builder : local_storage) {
-        vert_vert_3_to_id.insert(
-            builder.vert_vert_3_to_id.begin(), builder.vert_vert_3_to_id.end());
-        edge_vert_3_to_id.insert(
-            builder.edge_vert_3_to_id.begin(), builder.edge_vert_3_to_id.end());
-    }
-    int edge_vert_count = edge_vert_3_to_id.size();
-    int vert_vert_count = vert_vert_3_to_id.size();
-    int face_vert_count = 0;
-    int edge_edge_count = 0;
-
-    for (const auto& [key, val] : vert_vert_3_to_id)
-        merged_collisions.collisions.push_back(val);
-    for (const auto& [key, val] : edge_vert_3_to_id)
-        merged_collisions.collisions.push_back(val);
-
-    for (const auto& builder : local_storage) {
-        for (const auto& cc : builder.collisions) {
-            if (cc->type() == CollisionType::FaceVertex) {
-                face_vert_count++;
-                merged_collisions.collisions.push_back(cc);
-            } else if (cc->type() == CollisionType::EdgeEdge) {
-                edge_edge_count++;
-                merged_collisions.collisions.push_back(cc);
-            }
-        }
-    }
+    merge_pool(
+        local_storage,
+        [](SmoothCollisionsBuilder<3>& builder) -> auto& {
+            return builder.vert_vert_3;
+        },
+        merged_collisions.pool<Point3, Point3>(), /*unique=*/true);
+    merge_pool(
+        local_storage,
+        [](SmoothCollisionsBuilder<3>& builder) -> auto& {
+            return builder.edge_vert_3;
+        },
+        merged_collisions.pool<Edge3, Point3>(), /*unique=*/true);
+    merge_pool(
+        local_storage,
+        [](SmoothCollisionsBuilder<3>& builder) -> auto& {
+            return builder.edge_edge_3;
+        },
+        merged_collisions.pool<Edge3, Edge3>(), /*unique=*/false);
+    merge_pool(
+        local_storage,
+        [](SmoothCollisionsBuilder<3>& builder) -> auto& {
+            return builder.face_vert_3;
+        },
+        merged_collisions.pool<Face, Point3>(), /*unique=*/false);
 
     logger().trace(
-        "edge-vert pairs {}, vert-vert pairs {}", edge_vert_count,
-        vert_vert_count);
+        "edge-vert pairs {}, vert-vert pairs {}",
+        merged_collisions.pool<Edge3, Point3>().size(),
+        merged_collisions.pool<Point3, Point3>().size());
     logger().trace(
-        "face-vert pairs {}, edge-edge pairs {}", face_vert_count,
-        edge_edge_count);
+        "face-vert pairs {}, edge-edge pairs {}",
+        merged_collisions.pool<Face, Point3>().size(),
+        merged_collisions.pool<Edge3, Edge3>().size());
 }
 
 void SmoothCollisionsBuilder<2>::merge(
-    const utils::ParallelCacheType<SmoothCollisionsBuilder<2>>& local_storage,
+    utils::ParallelCacheType<SmoothCollisionsBuilder<2>>& local_storage,
     SmoothCollisions& merged_collisions)
 {
-    unordered_map<
-        std::pair<long, long>,
-        std::shared_ptr<SmoothCollisionTemplate<Point2, Point2>>>
-        vert_vert_2_to_id;
-    unordered_map<
-        std::pair<long, long>,
-        std::shared_ptr<SmoothCollisionTemplate<Edge2, Point2>>>
-        vert_edge_2_to_id;
-
-    // size up the hash items
-    size_t total = 0;
-    for (const auto& storage : local_storage)
-        total += storage.collisions.size();
-
-    merged_collisions.collisions.reserve(total);
-
-    // merge
-    for (auto& builder : local_storage) {
-        vert_vert_2_to_id.insert(
-            builder.vert_vert_2_to_id.begin(), builder.vert_vert_2_to_id.end());
-        vert_edge_2_to_id.insert(
-            builder.vert_edge_2_to_id.begin(), builder.vert_edge_2_to_id.end());
-    }
-    int edge_vert_count = vert_edge_2_to_id.size();
-    int vert_vert_count = vert_vert_2_to_id.size();
-
-    for (const auto& [key, val] : vert_vert_2_to_id)
-        merged_collisions.collisions.push_back(val);
-    for (const auto& [key, val] : vert_edge_2_to_id)
-        merged_collisions.collisions.push_back(val);
+    merge_pool(
+        local_storage,
+        [](SmoothCollisionsBuilder<2>& builder) -> auto& {
+            return builder.vert_vert_2;
+        },
+        merged_collisions.pool<Point2, Point2>(), /*unique=*/true);
+    merge_pool(
+        local_storage,
+        [](SmoothCollisionsBuilder<2>& builder) -> auto& {
+            return builder.vert_edge_2;
+        },
+        merged_collisions.pool<Edge2, Point2>(), /*unique=*/true);
 
     logger().trace(
-        "edge-vert pairs {}, vert-vert pairs {}", edge_vert_count,
-        vert_vert_count);
+        "edge-vert pairs {}, vert-vert pairs {}",
+        merged_collisions.pool<Edge2, Point2>().size(),
+        merged_collisions.pool<Point2, Point2>().size());
 }
 
 } // namespace ipc
\ No newline at end of file
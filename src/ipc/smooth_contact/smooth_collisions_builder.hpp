@@ -27,26 +27,21 @@ public:
 
     // -------------------------------------------------------------------------
 
+    /// @brief Move the constructed collisions into a set of collisions.
+    /// @note The builders are left empty.
     static void merge(
-        const utils::ParallelCacheType<SmoothCollisionsBuilder<2>>&
-            local_storage,
+        utils::ParallelCacheType<SmoothCollisionsBuilder<2>>& local_storage,
         SmoothCollisions& merged_collisions);
 
     // Constructed collisions
-    std::vector<std::shared_ptr<typename SmoothCollisions::value_type>>
-        collisions;
+    SmoothCollisions::Pool<Point2, Point2> vert_vert_2;
+    SmoothCollisions::Pool<Edge2, Point2> vert_edge_2;
 
     // -------------------------------------------------------------------------
 
-    // Store the indices to pairs to avoid duplicates.
-    unordered_map<
-        std::pair<long, long>,
-        std::shared_ptr<SmoothCollisionTemplate<Point2, Point2>>>
-        vert_vert_2_to_id;
-    unordered_map<
-        std::pair<long, long>,
-        std::shared_ptr<SmoothCollisionTemplate<Edge2, Point2>>>
-        vert_edge_2_to_id;
+    // Store the pairs already constructed to avoid duplicates.
+    unordered_set<std::pair<long, long>> vert_vert_2_keys;
+    unordered_set<std::pair<long, long>> vert_edge_2_keys;
 };
 
 template <> class SmoothCollisionsBuilder<3> {
@@ -76,27 +71,24 @@ public:
 
     // -------------------------------------------------------------------------
 
+    /// @brief Move the constructed collisions into a set of collisions.
+    /// @note The builders are left empty.
     static void merge(
-        const utils::ParallelCacheType<SmoothCollisionsBuilder<3>>&
-            local_storage,
+        utils::ParallelCacheType<SmoothCollisionsBuilder<3>>& local_storage,
         SmoothCollisions& merged_collisions);
 
     // Constructed collisions
-    std::vector<std::shared_ptr<typename SmoothCollisions::value_type>>
-        collisions;
+    SmoothCollisions::Pool<Point3, Point3> vert_vert_3;
+    SmoothCollisions::Pool<Edge3, Point3> edge_vert_3;
+    SmoothCollisions::Pool<Edge3, Edge3> edge_edge_3;
+    SmoothCollisions::Pool<Face, Point3> face_vert_3;
 
     // -------------------------------------------------------------------------
 
-    // Store the indices to pairs to avoid duplicates, no need for Face-Vertex
-    // and Edge-Edge
-    unordered_map<
-        std::pair<long, long>,
-        std::shared_ptr<SmoothCollisionTemplate<Point3, Point3>>>
-        vert_vert_3_to_id;
-    unordered_map<
-        std::pair<long, long>,
-        std::shared_ptr<SmoothCollisionTemplate<Edge3, Point3>>>
-        edge_vert_3_to_id;
+    // Store the pairs already constructed to avoid duplicates, no need for
+    // Face-Vertex and Edge-Edge
+    unordered_set<std::pair<long, long>> vert_vert_3_keys;
+    unordered_set<std::pair<long, long>> edge_vert_3_keys;
 };
 
 } // namespace ipc
\ No newline at end of file
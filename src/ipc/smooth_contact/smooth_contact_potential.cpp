@@ -7,8 +7,23 @@
 #include <tbb/combinable.h>
 #include <tbb/enumerable_thread_specific.h>
 
+#include <tuple>
+
 namespace ipc {
 
+namespace {
+    /// @brief Call f on each pool of collisions of the same type.
+    ///
+    /// The collisions of a pool are stored by value and have a final type, so
+    /// their evaluation is statically dispatched.
+    template <typename F>
+    void for_each_pool(const SmoothCollisions& collisions, F&& f)
+    {
+        std::apply(
+            [&](const auto&... pool) { (f(pool), ...); }, collisions.pools());
+    }
+} // namespace
+
 double SmoothContactPotential::operator()(
     const SmoothCollisions& collisions,
     const CollisionMesh& mesh,
@@ -22,15 +37,18 @@ double SmoothContactPotential::operator()(
 
     tbb::enumerable_thread_specific<double> storage(0);
 
-    tbb::parallel_for(
-        tbb::blocked_range<size_t>(size_t(0), collisions.size()),
-        [&](const tbb::blocked_range<size_t>& r) {
-            auto& local_potential = storage.local();
-            for (size_t i = r.begin(); i < r.end(); i++) {
-                // Quadrature weight is premultiplied by local potential
-                local_potential += (*this)(collisions[i], collisions[i].dof(X));
-            }
-        });
+    for_each_pool(collisions, [&](const auto& pool) {
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(size_t(0), pool.size()),
+            [&](const tbb::blocked_range<size_t>& r) {
+                auto& local_potential = storage.local();
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    // Quadrature weight is premultiplied by local potential
+                    local_potential +=
+                        pool[i].weight * pool[i](pool[i].dof(X), params);
+                }
+            });
+    });
 
     return storage.combine([](double a, double b) { return a + b; });
 }
@@ -48,30 +66,37 @@ Eigen::VectorXd SmoothContactPotential::gradient(
 
     const int dim = X.cols();
 
-    auto storage = ipc::utils::create_thread_storage<Eigen::VectorXd>(
-        Eigen::VectorXd::Zero(X.size()));
-    ipc::utils::maybe_parallel_for(
-        collisions.size(), [&](int start, int end, int thread_id) {
-            auto& global_grad =
-                ipc::utils::get_local_thread_storage(storage, thread_id);
-
-            for (size_t i = start; i < end; i++) {
-                const SmoothCollision& collision = collisions[i];
+    // Use sparse local storage if the collisions touch few of the DOF.
+    size_t max_nonzeros = 0;
+    for_each_pool(collisions, [&](const auto& pool) {
+        for (const auto& collision : pool) {
+            max_nonzeros += collision.n_dofs();
+        }
+    });
+    auto storage = ipc::utils::create_thread_storage(
+        LocalThreadVecStorage(X.size(), max_nonzeros));
+    for_each_pool(collisions, [&](const auto& pool) {
+        ipc::utils::maybe_parallel_for(
+            pool.size(), [&](int start, int end, int thread_id) {
+                auto& global_grad =
+                    ipc::utils::get_local_thread_storage(storage, thread_id);
 
-                const Eigen::VectorXd local_grad =
-                    this->gradient(collision, collision.dof(X));
+                for (size_t i = start; i < end; i++) {
+                    const auto& collision = pool[i];
 
-                const std::vector<index_t> vids = collision.vertex_ids();
+                    const Eigen::VectorXd local_grad = collision.weight
+                        * collision.gradient(collision.dof(X), params);
 
-                local_gradient_to_global_gradient(
-                    local_grad, vids, dim, global_grad);
-            }
-        });
+                    local_gradient_to_global_gradient(
+                        local_grad, collision.vertex_ids(), dim, global_grad);
+                }
+            });
+    });
 
     Eigen::VectorXd grad;
     grad.setZero(X.size());
     for (const auto& local_storage : storage)
-        grad += local_storage;
+        local_storage.add_to(grad);
     return grad;
 }
 
@@ -87,115 +112,177 @@ Eigen::SparseMatrix<double> SmoothContactPotential::hessian(
         return Eigen::SparseMatrix<double>(X.size(), X.size());
     }
 
-    const int dim = X.cols();
-    const int ndof = X.size();
+    // Color the collisions and write their local Hessians directly into the
+    // compressed matrix.
+    HessianAssembler assembler;
+    assembler.init(
+        collisions.size(), X.rows(), X.cols(),
+        [&](size_t i) -> const std::vector<index_t>& {
+            return collisions[i].vertex_ids();
+        },
+        [&](size_t i) { return collisions[i].num_vertices(); });
+
+    // Reuse one local Hessian per thread.
+    tbb::enumerable_thread_specific<Eigen::MatrixXd> local_hessians;
+    return assembler.assemble([&](size_t i) -> const Eigen::MatrixXd& {
+        Eigen::MatrixXd& local_hess = local_hessians.local();
+        this->hessian(
+            collisions[i], collisions[i].dof(X), local_hess,
+            project_hessian_to_psd);
+        return local_hess;
+    });
+}
 
-    const int max_triplets_size = int(1e7);
-    const int buffer_size = std::min(max_triplets_size, ndof);
-    auto storage = ipc::utils::create_thread_storage(
-        LocalThreadMatStorage(buffer_size, ndof, ndof));
-    ipc::utils::maybe_parallel_for(
-        collisions.size(), [&](int start, int end, int thread_id) {
-            auto& hess_triplets =
-                ipc::utils::get_local_thread_storage(storage, thread_id);
+bool SmoothContactPotential::hessian(
+    const SmoothCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> X,
+    HessianAssembler& assembler,
+    Eigen::SparseMatrix<double>& hess,
+    const PSDProjectionMethod project_hessian_to_psd) const
+{
+    assert(X.rows() == mesh.num_vertices());
 
-            for (size_t i = start; i < end; i++) {
-                const SmoothCollision& collision = collisions[i];
+    const bool pattern_changed = assembler.update(
+        collisions.size(), X.rows(), X.cols(),
+        [&](size_t i) -> const std::vector<index_t>& {
+            return collisions[i].vertex_ids();
+        },
+        [&](size_t i) { return collisions[i].num_vertices(); });
+
+    tbb::enumerable_thread_specific<Eigen::MatrixXd> local_hessians;
+    assembler.assemble(
+        [&](size_t i) -> const Eigen::MatrixXd& {
+            Eigen::MatrixXd& local_hess = local_hessians.local();
+            this->hessian(
+                collisions[i], collisions[i].dof(X), local_hess,
+                project_hessian_to_psd);
+            return local_hess;
+        },
+        hess);
+
+    return pattern_changed;
+}
 
-                const Eigen::MatrixXd local_hess = this->hessian(
-                    collisions[i], collisions[i].dof(X),
-                    project_hessian_to_psd);
+BlockSparseMatrix SmoothContactPotential::block_hessian(
+    const SmoothCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> X,
+    const PSDProjectionMethod project_hessian_to_psd) const
+{
+    assert(X.rows() == mesh.num_vertices());
 
-                local_hessian_to_global_triplets(
-                    local_hess, collision.vertex_ids(), dim,
-                    *(hess_triplets.cache));
-            }
+    HessianAssembler assembler;
+    assembler.init(
+        collisions.size(), X.rows(), X.cols(),
+        [&](size_t i) -> const std::vector<index_t>& {
+            return collisions[i].vertex_ids();
+        },
+        [&](size_t i) { return collisions[i].num_vertices(); });
+
+    tbb::enumerable_thread_specific<Eigen::MatrixXd> local_hessians;
+    return assembler.assemble_blocks([&](size_t i) -> const Eigen::MatrixXd& {
+        Eigen::MatrixXd& local_hess = local_hessians.local();
+        this->hessian(
+            collisions[i], collisions[i].dof(X), local_hess,
+            project_hessian_to_psd);
+        return local_hess;
+    });
+}
+
+Eigen::VectorXd SmoothContactPotential::hessian_vector_product(
+    const SmoothCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> X,
+    Eigen::ConstRef<Eigen::VectorXd> v,
+    const PSDProjectionMethod project_hessian_to_psd) const
+{
+    assert(X.rows() == mesh.num_vertices());
+    assert(v.size() == X.size());
+
+    tbb::enumerable_thread_specific<Eigen::MatrixXd> local_hessians;
+    return hessian_vector_product(
+        collisions, X.cols(), v, [&](size_t i) -> const Eigen::MatrixXd& {
+            Eigen::MatrixXd& local_hess = local_hessians.local();
+            this->hessian(
+                collisions[i], collisions[i].dof(X), local_hess,
+                project_hessian_to_psd);
+            return local_hess;
         });
+}
 
-    Eigen::SparseMatrix<double> hess(ndof, ndof);
+std::vector<Eigen::MatrixXd> SmoothContactPotential::local_hessians(
+    const SmoothCollisions& collisions,
+    const CollisionMesh& mesh,
+    Eigen::ConstRef<Eigen::MatrixXd> X,
+    const PSDProjectionMethod project_hessian_to_psd) const
+{
+    assert(X.rows() == mesh.num_vertices());
 
-    // Assemble the stiffness matrix by concatenating the tuples in each local
-    // storage
+    std::vector<Eigen::MatrixXd> hessians(collisions.size());
 
-    // Collect thread storages
-    std::vector<LocalThreadMatStorage*> storages(storage.size());
-    int index = 0;
-    for (auto& local_storage : storage) {
-        storages[index++] = &local_storage;
-    }
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), collisions.size()),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                this->hessian(
+                    collisions[i], collisions[i].dof(X), hessians[i],
+                    project_hessian_to_psd);
+            }
+        });
 
-    utils::maybe_parallel_for(
-        storages.size(), [&](int i) { storages[i]->cache->prune(); });
+    return hessians;
+}
 
-    if (storage.size() == 0) {
-        return Eigen::SparseMatrix<double>();
-    }
+Eigen::VectorXd SmoothContactPotential::hessian_vector_product(
+    const SmoothCollisions& collisions,
+    const CollisionMesh& mesh,
+    const std::vector<Eigen::MatrixXd>& local_hessians,
+    Eigen::ConstRef<Eigen::VectorXd> v) const
+{
+    assert(local_hessians.size() == collisions.size());
+    assert(v.size() % mesh.num_vertices() == 0);
+
+    return hessian_vector_product(
+        collisions, v.size() / mesh.num_vertices(), v,
+        [&](size_t i) -> const Eigen::MatrixXd& { return local_hessians[i]; });
+}
 
-    // Prepares for parallel concatenation
-    std::vector<int> offsets(storage.size());
+template <typename LocalHessian>
+Eigen::VectorXd SmoothContactPotential::hessian_vector_product(
+    const SmoothCollisions& collisions,
+    const int dim,
+    Eigen::ConstRef<Eigen::VectorXd> v,
+    LocalHessian&& local_hessian) const
+{
+    if (collisions.empty()) {
+        return Eigen::VectorXd::Zero(v.size());
+    }
 
-    index = 0;
-    int triplet_count = 0;
-    for (auto& local_storage : storage) {
-        offsets[index++] = triplet_count;
-        triplet_count += local_storage.cache->triplet_count();
+    // Use sparse local storage if the collisions touch few of the DOF.
+    size_t max_nonzeros = 0;
+    for (size_t i = 0; i < collisions.size(); i++) {
+        max_nonzeros += collisions[i].n_dofs();
     }
+    auto storage = ipc::utils::create_thread_storage(
+        LocalThreadVecStorage(v.size(), max_nonzeros));
+    ipc::utils::maybe_parallel_for(
+        collisions.size(), [&](int start, int end, int thread_id) {
+            auto& global_hess_v =
+                ipc::utils::get_local_thread_storage(storage, thread_id);
 
-    std::vector<Eigen::Triplet<double>> triplets;
-
-    assert(storages.size() >= 1);
-    if (storages[0]->cache->is_dense()) {
-        // Serially merge local storages
-        Eigen::MatrixXd tmp(hess);
-        for (const auto& local_storage : storage)
-            tmp += dynamic_cast<const DenseMatrixCache&>(*local_storage.cache)
-                       .mat();
-        hess = tmp.sparseView();
-        hess.makeCompressed();
-    } else if (triplet_count >= triplets.max_size()) {
-        // Serial fallback version in case the vector of triplets cannot be
-        // allocated
-
-        logger().warn(
-            "Cannot allocate space for triplets, switching to serial assembly.");
-
-        // Serially merge local storages
-        for (LocalThreadMatStorage& local_storage : storage)
-            hess += local_storage.cache->get_matrix(false); // will also prune
-        hess.makeCompressed();
-    } else {
-        triplets.resize(triplet_count);
-
-        // Parallel copy into triplets
-        utils::maybe_parallel_for(storages.size(), [&](int i) {
-            const SparseMatrixCache& cache =
-                dynamic_cast<const SparseMatrixCache&>(*storages[i]->cache);
-            int offset = offsets[i];
-
-            std::copy(
-                cache.entries().begin(), cache.entries().end(),
-                triplets.begin() + offset);
-            offset += cache.entries().size();
-
-            if (cache.mat().nonZeros() > 0) {
-                int count = 0;
-                for (int k = 0; k < cache.mat().outerSize(); ++k) {
-                    for (Eigen::SparseMatrix<double>::InnerIterator it(
-                             cache.mat(), k);
-                         it; ++it) {
-                        assert(count < cache.mat().nonZeros());
-                        triplets[offset + count++] = Eigen::Triplet<double>(
-                            it.row(), it.col(), it.value());
-                    }
-                }
+            for (size_t i = start; i < end; i++) {
+                local_hessian_vector_product_to_global(
+                    local_hessian(i), collisions[i].vertex_ids(), dim, v,
+                    global_hess_v);
             }
         });
 
-        // Sort and assemble
-        hess.setFromTriplets(triplets.begin(), triplets.end());
-    }
-
-    return hess;
+    Eigen::VectorXd hess_v;
+    hess_v.setZero(v.size());
+    for (const auto& local_storage : storage)
+        local_storage.add_to(hess_v);
+    return hess_v;
 }
 
 double SmoothContactPotential::operator()(
@@ -217,8 +304,21 @@ Eigen::MatrixXd SmoothContactPotential::hessian(
     Eigen::ConstRef<Eigen::VectorXd> positions,
     const PSDProjectionMethod project_hessian_to_psd) const
 {
-    Eigen::MatrixXd hess =
-        collision.weight * collision.hessian(positions, params);
-    return project_to_psd(hess, project_hessian_to_psd);
+    Eigen::MatrixXd hess;
+    hessian(collision, positions, hess, project_hessian_to_psd);
+    return hess;
+}
+
+void SmoothContactPotential::hessian(
+    const SmoothCollision& collision,
+    Eigen::ConstRef<Eigen::VectorXd> positions,
+    Eigen::MatrixXd& hess,
+    const PSDProjectionMethod project_hessian_to_psd) const
+{
+    collision.hessian(positions, params, hess);
+    hess *= collision.weight;
+    if (project_hessian_to_psd != PSDProjectionMethod::NONE) {
+        hess = project_to_psd(hess, project_hessian_to_psd);
+    }
 }
 } // namespace ipc
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <ipc/collision_mesh.hpp>
 #include <ipc/smooth_contact/smooth_collisions.hpp>
 #include <ipc/utils/eigen_ext.hpp>
+#include <ipc/utils/hessian_assembler.hpp>
 
 namespace ipc {
 
@@ -34,6 +35,7 @@ public:
         Eigen::ConstRef<Eigen::MatrixXd> X) const;
 
     /// @brief Compute the hessian of the potential.
+    /// @note The sparsity pattern and coloring are rebuilt on every call. Use the overload taking a HessianAssembler to reuse them.
     /// @param collisions The set of collisions.
     /// @param mesh The collision mesh.
     /// @param X Degrees of freedom of the collision mesh (e.g., vertices or velocities).
@@ -46,6 +48,76 @@ public:
         const PSDProjectionMethod project_hessian_to_psd =
             PSDProjectionMethod::NONE) const;
 
+    /// @brief Compute the hessian of the potential, reusing the sparsity pattern and storage of the previous call.
+    /// @param collisions The set of collisions.
+    /// @param mesh The collision mesh.
+    /// @param X Degrees of freedom of the collision mesh (e.g., vertices or velocities).
+    /// @param[in,out] assembler Persistent assembler storing the sparsity pattern of the previous call.
+    /// @param[in,out] hess The Hessian of the potential w.r.t. X. Its storage is reused and only its values are recomputed if the pattern is unchanged. Zero entries of the pattern are kept.
+    /// @param project_hessian_to_psd Make sure the hessian is positive semi-definite.
+    /// @returns True if the sparsity pattern of hess changed (i.e., a symbolic factorization of hess must be recomputed).
+    bool hessian(
+        const SmoothCollisions& collisions,
+        const CollisionMesh& mesh,
+        Eigen::ConstRef<Eigen::MatrixXd> X,
+        HessianAssembler& assembler,
+        Eigen::SparseMatrix<double>& hess,
+        const PSDProjectionMethod project_hessian_to_psd =
+            PSDProjectionMethod::NONE) const;
+
+    /// @brief Compute the hessian of the potential as dim×dim vertex blocks.
+    /// @param collisions The set of collisions.
+    /// @param mesh The collision mesh.
+    /// @param X Degrees of freedom of the collision mesh (e.g., vertices or velocities).
+    /// @param project_hessian_to_psd Make sure the hessian is positive semi-definite.
+    /// @returns The block sparse Hessian of the potential w.r.t. X. This will have a size of |X|×|X|.
+    BlockSparseMatrix block_hessian(
+        const SmoothCollisions& collisions,
+        const CollisionMesh& mesh,
+        Eigen::ConstRef<Eigen::MatrixXd> X,
+        const PSDProjectionMethod project_hessian_to_psd =
+            PSDProjectionMethod::NONE) const;
+
+    /// @brief Compute the product of the hessian of the potential and a vector without assembling the hessian.
+    /// @param collisions The set of collisions.
+    /// @param mesh The collision mesh.
+    /// @param X Degrees of freedom of the collision mesh (e.g., vertices or velocities).
+    /// @param v Vector to multiply by the hessian. This must have a size of |X|.
+    /// @param project_hessian_to_psd Make sure the hessian is positive semi-definite.
+    /// @returns The product of the Hessian of the potential w.r.t. X and v. This will have a size of |X|.
+    Eigen::VectorXd hessian_vector_product(
+        const SmoothCollisions& collisions,
+        const CollisionMesh& mesh,
+        Eigen::ConstRef<Eigen::MatrixXd> X,
+        Eigen::ConstRef<Eigen::VectorXd> v,
+        const PSDProjectionMethod project_hessian_to_psd =
+            PSDProjectionMethod::NONE) const;
+
+    /// @brief Compute the local hessian of every collision (e.g., to reuse them across several Hessian-vector products).
+    /// @param collisions The set of collisions.
+    /// @param mesh The collision mesh.
+    /// @param X Degrees of freedom of the collision mesh (e.g., vertices or velocities).
+    /// @param project_hessian_to_psd Make sure the hessian is positive semi-definite.
+    /// @returns The local hessian of each collision.
+    std::vector<Eigen::MatrixXd> local_hessians(
+        const SmoothCollisions& collisions,
+        const CollisionMesh& mesh,
+        Eigen::ConstRef<Eigen::MatrixXd> X,
+        const PSDProjectionMethod project_hessian_to_psd =
+            PSDProjectionMethod::NONE) const;
+
+    /// @brief Compute the product of the hessian of the potential and a vector from cached local hessians.
+    /// @param collisions The set of collisions.
+    /// @param mesh The collision mesh.
+    /// @param local_hessians The local hessian of each collision as computed by local_hessians().
+    /// @param v Vector to multiply by the hessian. This must have a size of |X|.
+    /// @returns The product of the Hessian of the potential and v. This will have a size of |X|.
+    Eigen::VectorXd hessian_vector_product(
+        const SmoothCollisions& collisions,
+        const CollisionMesh& mesh,
+        const std::vector<Eigen::MatrixXd>& local_hessians,
+        Eigen::ConstRef<Eigen::VectorXd> v) const;
+
     // -- Single collision methods ---------------------------------------------
 
     /// @brief Compute the potential for a single collision.
@@ -74,7 +146,32 @@ public:
         const PSDProjectionMethod project_hessian_to_psd =
             PSDProjectionMethod::NONE) const;
 
+    /// @brief Compute the hessian of the potential for a single collision into caller-owned storage.
+    /// @param[in] collision The collision.
+    /// @param[in] positions The collision stencil's positions.
+    /// @param[out] hess The hessian of the potential. Its storage is reused if it already has the stencil's size.
+    /// @param[in] project_hessian_to_psd Whether to project the hessian to the positive semi-definite cone.
+    void hessian(
+        const SmoothCollision& collision,
+        Eigen::ConstRef<Eigen::VectorXd> positions,
+        Eigen::MatrixXd& hess,
+        const PSDProjectionMethod project_hessian_to_psd =
+            PSDProjectionMethod::NONE) const;
+
 protected:
+    /// @brief Accumulate the product of the local hessians and a vector.
+    /// @param collisions The set of collisions.
+    /// @param dim Dimension of the degrees of freedom.
+    /// @param v Vector to multiply by the hessian.
+    /// @param local_hessian Function returning the local hessian of the i-th collision.
+    /// @returns The product of the Hessian of the potential and v.
+    template <typename LocalHessian>
+    Eigen::VectorXd hessian_vector_product(
+        const SmoothCollisions& collisions,
+        const int dim,
+        Eigen::ConstRef<Eigen::VectorXd> v,
+        LocalHessian&& local_hessian) const;
+
     ParameterType params;
 };
 
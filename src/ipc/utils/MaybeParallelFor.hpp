@@ -43,6 +43,10 @@ namespace utils {
     inline auto
     create_thread_storage(const LocalStorage& initial_local_storage);
 
+    // Same as above, but each thread's storage is default constructed, so
+    // LocalStorage does not need to be copyable.
+    template <typename LocalStorage> inline auto create_thread_storage();
+
     template <typename Storages>
     inline auto& get_local_thread_storage(Storages& storage, int thread_id);
 } // namespace utils
@@ -60,6 +60,17 @@ namespace utils {
 #endif
     }
 
+    template <typename LocalStorage> inline auto create_thread_storage()
+    {
+#if defined(IPC_TOOLKIT_WITH_CPP_THREADS)
+        return std::vector<LocalStorage>(get_n_threads());
+#elif defined(IPC_TOOLKIT_WITH_TBB)
+        return tbb::enumerable_thread_specific<LocalStorage>();
+#else
+        return std::array<LocalStorage, 1> {};
+#endif
+    }
+
     template <typename Storages>
     inline auto& get_local_thread_storage(Storages& storage, int thread_id)
     {
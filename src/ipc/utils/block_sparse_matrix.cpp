@@ -0,0 +1,153 @@
+#include "block_sparse_matrix.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace ipc {
+
+BlockSparseMatrix::BlockSparseMatrix(
+    const int dim,
+    std::vector<int> outer_indices,
+    std::vector<int> inner_indices)
+    : m_dim(dim)
+    , m_outer_indices(std::move(outer_indices))
+    , m_inner_indices(std::move(inner_indices))
+    , m_values(dim * dim * m_inner_indices.size(), 0.0)
+{
+    assert(!m_outer_indices.empty());
+    assert(m_outer_indices.back() == int(m_inner_indices.size()));
+}
+
+BlockSparseMatrix::BlockSparseMatrix(
+    const Eigen::SparseMatrix<double>& A, const int dim)
+    : m_dim(dim)
+{
+    assert(A.rows() == A.cols());
+    assert(A.rows() % dim == 0);
+
+    const Eigen::SparseMatrix<double, Eigen::RowMajor> A_rows = A;
+    const int n = A.rows() / dim;
+
+    // Block pattern: union of the block columns of the rows in each block row.
+    m_outer_indices.resize(n + 1);
+    std::vector<int> last_block_row(n, -1);
+    for (int i = 0; i < n; i++) {
+        m_outer_indices[i] = m_inner_indices.size();
+        for (int k = 0; k < dim; k++) {
+            for (Eigen::SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(
+                     A_rows, dim * i + k);
+                 it; ++it) {
+                const int j = it.col() / dim;
+                if (last_block_row[j] != i) {
+                    last_block_row[j] = i;
+                    m_inner_indices.push_back(j);
+                }
+            }
+        }
+        std::sort(
+            m_inner_indices.begin() + m_outer_indices[i],
+            m_inner_indices.end());
+    }
+    m_outer_indices[n] = m_inner_indices.size();
+
+    // Values
+    m_values.assign(dim * dim * m_inner_indices.size(), 0.0);
+    for (int i = 0; i < n; i++) {
+        const auto begin = m_inner_indices.begin() + m_outer_indices[i];
+        const auto end = m_inner_indices.begin() + m_outer_indices[i + 1];
+        for (int k = 0; k < dim; k++) {
+            for (Eigen::SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(
+                     A_rows, dim * i + k);
+                 it; ++it) {
+                const int j = it.col() / dim, l = it.col() % dim;
+                const size_t p =
+                    std::lower_bound(begin, end, j) - m_inner_indices.begin();
+                m_values[dim * dim * p + l * dim + k] = it.value();
+            }
+        }
+    }
+}
+
+Eigen::SparseMatrix<double> BlockSparseMatrix::to_sparse() const
+{
+    // Each block row expands to dim scalar rows with dim entries per block,
+    // which is a valid compressed row-major matrix.
+    const int n = num_block_rows();
+    const int dim = m_dim;
+
+    Eigen::SparseMatrix<double, Eigen::RowMajor> A(rows(), cols());
+    A.resizeNonZeros(m_values.size());
+    int* outer = A.outerIndexPtr();
+    int* inner = A.innerIndexPtr();
+    double* values = A.valuePtr();
+
+    tbb::parallel_for(
+        tbb::blocked_range<int>(0, n), [&](const tbb::blocked_range<int>& r) {
+            for (int i = r.begin(); i < r.end(); i++) {
+                const int begin = m_outer_indices[i];
+                const int size = m_outer_indices[i + 1] - begin;
+                for (int k = 0; k < dim; k++) {
+                    int q = dim * dim * begin + k * dim * size;
+                    outer[dim * i + k] = q;
+                    for (int p = begin; p < begin + size; p++) {
+                        for (int l = 0; l < dim; l++) {
+                            inner[q] = dim * m_inner_indices[p] + l;
+                            values[q] = m_values[dim * dim * p + l * dim + k];
+                            q++;
+                        }
+                    }
+                }
+            }
+        });
+    outer[rows()] = m_values.size();
+
+    return Eigen::SparseMatrix<double>(A);
+}
+
+Eigen::VectorXd BlockSparseMatrix::operator*(const Eigen::VectorXd& x) const
+{
+    assert(x.size() == cols());
+
+    Eigen::VectorXd y = Eigen::VectorXd::Zero(rows());
+    switch (m_dim) {
+    case 2:
+        multiply<2>(x, y);
+        break;
+    case 3:
+        multiply<3>(x, y);
+        break;
+    default:
+        multiply<Eigen::Dynamic>(x, y);
+        break;
+    }
+    return y;
+}
+
+template <int Dim>
+void BlockSparseMatrix::multiply(
+    const Eigen::VectorXd& x, Eigen::VectorXd& y) const
+{
+    using Block = Eigen::Matrix<double, Dim, Dim>;
+    using Segment = Eigen::Matrix<double, Dim, 1>;
+
+    tbb::parallel_for(
+        tbb::blocked_range<Eigen::Index>(0, num_block_rows()),
+        [&](const tbb::blocked_range<Eigen::Index>& r) {
+            for (Eigen::Index i = r.begin(); i < r.end(); i++) {
+                Eigen::Map<Segment> yi(y.data() + m_dim * i, m_dim);
+                for (int p = m_outer_indices[i]; p < m_outer_indices[i + 1];
+                     p++) {
+                    const Eigen::Map<const Block> block(
+                        m_values.data() + m_dim * m_dim * p, m_dim, m_dim);
+                    const Eigen::Map<const Segment> xj(
+                        x.data() + m_dim * m_inner_indices[p], m_dim);
+                    yi.noalias() += block * xj;
+                }
+            }
+        });
+}
+
+} // namespace ipc
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+
+#include <vector>
+
+namespace ipc {
+
+/// @brief Square sparse matrix of dim×dim blocks indexed by vertex, stored in
+/// block compressed sparse row (BSR) format.
+///
+/// Each block is stored contiguously in column-major order, so the p-th block
+/// occupies values()[dim²·p, dim²·(p+1)).
+class BlockSparseMatrix {
+public:
+    BlockSparseMatrix() = default;
+
+    /// @brief Construct a matrix with a given block pattern and zero values.
+    /// @param dim Size of the blocks.
+    /// @param outer_indices Start of each block row in inner_indices (size num_block_rows + 1).
+    /// @param inner_indices Sorted block column of each nonzero block.
+    BlockSparseMatrix(
+        const int dim,
+        std::vector<int> outer_indices,
+        std::vector<int> inner_indices);
+
+    /// @brief Convert a scalar sparse matrix to blocks.
+    /// @param A The sparse matrix. Its size must be a multiple of dim.
+    /// @param dim Size of the blocks.
+    BlockSparseMatrix(const Eigen::SparseMatrix<double>& A, const int dim);
+
+    /// @brief Convert to a scalar compressed sparse column matrix.
+    Eigen::SparseMatrix<double> to_sparse() const;
+
+    /// @brief Compute the product of the matrix and a vector.
+    /// @param x Vector of size rows().
+    /// @return The product A·x.
+    Eigen::VectorXd operator*(const Eigen::VectorXd& x) const;
+
+    /// @brief Size of the blocks.
+    int dim() const { return m_dim; }
+
+    /// @brief Number of scalar rows (and columns).
+    Eigen::Index rows() const { return m_dim * num_block_rows(); }
+
+    /// @brief Number of scalar columns (and rows).
+    Eigen::Index cols() const { return rows(); }
+
+    /// @brief Number of block rows (and columns).
+    Eigen::Index num_block_rows() const
+    {
+        return m_outer_indices.empty() ? 0 : (m_outer_indices.size() - 1);
+    }
+
+    /// @brief Number of nonzero blocks.
+    size_t num_blocks() const { return m_inner_indices.size(); }
+
+    /// @brief Get the p-th nonzero block.
+    Eigen::Map<Eigen::MatrixXd> block(const size_t p)
+    {
+        return Eigen::Map<Eigen::MatrixXd>(
+            m_values.data() + m_dim * m_dim * p, m_dim, m_dim);
+    }
+
+    /// @brief Get the p-th nonzero block.
+    Eigen::Map<const Eigen::MatrixXd> block(const size_t p) const
+    {
+        return Eigen::Map<const Eigen::MatrixXd>(
+            m_values.data() + m_dim * m_dim * p, m_dim, m_dim);
+    }
+
+    /// @brief Start of each block row in inner_indices().
+    const std::vector<int>& outer_indices() const { return m_outer_indices; }
+
+    /// @brief Block column of each nonzero block.
+    const std::vector<int>& inner_indices() const { return m_inner_indices; }
+
+    /// @brief Values of all nonzero blocks.
+    const std::vector<double>& values() const { return m_values; }
+
+    /// @brief Values of all nonzero blocks.
+    std::vector<double>& values() { return m_values; }
+
+protected:
+    /// @brief Add the product of this matrix and x to y.
+    /// @tparam Dim Size of the blocks (or Eigen::Dynamic).
+    template <int Dim>
+    void multiply(const Eigen::VectorXd& x, Eigen::VectorXd& y) const;
+
+    /// @brief Size of the blocks.
+    int m_dim = 0;
+    /// @brief Start of each block row in m_inner_indices.
+    std::vector<int> m_outer_indices;
+    /// @brief Block column of each nonzero block.
+    std::vector<int> m_inner_indices;
+    /// @brief Column-major values of each nonzero block.
+    std::vector<double> m_values;
+};
+
+} // namespace ipc
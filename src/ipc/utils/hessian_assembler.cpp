@@ -0,0 +1,251 @@
+#include "hessian_assembler.hpp"
+
+#include <algorithm>
+
+namespace ipc {
+
+void HessianAssembler::init(const size_t _num_vertices, const int _dim)
+{
+    num_vertices = _num_vertices;
+    dim = _dim;
+
+    build_vertex_elements();
+    color_elements();
+    build_pattern();
+    build_element_blocks();
+}
+
+bool HessianAssembler::update(const size_t _num_vertices, const int _dim)
+{
+    const bool same_size = num_vertices == _num_vertices && dim == _dim;
+    prev_block_column_pointers.swap(block_column_pointers);
+    prev_block_rows.swap(block_rows);
+
+    init(_num_vertices, _dim);
+
+    return !same_size || block_column_pointers != prev_block_column_pointers
+        || block_rows != prev_block_rows;
+}
+
+void HessianAssembler::build_vertex_elements()
+{
+    const size_t num_elements = element_vertex_offsets.size() - 1;
+
+    vertex_element_pointers.assign(num_vertices + 1, 0);
+    for (const index_t v : element_vertices) {
+        vertex_element_pointers[v + 1]++;
+    }
+    for (size_t v = 0; v < num_vertices; v++) {
+        vertex_element_pointers[v + 1] += vertex_element_pointers[v];
+    }
+
+    // Fill each vertex's list in increasing element order, using the start of
+    // the next vertex's list as the insertion point and shifting it back.
+    vertex_elements.resize(element_vertices.size());
+    for (size_t i = 0; i < num_elements; i++) {
+        for (size_t j = element_vertex_offsets[i];
+             j < element_vertex_offsets[i + 1]; j++) {
+            vertex_elements[vertex_element_pointers[element_vertices[j]]++] =
+                i;
+        }
+    }
+    for (size_t v = num_vertices; v > 0; v--) {
+        vertex_element_pointers[v] = vertex_element_pointers[v - 1];
+    }
+    vertex_element_pointers[0] = 0;
+}
+
+void HessianAssembler::color_elements()
+{
+    const size_t num_elements = element_vertex_offsets.size() - 1;
+
+    // Last element for which each color was marked as unavailable.
+    color_forbidden_by.clear();
+    element_colors.resize(num_elements);
+
+    for (size_t i = 0; i < num_elements; i++) {
+        // Forbid the colors of the previous elements sharing a vertex.
+        for (size_t j = element_vertex_offsets[i];
+             j < element_vertex_offsets[i + 1]; j++) {
+            const index_t v = element_vertices[j];
+            for (size_t k = vertex_element_pointers[v];
+                 k < vertex_element_pointers[v + 1] && vertex_elements[k] < i;
+                 k++) {
+                color_forbidden_by[element_colors[vertex_elements[k]]] = i;
+            }
+        }
+
+        int color = 0;
+        while (color < int(color_forbidden_by.size())
+               && color_forbidden_by[color] == i) {
+            color++;
+        }
+        if (color == int(color_forbidden_by.size())) {
+            color_forbidden_by.push_back(num_elements);
+        }
+        element_colors[i] = color;
+    }
+
+    // Group the elements by color.
+    color_pointers.assign(color_forbidden_by.size() + 1, 0);
+    for (const int c : element_colors) {
+        color_pointers[c + 1]++;
+    }
+    for (size_t c = 0; c + 1 < color_pointers.size(); c++) {
+        color_pointers[c + 1] += color_pointers[c];
+    }
+    colored_elements.resize(num_elements);
+    for (size_t i = 0; i < num_elements; i++) {
+        colored_elements[color_pointers[element_colors[i]]++] = i;
+    }
+    for (size_t c = color_pointers.size() - 1; c > 0; c--) {
+        color_pointers[c] = color_pointers[c - 1];
+    }
+    color_pointers[0] = 0;
+}
+
+void HessianAssembler::build_pattern()
+{
+    // The block rows of column j are the vertices of the elements incident on
+    // j. Gather them into a segment of column_rows sized for all of them, and
+    // sort and deduplicate each segment in parallel.
+    column_rows_pointers.resize(num_vertices + 1);
+    column_rows_pointers[0] = 0;
+    for (size_t j = 0; j < num_vertices; j++) {
+        size_t n = 0;
+        for (size_t k = vertex_element_pointers[j];
+             k < vertex_element_pointers[j + 1]; k++) {
+            const size_t i = vertex_elements[k];
+            n += element_vertex_offsets[i + 1] - element_vertex_offsets[i];
+        }
+        column_rows_pointers[j + 1] = column_rows_pointers[j] + n;
+    }
+    column_rows.resize(column_rows_pointers.back());
+
+    block_column_pointers.resize(num_vertices + 1);
+    block_column_pointers[0] = 0;
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), num_vertices),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t j = r.begin(); j < r.end(); j++) {
+                const auto begin =
+                    column_rows.begin() + column_rows_pointers[j];
+                auto end = begin;
+                for (size_t k = vertex_element_pointers[j];
+                     k < vertex_element_pointers[j + 1]; k++) {
+                    const size_t i = vertex_elements[k];
+                    end = std::copy(
+                        element_vertices.begin() + element_vertex_offsets[i],
+                        element_vertices.begin()
+                            + element_vertex_offsets[i + 1],
+                        end);
+                }
+                std::sort(begin, end);
+                block_column_pointers[j + 1] =
+                    std::unique(begin, end) - begin;
+            }
+        });
+
+    // Block CSC pattern
+    for (size_t j = 0; j < num_vertices; j++) {
+        block_column_pointers[j + 1] += block_column_pointers[j];
+    }
+    block_rows.resize(block_column_pointers.back());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), num_vertices),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t j = r.begin(); j < r.end(); j++) {
+                std::copy_n(
+                    column_rows.begin() + column_rows_pointers[j],
+                    block_column_size(j),
+                    block_rows.begin() + block_column_pointers[j]);
+            }
+        });
+
+    // Scalar CSC pattern: each block column j expands to dim columns, each
+    // with dim rows per nonzero block.
+    const size_t ndof = dim * num_vertices;
+    outer_indices.resize(ndof + 1);
+    inner_indices.resize(dim * dim * block_rows.size());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), num_vertices),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t j = r.begin(); j < r.end(); j++) {
+                const size_t begin = block_column_pointers[j];
+                const size_t n = block_column_size(j);
+                for (int l = 0; l < dim; l++) {
+                    size_t k = dim * dim * begin + l * dim * n;
+                    outer_indices[dim * j + l] = k;
+                    for (size_t p = begin; p < begin + n; p++) {
+                        for (int d = 0; d < dim; d++) {
+                            inner_indices[k++] = dim * block_rows[p] + d;
+                        }
+                    }
+                }
+            }
+        });
+    outer_indices[ndof] = inner_indices.size();
+}
+
+void HessianAssembler::build_element_blocks()
+{
+    const size_t num_elements = element_vertex_offsets.size() - 1;
+
+    element_blocks_pointers.resize(num_elements + 1);
+    element_blocks_pointers[0] = 0;
+    for (size_t i = 0; i < num_elements; i++) {
+        const size_t n =
+            element_vertex_offsets[i + 1] - element_vertex_offsets[i];
+        element_blocks_pointers[i + 1] = element_blocks_pointers[i] + n * n;
+    }
+
+    element_blocks.resize(element_blocks_pointers.back());
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(size_t(0), num_elements),
+        [&](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); i++) {
+                const index_t* vids =
+                    element_vertices.data() + element_vertex_offsets[i];
+                const size_t n =
+                    element_vertex_offsets[i + 1] - element_vertex_offsets[i];
+                size_t k = element_blocks_start(i);
+                for (size_t b = 0; b < n; b++) {
+                    const auto begin =
+                        block_rows.begin() + block_column_pointers[vids[b]];
+                    const auto end =
+                        block_rows.begin() + block_column_pointers[vids[b] + 1];
+                    for (size_t a = 0; a < n; a++) {
+                        const auto it = std::lower_bound(begin, end, vids[a]);
+                        assert(it != end && *it == vids[a]);
+                        element_blocks[k++] = it - block_rows.begin();
+                    }
+                }
+            }
+        });
+}
+
+void HessianAssembler::reset(Eigen::SparseMatrix<double>& hess) const
+{
+    const int ndof = dim * num_vertices;
+    if (hess.rows() != ndof || hess.cols() != ndof || !hess.isCompressed()
+        || size_t(hess.nonZeros()) != inner_indices.size()) {
+        hess.resize(ndof, ndof);
+        hess.resizeNonZeros(inner_indices.size());
+    }
+    std::copy(
+        outer_indices.begin(), outer_indices.end(), hess.outerIndexPtr());
+    std::copy(
+        inner_indices.begin(), inner_indices.end(), hess.innerIndexPtr());
+    std::fill_n(hess.valuePtr(), inner_indices.size(), 0.0);
+}
+
+BlockSparseMatrix HessianAssembler::allocate_blocks() const
+{
+    return BlockSparseMatrix(
+        dim,
+        std::vector<int>(
+            block_column_pointers.begin(), block_column_pointers.end()),
+        std::vector<int>(block_rows.begin(), block_rows.end()));
+}
+
+} // namespace ipc
@@ -0,0 +1,338 @@
+#pragma once
+
+#include <ipc/config.hpp>
+#include <ipc/utils/block_sparse_matrix.hpp>
+
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <vector>
+
+namespace ipc {
+
+/// @brief Assembles element (e.g., collision) Hessians into a global sparse
+/// matrix without building and sorting triplets.
+///
+/// The block sparsity pattern is computed from the vertices of the elements
+/// and the elements are colored so that no two elements of the same color
+/// share a vertex. The elements of each color are then added in parallel
+/// directly into the compressed value array of the matrix.
+///
+/// The pattern contains every block of every element, even if its values are
+/// zero, so it only depends on which vertices the elements share. The buffers
+/// used to build it are kept and reused by the next update.
+class HessianAssembler {
+public:
+    HessianAssembler() = default;
+
+    /// @brief Compute the sparsity pattern and coloring of a set of elements.
+    /// @param num_elements Number of elements.
+    /// @param num_vertices Number of vertices (the matrix is dim·num_vertices × dim·num_vertices).
+    /// @param dim Dimension of the vertices.
+    /// @param element_vertex_ids Function returning the vertex ids of the i-th element in the order of its local Hessian.
+    /// @param element_num_vertices Function returning the number of vertices of the i-th element.
+    template <typename VertexIDs, typename NumVertices>
+    void init(
+        const size_t num_elements,
+        const size_t num_vertices,
+        const int dim,
+        VertexIDs&& element_vertex_ids,
+        NumVertices&& element_num_vertices)
+    {
+        set_element_vertices(
+            num_elements, element_vertex_ids, element_num_vertices);
+        init(num_vertices, dim);
+    }
+
+    /// @brief Update the sparsity pattern and coloring for a new set of elements.
+    ///
+    /// If the elements are the same as in the previous call, nothing is
+    /// recomputed. Otherwise the coloring is recomputed and the returned flag
+    /// tells whether the block sparsity pattern differs from the previous one
+    /// (e.g., to decide if a symbolic factorization can be reused).
+    /// @param num_elements Number of elements.
+    /// @param num_vertices Number of vertices (the matrix is dim·num_vertices × dim·num_vertices).
+    /// @param dim Dimension of the vertices.
+    /// @param element_vertex_ids Function returning the vertex ids of the i-th element in the order of its local Hessian.
+    /// @param element_num_vertices Function returning the number of vertices of the i-th element.
+    /// @return True if the sparsity pattern changed.
+    template <typename VertexIDs, typename NumVertices>
+    bool update(
+        const size_t num_elements,
+        const size_t num_vertices,
+        const int dim,
+        VertexIDs&& element_vertex_ids,
+        NumVertices&& element_num_vertices)
+    {
+        prev_element_vertices.swap(element_vertices);
+        prev_element_vertex_offsets.swap(element_vertex_offsets);
+
+        set_element_vertices(
+            num_elements, element_vertex_ids, element_num_vertices);
+
+        if (num_vertices == this->num_vertices && dim == this->dim
+            && element_vertex_offsets == prev_element_vertex_offsets
+            && element_vertices == prev_element_vertices) {
+            return false;
+        }
+
+        return update(num_vertices, dim);
+    }
+
+    /// @brief Assemble the global matrix.
+    ///
+    /// Entries that are exactly zero are pruned, as they would be when
+    /// assembling from triplets.
+    /// @param local_hessian Function returning the local Hessian of the i-th element.
+    /// @return The assembled sparse matrix.
+    template <typename LocalHessian>
+    Eigen::SparseMatrix<double> assemble(LocalHessian&& local_hessian) const
+    {
+        Eigen::SparseMatrix<double> hess;
+        assemble(local_hessian, hess);
+        hess.prune(0.0);
+        return hess;
+    }
+
+    /// @brief Assemble the global matrix into an existing matrix.
+    ///
+    /// If hess already has this pattern's size and number of nonzeros, its
+    /// storage is reused and only the values are recomputed. Zero entries are
+    /// kept so that the structure of hess is the full pattern.
+    /// @param local_hessian Function returning the local Hessian of the i-th element.
+    /// @param[in,out] hess The assembled sparse matrix.
+    template <typename LocalHessian>
+    void assemble(
+        LocalHessian&& local_hessian, Eigen::SparseMatrix<double>& hess) const
+    {
+        reset(hess);
+        for (size_t c = 0; c < num_colors(); c++) {
+            // Elements of the same color write to disjoint blocks.
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(
+                    color_pointers[c], color_pointers[c + 1]),
+                [&](const tbb::blocked_range<size_t>& r) {
+                    for (size_t ci = r.begin(); ci < r.end(); ci++) {
+                        const size_t i = colored_elements[ci];
+                        add_local_hessian(i, local_hessian(i), hess.valuePtr());
+                    }
+                });
+        }
+    }
+
+    /// @brief Assemble the global matrix as dim×dim blocks.
+    /// @note Zero blocks of the pattern are stored.
+    /// @param local_hessian Function returning the local Hessian of the i-th element.
+    /// @return The assembled block sparse matrix.
+    template <typename LocalHessian>
+    BlockSparseMatrix assemble_blocks(LocalHessian&& local_hessian) const
+    {
+        BlockSparseMatrix hess = allocate_blocks();
+        for (size_t c = 0; c < num_colors(); c++) {
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(
+                    color_pointers[c], color_pointers[c + 1]),
+                [&](const tbb::blocked_range<size_t>& r) {
+                    for (size_t ci = r.begin(); ci < r.end(); ci++) {
+                        const size_t i = colored_elements[ci];
+                        add_local_hessian_blocks(
+                            i, local_hessian(i), hess.values().data());
+                    }
+                });
+        }
+        return hess;
+    }
+
+    /// @brief Number of colors.
+    size_t num_colors() const { return color_pointers.size() - 1; }
+
+    /// @brief Number of structural nonzeros of the full pattern.
+    size_t nnz() const { return inner_indices.size(); }
+
+protected:
+    /// @brief Store the vertices of all elements contiguously.
+    template <typename VertexIDs, typename NumVertices>
+    void set_element_vertices(
+        const size_t num_elements,
+        VertexIDs&& element_vertex_ids,
+        NumVertices&& element_num_vertices)
+    {
+        element_vertex_offsets.resize(num_elements + 1);
+        element_vertex_offsets[0] = 0;
+        for (size_t i = 0; i < num_elements; i++) {
+            element_vertex_offsets[i + 1] =
+                element_vertex_offsets[i] + element_num_vertices(i);
+        }
+
+        element_vertices.resize(element_vertex_offsets.back());
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(size_t(0), num_elements),
+            [&](const tbb::blocked_range<size_t>& r) {
+                for (size_t i = r.begin(); i < r.end(); i++) {
+                    const auto ids = element_vertex_ids(i);
+                    for (size_t j = element_vertex_offsets[i];
+                         j < element_vertex_offsets[i + 1]; j++) {
+                        element_vertices[j] =
+                            ids[j - element_vertex_offsets[i]];
+                    }
+                }
+            });
+    }
+
+    /// @brief Build the pattern and coloring from element_vertices.
+    void init(const size_t num_vertices, const int dim);
+
+    /// @brief Rebuild the pattern and coloring from element_vertices.
+    /// @return True if the block sparsity pattern changed.
+    bool update(const size_t num_vertices, const int dim);
+
+    /// @brief List the elements incident on each vertex.
+    void build_vertex_elements();
+
+    /// @brief Greedily color the elements so that no two elements of the
+    /// same color share a vertex.
+    void color_elements();
+
+    /// @brief Compute the block sparsity pattern of the elements.
+    void build_pattern();
+
+    /// @brief Compute the location of each element's blocks in the pattern.
+    void build_element_blocks();
+
+    /// @brief Set a matrix to the pattern with zero values, reusing its
+    /// storage when the number of nonzeros matches.
+    void reset(Eigen::SparseMatrix<double>& hess) const;
+
+    /// @brief Allocate a block matrix with the pattern and zero values.
+    BlockSparseMatrix allocate_blocks() const;
+
+    /// @brief Add the local Hessian of the i-th element to the value array.
+    template <typename Derived>
+    void add_local_hessian(
+        const size_t i,
+        const Eigen::MatrixBase<Derived>& local_hessian,
+        double* values) const
+    {
+        const size_t n =
+            element_vertex_offsets[i + 1] - element_vertex_offsets[i];
+        assert(local_hessian.rows() == dim * n);
+        assert(local_hessian.cols() == dim * n);
+
+        const size_t* blocks =
+            element_blocks.data() + element_blocks_start(i);
+        for (size_t b = 0; b < n; b++) {
+            const index_t vb = element_vertices[element_vertex_offsets[i] + b];
+            const size_t begin = block_column_pointers[vb];
+            const size_t stride = dim * block_column_size(vb);
+            for (size_t a = 0; a < n; a++) {
+                double* block = values + dim * dim * begin
+                    + dim * (blocks[b * n + a] - begin);
+                for (int l = 0; l < dim; l++) {
+                    for (int k = 0; k < dim; k++) {
+                        block[l * stride + k] +=
+                            local_hessian(dim * a + k, dim * b + l);
+                    }
+                }
+            }
+        }
+    }
+
+    /// @brief Add the local Hessian of the i-th element to the block values.
+    template <typename Derived>
+    void add_local_hessian_blocks(
+        const size_t i,
+        const Eigen::MatrixBase<Derived>& local_hessian,
+        double* values) const
+    {
+        const size_t n =
+            element_vertex_offsets[i + 1] - element_vertex_offsets[i];
+        assert(local_hessian.rows() == dim * n);
+        assert(local_hessian.cols() == dim * n);
+
+        // The pattern is symmetric, so block row a of the BSR matrix has the
+        // same layout as block column a of the CSC pattern.
+        const size_t* blocks =
+            element_blocks.data() + element_blocks_start(i);
+        for (size_t a = 0; a < n; a++) {
+            for (size_t b = 0; b < n; b++) {
+                double* block = values + dim * dim * blocks[a * n + b];
+                for (int l = 0; l < dim; l++) {
+                    for (int k = 0; k < dim; k++) {
+                        block[l * dim + k] +=
+                            local_hessian(dim * a + k, dim * b + l);
+                    }
+                }
+            }
+        }
+    }
+
+    /// @brief Number of nonzero blocks in the j-th block column.
+    size_t block_column_size(const index_t j) const
+    {
+        return block_column_pointers[j + 1] - block_column_pointers[j];
+    }
+
+    /// @brief Start of the i-th element's entries in element_blocks.
+    size_t element_blocks_start(const size_t i) const
+    {
+        return element_blocks_pointers[i];
+    }
+
+    /// @brief Dimension of the vertices.
+    int dim = 0;
+    /// @brief Number of vertices.
+    size_t num_vertices = 0;
+
+    /// @brief Vertices of all elements stored contiguously.
+    std::vector<index_t> element_vertices;
+    /// @brief Start of each element's vertices in element_vertices.
+    std::vector<size_t> element_vertex_offsets;
+
+    /// @brief Start of each block column in block_rows (block CSC).
+    std::vector<size_t> block_column_pointers;
+    /// @brief Block row (vertex) of each nonzero block.
+    std::vector<index_t> block_rows;
+
+    /// @brief Outer index array of the scalar CSC matrix.
+    std::vector<int> outer_indices;
+    /// @brief Inner index array of the scalar CSC matrix.
+    std::vector<int> inner_indices;
+
+    /// @brief Index in block_rows of each (a, b) block of each element.
+    std::vector<size_t> element_blocks;
+    /// @brief Start of each element's blocks in element_blocks.
+    std::vector<size_t> element_blocks_pointers;
+
+    /// @brief Elements sorted by color.
+    std::vector<size_t> colored_elements;
+    /// @brief Start of each color in colored_elements.
+    std::vector<size_t> color_pointers = { 0 };
+
+    // Scratch buffers reused between updates
+
+    /// @brief Elements incident on each vertex in increasing order.
+    std::vector<size_t> vertex_elements;
+    /// @brief Start of each vertex's elements in vertex_elements.
+    std::vector<size_t> vertex_element_pointers;
+    /// @brief Color of each element.
+    std::vector<int> element_colors;
+    /// @brief Last element for which each color was unavailable.
+    std::vector<size_t> color_forbidden_by;
+    /// @brief Unsorted block rows of each column with duplicates.
+    std::vector<index_t> column_rows;
+    /// @brief Start of each column's segment in column_rows.
+    std::vector<size_t> column_rows_pointers;
+    /// @brief Element vertices of the previous update.
+    std::vector<index_t> prev_element_vertices;
+    /// @brief Element vertex offsets of the previous update.
+    std::vector<size_t> prev_element_vertex_offsets;
+    /// @brief Block column pointers of the previous update.
+    std::vector<size_t> prev_block_column_pointers;
+    /// @brief Block rows of the previous update.
+    std::vector<index_t> prev_block_rows;
+};
+
+} // namespace ipc
@@ -41,6 +41,82 @@ void local_gradient_to_global_gradient(
     }
 }
 
+/// @brief Thread-local storage for accumulating a global vector (e.g., a gradient).
+///
+/// If only a small fraction of the entries can be touched, they are stored as
+/// sparse (index, value) pairs instead of in a dense vector. This avoids
+/// O(threads × size) memory and work when the local storages are summed.
+class LocalThreadVecStorage {
+public:
+    /// @brief Maximum fraction of touched entries for which sparse storage is used.
+    static constexpr double MAX_SPARSE_DENSITY = 0.25;
+
+    LocalThreadVecStorage() = delete;
+
+    /// @brief Construct an empty local storage.
+    /// @param size Size of the global vector.
+    /// @param max_nonzeros Upper bound on the number of entries that will be added.
+    LocalThreadVecStorage(const int size, const size_t max_nonzeros)
+        : m_is_sparse(max_nonzeros < MAX_SPARSE_DENSITY * size)
+    {
+        if (!m_is_sparse) {
+            dense.setZero(size);
+        }
+    }
+
+    /// @brief Add a value to the i-th entry.
+    void add(const int i, const double value)
+    {
+        if (m_is_sparse) {
+            if (value != 0) {
+                entries.emplace_back(i, value);
+            }
+        } else {
+            dense[i] += value;
+        }
+    }
+
+    /// @brief Add the accumulated entries to a global vector.
+    void add_to(Eigen::Ref<Eigen::VectorXd> out) const
+    {
+        if (m_is_sparse) {
+            for (const auto& [i, value] : entries) {
+                out[i] += value;
+            }
+        } else {
+            out += dense;
+        }
+    }
+
+    /// @brief Are the entries stored sparsely?
+    bool is_sparse() const { return m_is_sparse; }
+
+    /// @brief Dense storage (only used if not sparse).
+    Eigen::VectorXd dense;
+    /// @brief Sparse storage (only used if sparse).
+    std::vector<std::pair<int, double>> entries;
+
+private:
+    bool m_is_sparse;
+};
+
+template <typename IDContainer>
+void local_gradient_to_global_gradient(
+    Eigen::ConstRef<Eigen::VectorXd> local_grad,
+    const IDContainer& ids,
+    const int dim,
+    LocalThreadVecStorage& grad)
+{
+    assert(local_grad.size() % dim == 0);
+    const int n_verts = local_grad.size() / dim;
+    assert(ids.size() >= n_verts); // Can be extra ids
+    for (int i = 0; i < n_verts; i++) {
+        for (int d = 0; d < dim; d++) {
+            grad.add(dim * ids[i] + d, local_grad(dim * i + d));
+        }
+    }
+}
+
 template <typename IDContainer>
 void local_hessian_to_global_triplets(
     Eigen::ConstRef<Eigen::MatrixXd> local_hessian,
@@ -65,6 +141,37 @@ void local_hessian_to_global_triplets(
     }
 }
 
+/// @brief Add the product of a local hessian and the entries of a global vector
+/// at the local vertices to thread-local storage.
+/// @param local_hessian The local hessian.
+/// @param ids The global vertex ids of the local vertices.
+/// @param dim Dimension of the vertices.
+/// @param v The global vector to multiply.
+/// @param out Thread-local storage of the global product.
+template <typename Derived, typename IDContainer>
+void local_hessian_vector_product_to_global(
+    const Eigen::MatrixBase<Derived>& local_hessian,
+    const IDContainer& ids,
+    const int dim,
+    Eigen::ConstRef<Eigen::VectorXd> v,
+    LocalThreadVecStorage& out)
+{
+    assert(local_hessian.rows() == local_hessian.cols());
+    assert(local_hessian.rows() % dim == 0);
+    const int n_verts = local_hessian.rows() / dim;
+    assert(ids.size() >= n_verts); // Can be extra ids
+
+    Eigen::Matrix<
+        double, Derived::ColsAtCompileTime, 1, Eigen::ColMajor,
+        Derived::MaxColsAtCompileTime, 1>
+        local_v(local_hessian.cols());
+    for (int i = 0; i < n_verts; i++) {
+        local_v.segment(dim * i, dim) = v.segment(dim * ids[i], dim);
+    }
+
+    local_gradient_to_global_gradient(local_hessian * local_v, ids, dim, out);
+}
+
 template <typename Derived, typename IDContainer1, typename IDContainer2>
 void local_jacobian_to_global_triplets(
     const Eigen::MatrixBase<Derived>& local_jacobian,
@@ -1,5 +1,6 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
+#include <catch2/generators/catch_generators.hpp>
 
 #include <ipc/broad_phase/aabb.hpp>
 
@@ -104,3 +105,61 @@ TEST_CASE("AABB overlapping", "[broad_phase][AABB]")
     }
     CHECK(a.intersects(b) == are_overlapping);
 }
+
+TEST_CASE("Packed AABBs", "[broad_phase][AABB]")
+{
+    const int dim = GENERATE(2, 3);
+    const double inflation_radius = GENERATE(0.0, 1e-2);
+
+    const Eigen::MatrixXd V0 = Eigen::MatrixXd::Random(100, dim);
+    const Eigen::MatrixXd V1 = V0 + 0.1 * Eigen::MatrixXd::Random(100, dim);
+    Eigen::MatrixXi E(99, 2), F(98, 3);
+    for (int i = 0; i < E.rows(); i++) {
+        E.row(i) << i, i + 1;
+    }
+    for (int i = 0; i < F.rows(); i++) {
+        F.row(i) << i, i + 1, i + 2;
+    }
+
+    std::vector<AABB> vertex_boxes, edge_boxes, face_boxes;
+    build_vertex_boxes(V0, V1, vertex_boxes, inflation_radius);
+    build_edge_boxes(vertex_boxes, E, edge_boxes);
+    build_face_boxes(vertex_boxes, F, face_boxes);
+
+    AABBs packed_vertex_boxes, packed_edge_boxes, packed_face_boxes;
+    build_vertex_boxes(V0, V1, packed_vertex_boxes, inflation_radius);
+    build_edge_boxes(packed_vertex_boxes, E, packed_edge_boxes);
+    build_face_boxes(packed_vertex_boxes, F, packed_face_boxes);
+
+    const auto check_equal = [](const std::vector<AABB>& boxes,
+                                const AABBs& packed_boxes) {
+        REQUIRE(boxes.size() == packed_boxes.size());
+        for (size_t i = 0; i < boxes.size(); i++) {
+            const AABB box = packed_boxes[i];
+            CHECK((box.min == boxes[i].min).all());
+            CHECK((box.max == boxes[i].max).all());
+            CHECK(box.vertex_ids == boxes[i].vertex_ids);
+        }
+    };
+    check_equal(vertex_boxes, packed_vertex_boxes);
+    check_equal(edge_boxes, packed_edge_boxes);
+    check_equal(face_boxes, packed_face_boxes);
+
+    std::vector<size_t> hits;
+    for (size_t i = 0; i < edge_boxes.size(); i++) {
+        hits.clear();
+        packed_face_boxes.intersect_range(
+            packed_edge_boxes, i, 0, packed_face_boxes.size(), hits);
+
+        std::vector<size_t> expected_hits;
+        for (size_t j = 0; j < face_boxes.size(); j++) {
+            if (edge_boxes[i].intersects(face_boxes[j])) {
+                expected_hits.push_back(j);
+            }
+            CHECK(
+                packed_edge_boxes.intersects(i, packed_face_boxes, j)
+                == edge_boxes[i].intersects(face_boxes[j]));
+        }
+        CHECK(hits == expected_hits);
+    }
+}
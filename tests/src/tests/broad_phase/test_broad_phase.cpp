@@ -3,6 +3,7 @@
 #include <tests/utils.hpp>
 
 #include <ipc/broad_phase/brute_force.hpp>
+#include <ipc/broad_phase/bvh.hpp>
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators.hpp>
@@ -10,6 +11,8 @@
 #include <igl/readCSV.h>
 #include <igl/readDMAT.h>
 
+#include <mutex>
+
 using namespace ipc;
 
 void test_face_face_broad_phase(
@@ -250,6 +253,89 @@ TEST_CASE("Compare BP against brute force", "[broad_phase]")
     }
 }
 
+TEST_CASE("BVH refit", "[broad_phase][bvh]")
+{
+    Eigen::MatrixXd V0;
+    Eigen::MatrixXi E, F;
+    REQUIRE(tests::load_mesh("bunny.ply", V0, E, F));
+
+    const double inflation_radius = 1e-3;
+    const double displacement = GENERATE(1e-4, 1e-2, 1.0);
+    CAPTURE(displacement);
+
+    BVH bvh;
+    bvh.build(V0, E, F, inflation_radius);
+
+    const Eigen::MatrixXd V1 =
+        V0 + displacement * Eigen::MatrixXd::Random(V0.rows(), V0.cols());
+    bvh.update(V1, E, F, inflation_radius);
+
+    BruteForce bf;
+    bf.build(V1, E, F, inflation_radius);
+
+    std::vector<EdgeEdgeCandidate> ee_candidates, bf_ee_candidates;
+    bvh.detect_edge_edge_candidates(ee_candidates);
+    bf.detect_edge_edge_candidates(bf_ee_candidates);
+    std::sort(ee_candidates.begin(), ee_candidates.end());
+    std::sort(bf_ee_candidates.begin(), bf_ee_candidates.end());
+    CHECK(ee_candidates == bf_ee_candidates);
+
+    std::vector<FaceVertexCandidate> fv_candidates, bf_fv_candidates;
+    bvh.detect_face_vertex_candidates(fv_candidates);
+    bf.detect_face_vertex_candidates(bf_fv_candidates);
+    std::sort(fv_candidates.begin(), fv_candidates.end());
+    std::sort(bf_fv_candidates.begin(), bf_fv_candidates.end());
+    CHECK(fv_candidates == bf_fv_candidates);
+}
+
+TEST_CASE("Streamed candidates", "[broad_phase]")
+{
+    Eigen::MatrixXd V0;
+    Eigen::MatrixXi E, F;
+    REQUIRE(tests::load_mesh("bunny.ply", V0, E, F));
+
+    const Eigen::MatrixXd V1 =
+        V0 + 1e-2 * Eigen::MatrixXd::Random(V0.rows(), V0.cols());
+
+    const auto broad_phase = GENERATE(tests::BroadPhaseGenerator::create());
+    CAPTURE(broad_phase->name());
+    broad_phase->build(V0, V1, E, F);
+
+    constexpr size_t tile_size = 64;
+    std::mutex mutex;
+    size_t max_tile_size = 0; // Catch2 assertions are not thread-safe
+
+    std::vector<EdgeEdgeCandidate> ee_candidates, streamed_ee_candidates;
+    broad_phase->detect_edge_edge_candidates(ee_candidates);
+    broad_phase->stream_edge_edge_candidates(
+        [&](const std::vector<EdgeEdgeCandidate>& tile) {
+            std::scoped_lock lock(mutex);
+            max_tile_size = std::max(max_tile_size, tile.size());
+            streamed_ee_candidates.insert(
+                streamed_ee_candidates.end(), tile.begin(), tile.end());
+        },
+        tile_size);
+    std::sort(ee_candidates.begin(), ee_candidates.end());
+    std::sort(streamed_ee_candidates.begin(), streamed_ee_candidates.end());
+    CHECK(ee_candidates == streamed_ee_candidates);
+
+    std::vector<FaceVertexCandidate> fv_candidates, streamed_fv_candidates;
+    broad_phase->detect_face_vertex_candidates(fv_candidates);
+    broad_phase->stream_face_vertex_candidates(
+        [&](const std::vector<FaceVertexCandidate>& tile) {
+            std::scoped_lock lock(mutex);
+            max_tile_size = std::max(max_tile_size, tile.size());
+            streamed_fv_candidates.insert(
+                streamed_fv_candidates.end(), tile.begin(), tile.end());
+        },
+        tile_size);
+    std::sort(fv_candidates.begin(), fv_candidates.end());
+    std::sort(streamed_fv_candidates.begin(), streamed_fv_candidates.end());
+    CHECK(fv_candidates == streamed_fv_candidates);
+
+    CHECK(max_tile_size <= tile_size);
+}
+
 TEST_CASE("Cloth-Ball", "[ccd][broad_phase][cloth-ball][.]")
 {
     Eigen::MatrixXd V0, V1;
@@ -1,8 +1,14 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <tests/utils.hpp>
+
+#include <ipc/broad_phase/brute_force.hpp>
 #include <ipc/candidates/candidates.hpp>
 #include <ipc/candidates/edge_face.hpp>
 #include <ipc/candidates/face_face.hpp>
+#include <ipc/collision_mesh.hpp>
+
+#include <algorithm>
 
 using namespace ipc;
 
@@ -74,6 +80,117 @@ TEST_CASE("Candidates", "[candidates]")
     }
 }
 
+TEST_CASE("Candidates temporal coherence", "[candidates]")
+{
+    Eigen::MatrixXd V;
+    Eigen::MatrixXi E, F;
+    REQUIRE(tests::load_mesh("two-cubes-close.ply", V, E, F));
+    const CollisionMesh mesh = CollisionMesh::build_from_full_mesh(V, E, F);
+    V = mesh.vertices(V);
+
+    const double inflation_radius = 1e-3;
+    const double safety_margin = 1e-2;
+
+    Candidates candidates;
+    candidates.set_safety_margin(safety_margin);
+    CHECK(candidates.safety_margin() == safety_margin);
+    candidates.build(mesh, V, inflation_radius);
+    const std::vector<EdgeEdgeCandidate> ee_candidates =
+        candidates.ee_candidates;
+    const size_t num_candidates = candidates.size();
+
+    const auto sorted = [](auto c) {
+        std::sort(c.begin(), c.end());
+        return c;
+    };
+
+    SECTION("Small displacement reuses the candidates")
+    {
+        const Eigen::MatrixXd V1 = V
+            + 0.5 * safety_margin * Eigen::MatrixXd::Random(V.rows(), V.cols());
+        candidates.build(mesh, V1, inflation_radius);
+        CHECK(candidates.size() == num_candidates);
+        CHECK(candidates.ee_candidates == ee_candidates);
+
+        Candidates expected;
+        expected.build(mesh, V1, inflation_radius);
+
+        const auto ee = sorted(candidates.ee_candidates);
+        const auto expected_ee = sorted(expected.ee_candidates);
+        CHECK(std::includes(
+            ee.begin(), ee.end(), expected_ee.begin(), expected_ee.end()));
+
+        const auto fv = sorted(candidates.fv_candidates);
+        const auto expected_fv = sorted(expected.fv_candidates);
+        CHECK(std::includes(
+            fv.begin(), fv.end(), expected_fv.begin(), expected_fv.end()));
+    }
+
+    SECTION("Large displacement rebuilds the candidates")
+    {
+        Eigen::MatrixXd V1 = V;
+        V1.col(0).array() += 2 * safety_margin;
+        V1(0, 1) += 2 * safety_margin;
+        candidates.build(mesh, V1, inflation_radius);
+
+        Candidates expected;
+        expected.build(mesh, V1, inflation_radius + safety_margin);
+        CHECK(
+            sorted(candidates.vv_candidates)
+            == sorted(expected.vv_candidates));
+        CHECK(
+            sorted(candidates.ev_candidates)
+            == sorted(expected.ev_candidates));
+        CHECK(
+            sorted(candidates.ee_candidates)
+            == sorted(expected.ee_candidates));
+        CHECK(
+            sorted(candidates.fv_candidates)
+            == sorted(expected.fv_candidates));
+    }
+
+    SECTION("Changed topology or broad phase rebuilds the candidates")
+    {
+        // Remove candidates to tell whether they are reused or rebuilt.
+        candidates.ee_candidates.clear();
+        candidates.build(mesh, V, inflation_radius);
+        CHECK(candidates.ee_candidates.empty());
+
+        CollisionMesh build_mesh = mesh;
+        std::shared_ptr<BroadPhase> broad_phase = make_default_broad_phase();
+        SECTION("Topology")
+        {
+            // Same vertices and edges but half of the faces
+            build_mesh = CollisionMesh(
+                mesh.rest_positions(), mesh.edges(),
+                mesh.faces().topRows(mesh.num_faces() / 2));
+        }
+        SECTION("Broad phase") { broad_phase = std::make_shared<BruteForce>(); }
+
+        candidates.build(build_mesh, V, inflation_radius, broad_phase);
+
+        Candidates expected;
+        expected.build(
+            build_mesh, V, inflation_radius + safety_margin, broad_phase);
+        CHECK(
+            sorted(candidates.ee_candidates)
+            == sorted(expected.ee_candidates));
+        CHECK(
+            sorted(candidates.fv_candidates)
+            == sorted(expected.fv_candidates));
+    }
+
+    SECTION("Zero margin disables reuse")
+    {
+        candidates.set_safety_margin(0);
+        candidates.build(mesh, V, inflation_radius);
+
+        Candidates expected;
+        expected.build(mesh, V, inflation_radius);
+        CHECK(candidates.size() == expected.size());
+    }
+}
+
 TEST_CASE("Vertex-Vertex Candidate", "[candidates][vertex-vertex]")
 {
     CHECK(VertexVertexCandidate(0, 1) == VertexVertexCandidate(0, 1));
@@ -1,6 +1,7 @@
 #include <tests/config.hpp>
 #include <tests/utils.hpp>
 
+#include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/generators/catch_generators_adapters.hpp>
 #include <catch2/generators/catch_generators_random.hpp>
@@ -209,6 +210,121 @@ TEST_CASE("Degenerate tolerance", "[ccd]")
     CHECK(t0 == 1.0);
 }
 
+TEST_CASE("Batched CCD", "[ccd][batch]")
+{
+    constexpr int N = 100;
+    const double min_distance = GENERATE(0.0, 1e-3);
+    const bool is_edge_edge = GENERATE(true, false);
+
+    Eigen::MatrixXd V0 = Eigen::MatrixXd::Random(N, 12);
+    Eigen::MatrixXd V1 = V0 + 0.5 * Eigen::MatrixXd::Random(N, 12);
+    // Move half of the queries close together so some of them collide.
+    for (int i = 0; i < N / 2; i++) {
+        V0.block<1, 6>(i, 6) =
+            V0.block<1, 6>(i, 0) + 0.05 * Eigen::Matrix<double, 1, 6>::Random();
+    }
+
+    const TightInclusionCCD ccd;
+
+    // Reference: the per-pair queries with a shrinking tmax.
+    bool expected_is_impacting = false;
+    double expected_toi = 1.0;
+    for (int i = 0; i < N; i++) {
+        const Eigen::Matrix<double, 12, 1> x0 = V0.row(i), x1 = V1.row(i);
+        double toi;
+        bool is_impacting;
+        if (is_edge_edge) {
+            is_impacting = ccd.edge_edge_ccd(
+                x0.head<3>(), x0.segment<3>(3), x0.segment<3>(6), x0.tail<3>(),
+                x1.head<3>(), x1.segment<3>(3), x1.segment<3>(6), x1.tail<3>(),
+                toi, min_distance, expected_toi);
+        } else {
+            is_impacting = ccd.point_triangle_ccd(
+                x0.head<3>(), x0.segment<3>(3), x0.segment<3>(6), x0.tail<3>(),
+                x1.head<3>(), x1.segment<3>(3), x1.segment<3>(6), x1.tail<3>(),
+                toi, min_distance, expected_toi);
+        }
+        if (is_impacting) {
+            expected_is_impacting = true;
+            expected_toi = std::min(expected_toi, toi);
+        }
+    }
+
+    double toi;
+    const bool is_impacting = is_edge_edge
+        ? ccd.batch_edge_edge_ccd(V0, V1, toi, min_distance)
+        : ccd.batch_point_triangle_ccd(V0, V1, toi, min_distance);
+
+    CHECK(is_impacting == expected_is_impacting);
+    CHECK(toi == Catch::Approx(expected_toi).margin(1e-6));
+}
+
+TEST_CASE("Tight Inclusion prefilter", "[ccd][prefilter]")
+{
+    TightInclusionCCD ccd;
+    REQUIRE(ccd.use_prefilter);
+    ccd.reset_prefilter_statistics();
+
+    const Eigen::Vector3d ea0_t0(-1, 0, 0), ea1_t0(1, 0, 0);
+    const Eigen::Vector3d eb0_t0(0, 1, -1), eb1_t0(0, 1, 1);
+    double toi;
+
+    SECTION("Far apart slow edges are rejected")
+    {
+        // Moves 0.1 towards the other edge, which is at a distance of 1.
+        const Eigen::Vector3d dy(0, 0.1, 0);
+        CHECK(!ccd.edge_edge_ccd(
+            ea0_t0, ea1_t0, eb0_t0, eb1_t0, ea0_t0 + dy, ea1_t0 + dy, eb0_t0,
+            eb1_t0, toi));
+        CHECK(ccd.prefilter_statistics().num_queries == 1);
+        CHECK(ccd.prefilter_statistics().num_rejected == 1);
+    }
+
+    SECTION("Fast edges reach the root finder")
+    {
+        // Moves 2 towards the other edge and passes through it.
+        const Eigen::Vector3d dy(0, 2, 0);
+        CHECK(ccd.edge_edge_ccd(
+            ea0_t0, ea1_t0, eb0_t0, eb1_t0, ea0_t0 + dy, ea1_t0 + dy, eb0_t0,
+            eb1_t0, toi));
+        CHECK(toi <= 0.5);
+        CHECK(ccd.prefilter_statistics().num_queries == 1);
+        CHECK(ccd.prefilter_statistics().num_rejected == 0);
+    }
+
+    SECTION("Same results without the prefilter")
+    {
+        const double min_distance = GENERATE(0.0, 1e-3);
+        TightInclusionCCD exact_ccd;
+        exact_ccd.use_prefilter = false;
+
+        for (int i = 0; i < 100; i++) {
+            const Eigen::Matrix<double, 12, 1> x0 =
+                Eigen::Matrix<double, 12, 1>::Random();
+            const Eigen::Matrix<double, 12, 1> x1 =
+                x0 + 0.2 * Eigen::Matrix<double, 12, 1>::Random();
+
+            double expected_toi;
+            const bool expected_is_impacting = exact_ccd.point_triangle_ccd(
+                x0.head<3>(), x0.segment<3>(3), x0.segment<3>(6), x0.tail<3>(),
+                x1.head<3>(), x1.segment<3>(3), x1.segment<3>(6), x1.tail<3>(),
+                expected_toi, min_distance);
+            const bool is_impacting = ccd.point_triangle_ccd(
+                x0.head<3>(), x0.segment<3>(3), x0.segment<3>(6), x0.tail<3>(),
+                x1.head<3>(), x1.segment<3>(3), x1.segment<3>(6), x1.tail<3>(),
+                toi, min_distance);
+
+            CHECK(is_impacting == expected_is_impacting);
+            if (is_impacting && expected_is_impacting) {
+                CHECK(toi == expected_toi);
+            }
+        }
+
+        CHECK(ccd.prefilter_statistics().num_queries == 100);
+        CHECK(exact_ccd.prefilter_statistics().num_queries == 0);
+    }
+}
+
 TEST_CASE("Thick Cloth CCD", "[CCD][!benchmark]")
 {
     Eigen::MatrixXd V0, V1;
@@ -196,9 +196,8 @@ SmoothFrictionData smooth_friction_data_generator_3d()
         igl::edges(F, E);
 
         CollisionMesh mesh(V0, E, F);
-        collisions.collisions.push_back(
-            std::make_shared<SmoothCollisionTemplate<Face, Point3>>(
-                0, 0, PointTriangleDistanceType::P_T, mesh, param, dhat, V0));
+        collisions.emplace_back<Face, Point3>(
+            0, 0, PointTriangleDistanceType::P_T, mesh, param, dhat, V0);
     }
     SECTION("edge-edge")
     {
@@ -243,9 +242,8 @@ SmoothFrictionData smooth_friction_data_generator_3d()
         assert(e1 < E.rows());
 
         CollisionMesh mesh(V0, E, F);
-        collisions.collisions.push_back(
-            std::make_shared<SmoothCollisionTemplate<Edge3, Edge3>>(
-                e0, e1, EdgeEdgeDistanceType::EA_EB, mesh, param, dhat, V0));
+        collisions.emplace_back<Edge3, Edge3>(
+            e0, e1, EdgeEdgeDistanceType::EA_EB, mesh, param, dhat, V0);
     }
     SECTION("point-edge")
     {
@@ -279,9 +277,8 @@ SmoothFrictionData smooth_friction_data_generator_3d()
         assert(e < E.rows());
 
         CollisionMesh mesh(V0, E, F);
-        collisions.collisions.push_back(
-            std::make_shared<SmoothCollisionTemplate<Edge3, Point3>>(
-                e, 0, PointEdgeDistanceType::AUTO, mesh, param, dhat, V0));
+        collisions.emplace_back<Edge3, Point3>(
+            e, 0, PointEdgeDistanceType::AUTO, mesh, param, dhat, V0);
     }
     SECTION("point-point")
     {
@@ -304,9 +301,8 @@ SmoothFrictionData smooth_friction_data_generator_3d()
         igl::edges(F, E);
 
         CollisionMesh mesh(V0, E, F);
-        collisions.collisions.push_back(
-            std::make_shared<SmoothCollisionTemplate<Point3, Point3>>(
-                0, 1, PointPointDistanceType::AUTO, mesh, param, dhat, V0));
+        collisions.emplace_back<Point3, Point3>(
+            0, 1, PointPointDistanceType::AUTO, mesh, param, dhat, V0);
     }
 
     return data;
@@ -361,9 +357,8 @@ SmoothFrictionData smooth_friction_data_generator_2d()
         int e = 3;
 
         CollisionMesh mesh(V0, E, F);
-        collisions.collisions.push_back(
-            std::make_shared<SmoothCollisionTemplate<Edge2, Point2>>(
-                e, 0, PointEdgeDistanceType::AUTO, mesh, param, dhat, V0));
+        collisions.emplace_back<Edge2, Point2>(
+            e, 0, PointEdgeDistanceType::AUTO, mesh, param, dhat, V0);
     }
     SECTION("point-point 2D")
     {
@@ -384,9 +379,8 @@ SmoothFrictionData smooth_friction_data_generator_2d()
         E << 0, 2, 2, 3, 3, 0, 1, 5, 5, 4, 4, 1;
 
         CollisionMesh mesh(V0, E, F);
-        collisions.collisions.push_back(
-            std::make_shared<SmoothCollisionTemplate<Point2, Point2>>(
-                0, 1, PointPointDistanceType::AUTO, mesh, param, dhat, V0));
+        collisions.emplace_back<Point2, Point2>(
+            0, 1, PointPointDistanceType::AUTO, mesh, param, dhat, V0);
     }
 
     return data;
@@ -214,6 +214,13 @@ void check_friction_force_jacobian(
         D.gradient(tangential_collisions, mesh, velocities);
     CHECK(fd::compare_gradient(-force, grad_D));
 
+    // Accumulating into an existing vector adds the same force.
+    Eigen::VectorXd accumulated_force = force;
+    D.force(
+        tangential_collisions, mesh, X, Ut, velocities, BarrierPotential(dhat),
+        barrier_stiffness, accumulated_force);
+    CHECK(fd::compare_gradient(accumulated_force, 2 * force));
+
     ///////////////////////////////////////////////////////////////////////////
 
     Eigen::MatrixXd jac_force = D.force_jacobian(
@@ -422,48 +429,40 @@ void check_smooth_friction_force_jacobian(
         SmoothCollisions fd_collisions;
         assert(friction_collisions.size() == 1);
 
-        auto cc = friction_collisions[0].smooth_collision;
-        std::shared_ptr<SmoothCollision> fd_cc;
+        const SmoothCollision* cc =
+            friction_collisions[0].smooth_collision.get();
         if (dim == 3) {
             if (cc->type() == CollisionType::EdgeEdge)
-                fd_cc = std::make_shared<SmoothCollisionTemplate<Edge3, Edge3>>(
+                fd_collisions.emplace_back<Edge3, Edge3>(
                     (*cc)[0], (*cc)[1],
                     PrimitiveDistType<Edge3, Edge3>::type::AUTO, fd_mesh,
                     params, dhat, fd_lagged_positions);
             else if (cc->type() == CollisionType::EdgeVertex)
-                fd_cc =
-                    std::make_shared<SmoothCollisionTemplate<Edge3, Point3>>(
-                        (*cc)[0], (*cc)[1],
-                        PrimitiveDistType<Edge3, Point3>::type::AUTO, fd_mesh,
-                        params, dhat, fd_lagged_positions);
+                fd_collisions.emplace_back<Edge3, Point3>(
+                    (*cc)[0], (*cc)[1],
+                    PrimitiveDistType<Edge3, Point3>::type::AUTO, fd_mesh,
+                    params, dhat, fd_lagged_positions);
             else if (cc->type() == CollisionType::VertexVertex)
-                fd_cc =
-                    std::make_shared<SmoothCollisionTemplate<Point3, Point3>>(
-                        (*cc)[0], (*cc)[1],
-                        PrimitiveDistType<Point3, Point3>::type::AUTO, fd_mesh,
-                        params, dhat, fd_lagged_positions);
+                fd_collisions.emplace_back<Point3, Point3>(
+                    (*cc)[0], (*cc)[1],
+                    PrimitiveDistType<Point3, Point3>::type::AUTO, fd_mesh,
+                    params, dhat, fd_lagged_positions);
             else if (cc->type() == CollisionType::FaceVertex)
-                fd_cc = std::make_shared<SmoothCollisionTemplate<Face, Point3>>(
+                fd_collisions.emplace_back<Face, Point3>(
                     (*cc)[0], (*cc)[1],
                     PrimitiveDistType<Face, Point3>::type::AUTO, fd_mesh,
                     params, dhat, fd_lagged_positions);
-
-            fd_collisions.collisions.push_back(fd_cc);
         } else {
             if (cc->type() == CollisionType::EdgeVertex)
-                fd_cc =
-                    std::make_shared<SmoothCollisionTemplate<Edge2, Point2>>(
-                        (*cc)[0], (*cc)[1],
-                        PrimitiveDistType<Edge2, Point2>::type::AUTO, fd_mesh,
-                        params, dhat, fd_lagged_positions);
+                fd_collisions.emplace_back<Edge2, Point2>(
+                    (*cc)[0], (*cc)[1],
+                    PrimitiveDistType<Edge2, Point2>::type::AUTO, fd_mesh,
+                    params, dhat, fd_lagged_positions);
             else if (cc->type() == CollisionType::VertexVertex)
-                fd_cc =
-                    std::make_shared<SmoothCollisionTemplate<Point2, Point2>>(
-                        (*cc)[0], (*cc)[1],
-                        PrimitiveDistType<Point2, Point2>::type::AUTO, fd_mesh,
-                        params, dhat, fd_lagged_positions);
-
-            fd_collisions.collisions.push_back(fd_cc);
+                fd_collisions.emplace_back<Point2, Point2>(
+                    (*cc)[0], (*cc)[1],
+                    PrimitiveDistType<Point2, Point2>::type::AUTO, fd_mesh,
+                    params, dhat, fd_lagged_positions);
         }
 
         return fd_collisions;
@@ -632,4 +631,43 @@ TEST_CASE(
     check_smooth_friction_force_jacobian(
         mesh, Ut, U, collisions, mu, epsv_times_h, param, barrier_stiffness,
         false);
-}
\ No newline at end of file
+}
+TEST_CASE(
+    "Smooth friction collisions outlive their smooth collisions",
+    "[friction-smooth]")
+{
+    SmoothFrictionData data = smooth_friction_data_generator_2d();
+    const CollisionMesh mesh(data.V0, data.E, data.F);
+    REQUIRE(data.collisions.size() > 0);
+
+    TangentialCollisions friction_collisions;
+    friction_collisions.build_for_smooth_contact(
+        mesh, data.V0, data.collisions, data.p, data.barrier_stiffness,
+        Eigen::VectorXd::Ones(mesh.num_vertices()) * data.mu);
+    REQUIRE(friction_collisions.size() > 0);
+
+    std::vector<std::vector<index_t>> expected_vertex_ids;
+    std::vector<double> expected_potentials;
+    for (size_t i = 0; i < friction_collisions.size(); i++) {
+        const auto& cc = friction_collisions[i].smooth_collision;
+        REQUIRE(cc != nullptr);
+        expected_vertex_ids.push_back(cc->vertex_ids());
+        expected_potentials.push_back((*cc)(cc->dof(data.V0), data.p));
+    }
+
+    const auto check = [&]() {
+        for (size_t i = 0; i < friction_collisions.size(); i++) {
+            const auto& cc = friction_collisions[i].smooth_collision;
+            CHECK(cc->vertex_ids() == expected_vertex_ids[i]);
+            CHECK(
+                (*cc)(cc->dof(data.V0), data.p) == expected_potentials[i]);
+        }
+    };
+
+    // The data generator uses sections, so check both cases in sequence.
+    data.collisions.build(mesh, data.V1, data.p);
+    check();
+
+    data.collisions = SmoothCollisions();
+    check();
+}
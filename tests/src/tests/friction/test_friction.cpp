@@ -5,6 +5,8 @@
 #include <catch2/catch_approx.hpp>
 
 #include <ipc/collisions/tangential/tangential_collisions.hpp>
+#include <ipc/distance/point_edge.hpp>
+#include <ipc/distance/point_triangle.hpp>
 #include <ipc/potentials/friction_potential.hpp>
 #include <ipc/potentials/barrier_potential.hpp>
 #include <ipc/utils/logger.hpp>
@@ -247,3 +249,48 @@ TEST_CASE(
 
     CHECK(hess.isApprox(expected_hess));
 }
+
+TEST_CASE(
+    "Tangential collisions cache their distance type",
+    "[friction][collision][distance_type]")
+{
+    const Eigen::Vector3d t0(0, 0, 0), t1(1, 0, 0), t2(0, 1, 0);
+
+    Eigen::Vector3d p;
+    PointTriangleDistanceType expected_pt_dtype;
+    PointEdgeDistanceType expected_pe_dtype;
+    SECTION("interior")
+    {
+        p << 0.25, 0.25, 0.1;
+        expected_pt_dtype = PointTriangleDistanceType::P_T;
+        expected_pe_dtype = PointEdgeDistanceType::P_E;
+    }
+    SECTION("vertex")
+    {
+        p << -0.1, -0.2, 0.1;
+        expected_pt_dtype = PointTriangleDistanceType::P_T0;
+        expected_pe_dtype = PointEdgeDistanceType::P_E0;
+    }
+
+    const BarrierPotential barrier_potential(1.0);
+
+    Vector12d fv_positions;
+    fv_positions << p, t0, t1, t2;
+    const FaceVertexTangentialCollision fv(
+        FaceVertexNormalCollision(0, 0, 1, Eigen::SparseVector<double>()),
+        fv_positions, barrier_potential, 1.0);
+    CHECK(fv.dtype == expected_pt_dtype);
+    CHECK(
+        fv.compute_distance(fv_positions)
+        == Catch::Approx(point_triangle_distance(p, t0, t1, t2)));
+
+    Vector9d ev_positions;
+    ev_positions << p, t0, t1;
+    const EdgeVertexTangentialCollision ev(
+        EdgeVertexNormalCollision(0, 0, 1, Eigen::SparseVector<double>()),
+        ev_positions, barrier_potential, 1.0);
+    CHECK(ev.dtype == expected_pe_dtype);
+    CHECK(
+        ev.compute_distance(ev_positions)
+        == Catch::Approx(point_edge_distance(p, t0, t1)));
+}
@@ -126,6 +126,103 @@ TEST_CASE(
 
     REQUIRE(hess_b.squaredNorm() > 0);
     CHECK(fd::compare_hessian(hess_b, fhess_b, 1e-3));
+
+    // -------------------------------------------------------------------------
+    // Hessian-vector product
+    // -------------------------------------------------------------------------
+
+    const Eigen::VectorXd v = Eigen::VectorXd::Random(vertices.size());
+    const Eigen::VectorXd expected_hess_v = hess_b * v;
+
+    CHECK(
+        (barrier_potential.hessian_vector_product(
+             collisions, mesh, vertices, v)
+         - expected_hess_v)
+            .norm()
+        <= 1e-10 * std::max(1.0, expected_hess_v.norm()));
+
+    const auto local_hessians =
+        barrier_potential.local_hessians(collisions, mesh, vertices);
+    CHECK(
+        (barrier_potential.hessian_vector_product(
+             collisions, mesh, local_hessians, v)
+         - expected_hess_v)
+            .norm()
+        <= 1e-10 * std::max(1.0, expected_hess_v.norm()));
+}
+
+TEST_CASE(
+    "Barrier potential with packed collisions",
+    "[potential][barrier_potential][packed]")
+{
+    const bool use_area_weighting = GENERATE(true, false);
+    const bool use_improved_max_approximator = GENERATE(true, false);
+    const bool use_physical_barrier = GENERATE(true, false);
+
+    double dhat = -1;
+    std::string mesh_name = "";
+    SECTION("cube")
+    {
+        dhat = sqrt(2.0);
+        mesh_name = "cube.ply";
+    }
+    SECTION("two cubes close")
+    {
+        dhat = 1e-1;
+        mesh_name = "two-cubes-close.ply";
+    }
+
+    Eigen::MatrixXd vertices;
+    Eigen::MatrixXi edges, faces;
+    bool success = tests::load_mesh(mesh_name, vertices, edges, faces);
+    CAPTURE(mesh_name);
+    REQUIRE(success);
+
+    const CollisionMesh mesh =
+        CollisionMesh::build_from_full_mesh(vertices, edges, faces);
+    vertices = mesh.vertices(vertices);
+
+    NormalCollisions collisions;
+    collisions.set_use_area_weighting(use_area_weighting);
+    collisions.set_use_improved_max_approximator(use_improved_max_approximator);
+    collisions.build(mesh, vertices, dhat);
+    // Plane-vertex collisions are evaluated through the virtual interface.
+    collisions.pv_collisions.emplace_back(
+        vertices.row(0).transpose() - Eigen::Vector3d(0, 0, 0.5 * dhat),
+        Eigen::Vector3d::UnitZ(), 0);
+    CHECK(collisions.size() > 1);
+
+    const PackedNormalCollisions packed(collisions, mesh);
+    REQUIRE(packed.size() == collisions.size());
+    for (size_t i = 0; i < collisions.size(); i++) {
+        CHECK(
+            packed.vertex_ids(i)
+            == collisions[i].vertex_ids(mesh.edges(), mesh.faces()));
+        CHECK(packed.num_vertices(i) == collisions[i].num_vertices());
+    }
+
+    BarrierPotential barrier_potential(dhat, use_physical_barrier);
+
+    const double b = barrier_potential(collisions, mesh, vertices);
+    CHECK(
+        barrier_potential(packed, mesh, vertices)
+        == Catch::Approx(b).epsilon(1e-12));
+
+    const Eigen::VectorXd grad_b =
+        barrier_potential.gradient(collisions, mesh, vertices);
+    CHECK(
+        (barrier_potential.gradient(packed, mesh, vertices) - grad_b).norm()
+        <= 1e-12 * std::max(1.0, grad_b.norm()));
+
+    const PSDProjectionMethod project_to_psd =
+        GENERATE(PSDProjectionMethod::NONE, PSDProjectionMethod::CLAMP);
+    const Eigen::SparseMatrix<double> hess_b =
+        barrier_potential.hessian(collisions, mesh, vertices, project_to_psd);
+    CHECK(
+        (barrier_potential.hessian(packed, mesh, vertices, project_to_psd)
+         - hess_b)
+            .norm()
+        <= 1e-12 * std::max(1.0, hess_b.norm()));
 }
 
 TEST_CASE(
@@ -7,9 +7,11 @@
 
 #include <ipc/potentials/barrier_potential.hpp>
 #include <ipc/smooth_contact/smooth_contact_potential.hpp>
+#include <ipc/smooth_contact/primitives/point3.hpp>
 #include <ipc/distance/line_line.hpp>
 
 #include <finitediff.hpp>
+#include <igl/PI.h>
 #include <igl/edges.h>
 #include <igl/readCSV.h>
 #include <ipc/ipc.hpp>
@@ -230,6 +232,63 @@ TEST_CASE("Smooth barrier potential full gradient and hessian 3D", tagsopt)
               << (hess_b - fhess_b).norm() / hess_b.norm() << ", norms "
               << hess_b.norm() << " " << fhess_b.norm() << "\n";
     CHECK((hess_b - fhess_b).norm() / hess_b.norm() < 1e-5);
+
+    // -------------------------------------------------------------------------
+    // Hessian-vector product
+    // -------------------------------------------------------------------------
+
+    const Eigen::VectorXd v = Eigen::VectorXd::Random(vertices.size());
+    const Eigen::VectorXd expected_hess_v = hess_b * v;
+
+    CHECK(
+        (potential.hessian_vector_product(collisions, mesh, vertices, v)
+         - expected_hess_v)
+            .norm()
+        <= 1e-10 * std::max(1.0, expected_hess_v.norm()));
+
+    const std::vector<Eigen::MatrixXd> local_hessians =
+        potential.local_hessians(collisions, mesh, vertices);
+    CHECK(
+        (potential.hessian_vector_product(collisions, mesh, local_hessians, v)
+         - expected_hess_v)
+            .norm()
+        <= 1e-10 * std::max(1.0, expected_hess_v.norm()));
+}
+
+TEST_CASE("Incremental adaptive dhat", "[smooth_potential]")
+{
+    Eigen::MatrixXd vertices;
+    Eigen::MatrixXi edges, faces;
+    REQUIRE(tests::load_mesh("two-cubes-close.ply", vertices, edges, faces));
+    const CollisionMesh mesh =
+        CollisionMesh::build_from_full_mesh(vertices, edges, faces);
+    vertices = mesh.vertices(vertices);
+
+    ParameterType param(1e-1, 0.85, 0.5, 0.95, 0.6, 2);
+    param.set_adaptive_dhat_ratio(1.5);
+
+    SmoothCollisions expected;
+    expected.compute_adaptive_dhat(mesh, vertices, param);
+    const Candidates& candidates = expected.candidates;
+    REQUIRE(candidates.size() > 0);
+
+    // Split the candidates in two halves and add them one after the other.
+    Candidates first, second;
+    const auto split = [](const auto& all, auto& a, auto& b) {
+        a.assign(all.begin(), all.begin() + all.size() / 2);
+        b.assign(all.begin() + all.size() / 2, all.end());
+    };
+    split(candidates.ev_candidates, first.ev_candidates, second.ev_candidates);
+    split(candidates.ee_candidates, first.ee_candidates, second.ee_candidates);
+    split(candidates.fv_candidates, first.fv_candidates, second.fv_candidates);
+
+    SmoothCollisions collisions;
+    collisions.update_adaptive_dhat(first, mesh, vertices, param);
+    collisions.update_adaptive_dhat(second, mesh, vertices, param);
+
+    CHECK(collisions.vert_adaptive_dhat == expected.vert_adaptive_dhat);
+    CHECK(collisions.edge_adaptive_dhat == expected.edge_adaptive_dhat);
+    CHECK(collisions.face_adaptive_dhat == expected.face_adaptive_dhat);
 }
 
 TEST_CASE("Smooth barrier potential real sim 2D C^2", "[smooth_potential]")
@@ -476,6 +535,55 @@ TEST_CASE("Smooth barrier potential real sim 2D C^1", "[smooth_potential]")
 //     }
 // }
 
+TEST_CASE(
+    "Smooth point3 term with fixed valence", "[smooth_potential][point3]")
+{
+    const int n = GENERATE(4, 5, 6, 7, 8);
+    CAPTURE(n);
+
+    // A cone fan around vertex 0 with a slightly irregular ring of n vertices
+    Eigen::MatrixXd vertices(n + 1, 3);
+    Eigen::MatrixXi faces(n, 3);
+    vertices.row(0).setZero();
+    for (int i = 0; i < n; i++) {
+        const double theta = 2 * igl::PI * (i + 0.1 * (i % 2)) / n;
+        const double r = 1 + 0.05 * i;
+        vertices.row(i + 1) << r * cos(theta), r * sin(theta), -0.3;
+        faces.row(i) << 0, i + 1, (i + 1) % n + 1;
+    }
+    Eigen::MatrixXi edges;
+    igl::edges(faces, edges);
+
+    const CollisionMesh mesh(vertices, edges, faces);
+    const ParameterType param(1e-1, 0.8, 0, 1, 0, 2);
+    const Eigen::Vector3d d(0.2, -0.1, 1);
+
+    const Point3 point(0, mesh, vertices, d, param);
+    REQUIRE(point.n_vertices() == n + 1);
+
+    const RowVector3<double> direc = d.transpose();
+    Eigen::Matrix<double, -1, 3> X(n + 1, 3);
+    for (int i = 0; i <= n; i++)
+        X.row(i) = vertices.row(point.vertex_ids()[i]);
+
+    const auto [value, grad] =
+        point.smooth_point3_term_gradient(direc, X, param);
+    const auto [expected_value, expected_grad] =
+        point.term_gradient<-1>(direc, X, param);
+    CHECK(value == Catch::Approx(expected_value));
+    CHECK((grad - expected_grad).norm() <= 1e-12 * expected_grad.norm());
+
+    const auto [hess_value, hess_grad, hess] =
+        point.smooth_point3_term_hessian(direc, X, param);
+    const auto [expected_hess_value, expected_hess_grad, expected_hess] =
+        point.term_hessian<-1>(direc, X, param);
+    CHECK(hess_value == Catch::Approx(expected_hess_value));
+    CHECK(
+        (hess_grad - expected_hess_grad).norm()
+        <= 1e-12 * expected_hess_grad.norm());
+    CHECK((hess - expected_hess).norm() <= 1e-12 * expected_hess.norm());
+}
+
 TEST_CASE("Benchmark autogen code", "[!benchmark]")
 {
     ipc::Vector3d ea0, ea1, eb0, eb1;
@@ -1,8 +1,11 @@
 #include <tests/utils.hpp>
 
+#include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
 
 #include <ipc/ipc.hpp>
+#include <ipc/candidates/candidates.hpp>
 
 using namespace ipc;
 
@@ -17,4 +20,34 @@ TEST_CASE("Is step collision free", "[is_step_collision_free]")
 
     CHECK(is_step_collision_free(mesh, V0, V0));
     CHECK(!is_step_collision_free(mesh, V0, V1));
-}
\ No newline at end of file
+}
+TEST_CASE("Streamed collision free stepsize", "[collision_free_stepsize]")
+{
+    Eigen::MatrixXd V0, V1;
+    Eigen::MatrixXi E, F;
+    REQUIRE(tests::load_mesh("two-cubes-close.ply", V0, E, F));
+    REQUIRE(tests::load_mesh("two-cubes-intersecting.ply", V1, E, F));
+
+    CollisionMesh mesh(V0, E, F);
+
+    const double min_distance = GENERATE(0.0, 1e-3);
+    const auto broad_phase = GENERATE(tests::BroadPhaseGenerator::create());
+    CAPTURE(min_distance, broad_phase->name());
+
+    // The candidates are streamed from the broad phase to the narrow phase.
+    const double stepsize = compute_collision_free_stepsize(
+        mesh, V0, V1, min_distance, broad_phase);
+
+    // All candidates are built before the narrow phase.
+    Candidates candidates;
+    candidates.build(mesh, V0, V1, 0.5 * min_distance, broad_phase);
+    const double expected_stepsize = candidates.compute_collision_free_stepsize(
+        mesh, V0, V1, min_distance);
+
+    // Tight Inclusion's time of impact depends on tmax, which shrinks in a
+    // different order when the candidates are streamed.
+    CHECK(stepsize < 1);
+    CHECK(stepsize == Catch::Approx(expected_stepsize).epsilon(1e-3));
+    CHECK(is_step_collision_free(
+        mesh, V0, V0 + stepsize * (V1 - V0), min_distance, broad_phase));
+}
@@ -1,4 +1,5 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
 
 #include <ipc/candidates/vertex_vertex.hpp>
 #include <ipc/candidates/edge_vertex.hpp>
@@ -6,7 +7,10 @@
 #include <ipc/candidates/face_vertex.hpp>
 #include <ipc/candidates/edge_face.hpp>
 #include <ipc/utils/logger.hpp>
+#include <ipc/utils/block_sparse_matrix.hpp>
 #include <ipc/utils/eigen_ext.hpp>
+#include <ipc/utils/hessian_assembler.hpp>
+#include <ipc/utils/local_to_global.hpp>
 #include <ipc/utils/save_obj.hpp>
 
 #include <spdlog/sinks/stdout_color_sinks.h>
@@ -118,4 +122,170 @@ TEST_CASE("Save OBJ of candidates", "[utils][save_obj]")
             ss.str()
             == "o EF\nv 1 0 0\nv 0 1 0\nv 1 0 0\nv 0 1 0\nv 0 0 1\nl 1 2\nf 3 4 5\n");
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Local thread vector storage", "[utils][local_to_global]")
+{
+    const int dim = 3, ndof = 30;
+    const size_t max_nonzeros = GENERATE(size_t(6), size_t(ndof));
+
+    ipc::LocalThreadVecStorage storage(ndof, max_nonzeros);
+    CHECK(storage.is_sparse() == (max_nonzeros < 0.25 * ndof));
+
+    const Eigen::VectorXd local_grad = Eigen::VectorXd::Random(2 * dim);
+    const std::array<int, 2> ids = { { 7, 2 } };
+    ipc::local_gradient_to_global_gradient(local_grad, ids, dim, storage);
+
+    Eigen::VectorXd expected = Eigen::VectorXd::Zero(ndof);
+    ipc::local_gradient_to_global_gradient(local_grad, ids, dim, expected);
+
+    Eigen::VectorXd grad = Eigen::VectorXd::Zero(ndof);
+    storage.add_to(grad);
+    CHECK(grad == expected);
+}
+
+TEST_CASE("Hessian assembler", "[utils][local_to_global]")
+{
+    const int dim = GENERATE(2, 3);
+    const int num_vertices = 20;
+    const std::vector<std::array<int, 3>> elements = {
+        { { 0, 1, 2 } }, { { 2, 3, 4 } }, { { 4, 0, 5 } },
+        { { 6, 7, 8 } }, { { 1, 7, 19 } }, { { 2, 1, 0 } },
+    };
+
+    std::vector<Eigen::MatrixXd> local_hessians;
+    for (size_t i = 0; i < elements.size(); i++) {
+        local_hessians.push_back(Eigen::MatrixXd::Random(3 * dim, 3 * dim));
+    }
+
+    ipc::HessianAssembler assembler;
+    assembler.init(
+        elements.size(), num_vertices, dim,
+        [&](size_t i) { return elements[i]; }, [](size_t) { return 3; });
+    // Elements sharing a vertex must have different colors.
+    CHECK(assembler.num_colors() >= 3);
+
+    const Eigen::SparseMatrix<double> hess =
+        assembler.assemble([&](size_t i) { return local_hessians[i]; });
+
+    std::vector<Eigen::Triplet<double>> triplets;
+    for (size_t i = 0; i < elements.size(); i++) {
+        ipc::local_hessian_to_global_triplets(
+            local_hessians[i], elements[i], dim, triplets);
+    }
+    Eigen::SparseMatrix<double> expected(
+        dim * num_vertices, dim * num_vertices);
+    expected.setFromTriplets(triplets.begin(), triplets.end());
+
+    CHECK(hess.nonZeros() == expected.nonZeros());
+    CHECK((Eigen::MatrixXd(hess) - Eigen::MatrixXd(expected)).norm() < 1e-12);
+}
+
+TEST_CASE("Hessian assembler pattern reuse", "[utils][local_to_global]")
+{
+    const int dim = 3, num_vertices = 4;
+    std::vector<std::array<int, 2>> elements = { { { 0, 1 } }, { { 1, 2 } } };
+    const Eigen::MatrixXd local_hessian = Eigen::MatrixXd::Ones(6, 6);
+
+    const auto update = [&](ipc::HessianAssembler& assembler) {
+        return assembler.update(
+            elements.size(), num_vertices, dim,
+            [&](size_t i) { return elements[i]; }, [](size_t) { return 2; });
+    };
+    const auto local_hessian_fn = [&](size_t) { return local_hessian; };
+
+    ipc::HessianAssembler assembler;
+    Eigen::SparseMatrix<double> hess;
+    CHECK(update(assembler));
+    assembler.assemble(local_hessian_fn, hess);
+    const double* values = hess.valuePtr();
+
+    // Same elements
+    CHECK(!update(assembler));
+    assembler.assemble(local_hessian_fn, hess);
+    CHECK(hess.valuePtr() == values);
+
+    // Same pattern from reordered elements
+    std::swap(elements[0], elements[1]);
+    CHECK(!update(assembler));
+    assembler.assemble(local_hessian_fn, hess);
+    CHECK(hess.sum() == 72);
+
+    // New pattern
+    elements[1] = { { 2, 3 } };
+    CHECK(update(assembler));
+    assembler.assemble(local_hessian_fn, hess);
+    CHECK(size_t(hess.nonZeros()) == assembler.nnz());
+}
+
+TEST_CASE("Hessian assembler zero blocks", "[utils][local_to_global]")
+{
+    const int dim = 3, num_vertices = 11;
+    // A star of elements around a high-valence vertex.
+    std::vector<std::array<int, 2>> elements;
+    for (int i = 1; i < num_vertices; i++) {
+        elements.push_back({ { 0, i } });
+    }
+
+    ipc::HessianAssembler assembler;
+    assembler.init(
+        elements.size(), num_vertices, dim,
+        [&](size_t i) { return elements[i]; }, [](size_t) { return 2; });
+    CHECK(assembler.num_colors() == elements.size());
+    CHECK(assembler.nnz() == dim * dim * (3 * elements.size() + 1));
+
+    // Only the first element has a nonzero Hessian.
+    const auto local_hessian_fn = [&](size_t i) -> Eigen::MatrixXd {
+        return Eigen::MatrixXd::Constant(2 * dim, 2 * dim, i == 0 ? 1 : 0);
+    };
+
+    // Exact zeros are pruned when assembling a new matrix...
+    const Eigen::SparseMatrix<double> pruned =
+        assembler.assemble(local_hessian_fn);
+    CHECK(pruned.nonZeros() == 4 * dim * dim);
+    CHECK(pruned.sum() == 4 * dim * dim);
+
+    // ...but kept when assembling into the full pattern.
+    Eigen::SparseMatrix<double> hess;
+    assembler.assemble(local_hessian_fn, hess);
+    CHECK(size_t(hess.nonZeros()) == assembler.nnz());
+    CHECK((Eigen::MatrixXd(hess) - Eigen::MatrixXd(pruned)).norm() == 0);
+}
+
+TEST_CASE("Block sparse Hessian", "[utils][local_to_global]")
+{
+    const int dim = GENERATE(2, 3);
+    const int num_vertices = 10;
+    const std::vector<std::array<int, 3>> elements = {
+        { { 0, 1, 2 } }, { { 2, 3, 4 } }, { { 9, 0, 5 } }, { { 1, 7, 8 } },
+    };
+
+    std::vector<Eigen::MatrixXd> local_hessians;
+    for (size_t i = 0; i < elements.size(); i++) {
+        local_hessians.push_back(Eigen::MatrixXd::Random(3 * dim, 3 * dim));
+    }
+
+    ipc::HessianAssembler assembler;
+    assembler.init(
+        elements.size(), num_vertices, dim,
+        [&](size_t i) { return elements[i]; }, [](size_t) { return 3; });
+
+    const auto local_hessian_fn = [&](size_t i) { return local_hessians[i]; };
+    const Eigen::MatrixXd expected =
+        Eigen::MatrixXd(assembler.assemble(local_hessian_fn));
+
+    const ipc::BlockSparseMatrix hess =
+        assembler.assemble_blocks(local_hessian_fn);
+    CHECK(hess.dim() == dim);
+    CHECK(hess.rows() == dim * num_vertices);
+    CHECK(hess.num_blocks() * dim * dim == assembler.nnz());
+    CHECK((Eigen::MatrixXd(hess.to_sparse()) - expected).norm() < 1e-12);
+
+    const Eigen::VectorXd x = Eigen::VectorXd::Random(dim * num_vertices);
+    CHECK((hess * x - expected * x).norm() < 1e-12);
+
+    const ipc::BlockSparseMatrix converted(
+        assembler.assemble(local_hessian_fn), dim);
+    CHECK(converted.num_blocks() == hess.num_blocks());
+    CHECK((Eigen::MatrixXd(converted.to_sparse()) - expected).norm() < 1e-12);
+}